@@ -590,6 +590,7 @@ public class CGenerator : BaseGenerator
                 builder.AppendLine($"uint32_t array_length_{depth};");
                 builder.AppendLine($"result = bebop_reader_read_uint32(reader, &array_length_{depth});");
                 builder.AppendLine("if (result != BEBOP_OK) return result;");
+                AppendLengthCheck(builder, $"array_length_{depth}", GetMinimalElementSize(at.MemberType));
 
                 if (needsConstCast)
                 {
@@ -669,6 +670,8 @@ public class CGenerator : BaseGenerator
                 builder.AppendLine($"uint32_t map_length_{depth};");
                 builder.AppendLine($"result = bebop_reader_read_uint32(reader, &map_length_{depth});");
                 builder.AppendLine("if (result != BEBOP_OK) return result;");
+                AppendLengthCheck(builder, $"map_length_{depth}",
+                    GetMinimalElementSize(mt.KeyType) + GetMinimalElementSize(mt.ValueType));
 
                 if (needsConstCast)
                 {
@@ -2089,6 +2092,26 @@ public class CGenerator : BaseGenerator
         };
     }
 
+    /// <summary>
+    /// Rejects an element count that the remaining input cannot possibly hold, before it is used to size an
+    /// arena allocation.
+    /// </summary>
+    private static void AppendLengthCheck(IndentedStringBuilder builder, string lengthVariable, int minimalElementSize)
+    {
+        if (minimalElementSize == 0)
+        {
+            return;
+        }
+        builder.AppendLine($"if ((size_t)(reader->end - reader->current) / {minimalElementSize} < {lengthVariable}) return BEBOP_ERROR_MALFORMED_PACKET;");
+    }
+
+    private int GetMinimalElementSize(TypeBase type)
+    {
+        return type is DefinedType dt && Schema.Definitions[dt.Name] is RecordDefinition rd
+            ? GetMinimalEncodedSize(rd)
+            : GetMinimalEncodedSize(type);
+    }
+
     private int GetMinimalEncodedSize(RecordDefinition definition)
     {
         return definition switch
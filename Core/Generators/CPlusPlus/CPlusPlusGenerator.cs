@@ -11,6 +11,7 @@ using System.Threading;
 using System.Threading.Tasks;
 using Core.Meta;
 using Core.Meta.Extensions;
+using Core.Parser;
 
 namespace Core.Generators.CPlusPlus
 {
@@ -72,10 +73,21 @@ namespace Core.Generators.CPlusPlus
         private string CompileEncodeStruct(StructDefinition definition)
         {
             var builder = new IndentedStringBuilder(4);
+            if (IsPackable(definition))
+            {
+                builder.AppendLine("#if BEBOP_ASSUME_LITTLE_ENDIAN");
+                builder.AppendLine($"const auto packed = {definition.Name}::pack(message);");
+                builder.AppendLine("writer.writeRaw(reinterpret_cast<const uint8_t*>(&packed), sizeof(packed));");
+                builder.AppendLine("#else");
+            }
             foreach (var field in definition.Fields)
             {
                 builder.AppendLine(CompileEncodeField(field.Type, $"message.{field.Name}"));
             }
+            if (IsPackable(definition))
+            {
+                builder.AppendLine("#endif");
+            }
             return builder.ToString();
         }
 
@@ -108,6 +120,8 @@ namespace Core.Generators.CPlusPlus
             return type switch
             {
                 ArrayType at when at.IsBytes() => $"writer.writeBytes({target});",
+                ArrayType at when IsPackable(at.MemberType) => $"writer.writePackedArray({target});",
+                ArrayType at when at.MemberType.IsFixedScalar() || at.MemberType.IsEnum(Schema) => $"writer.writeScalarArray({target});",
                 ArrayType at =>
                     $"{{" + nl +
                     $"{tab}const auto length{depth} = {target}.size();" + nl +
@@ -116,6 +130,12 @@ namespace Core.Generators.CPlusPlus
                     $"{tab}{tab}{CompileEncodeField(at.MemberType, i, depth + 1, indentDepth + 2)}" + nl +
                     $"{tab}}}" + nl +
                     $"}}",
+                MapType mt when MapContainer == "unordered" =>
+                    $"writer.writeUint32({target}.size());" + nl +
+                    $"for (const auto* e{depth} : ::bebop::sortedEntries({target})) {{" + nl +
+                    $"{tab}{CompileEncodeField(mt.KeyType, $"e{depth}->first", depth + 1, indentDepth + 1)}" + nl +
+                    $"{tab}{CompileEncodeField(mt.ValueType, $"e{depth}->second", depth + 1, indentDepth + 1)}" + nl +
+                    $"}}",
                 MapType mt =>
                     $"writer.writeUint32({target}.size());" + nl +
                     $"for (const auto& e{depth} : {target}) {{" + nl +
@@ -146,6 +166,212 @@ namespace Core.Generators.CPlusPlus
             };
         }
 
+        /// <summary>
+        /// Get the encoded size of the given <see cref="TypeBase"/> if every value of it encodes to the same number of bytes.
+        /// </summary>
+        /// <param name="type">The type to measure.</param>
+        /// <returns>The fixed encoded size in bytes, or null if the size depends on the value.</returns>
+        private int? FixedEncodedSize(TypeBase type)
+        {
+            return type switch
+            {
+                ScalarType st when st.IsFixedScalar() => st.BaseType.Size(),
+                DefinedType dt when Schema.Definitions[dt.Name] is EnumDefinition ed => ed.BaseType.Size(),
+                DefinedType dt when Schema.Definitions[dt.Name] is StructDefinition sd && sd.IsFixedSize(Schema) => sd.MinimalEncodedSize(Schema),
+                _ => null,
+            };
+        }
+
+        /// <summary>
+        /// Get the largest encoded size of the given <see cref="TypeBase"/> if no value of it can encode to more bytes.
+        /// </summary>
+        /// <param name="type">The type to measure.</param>
+        /// <returns>The bound in bytes, or null if strings, arrays, maps or recursion let the size grow without limit.</returns>
+        private int? MaxEncodedSize(TypeBase type)
+        {
+            return type switch
+            {
+                _ when FixedEncodedSize(type) is { } size => size,
+                DefinedType dt when Schema.Definitions[dt.Name] is RecordDefinition rd => MaxEncodedSize(rd),
+                _ => null,
+            };
+        }
+
+        /// <summary>
+        /// Get the largest encoded size of the given <see cref="RecordDefinition"/>, or null if it has none.
+        /// </summary>
+        /// <param name="definition">The record to measure.</param>
+        /// <param name="enclosing">The records being measured further up, which a recursive record refers back to.</param>
+        private int? MaxEncodedSize(RecordDefinition definition, HashSet<string>? enclosing = null)
+        {
+            enclosing ??= new HashSet<string>();
+            if (!enclosing.Add(definition.Name))
+            {
+                return null;
+            }
+            int? FieldBound(TypeBase type) => type is DefinedType dt && Schema.Definitions[dt.Name] is RecordDefinition rd
+                ? MaxEncodedSize(rd, enclosing)
+                : MaxEncodedSize(type);
+            int? bound = 0;
+            switch (definition)
+            {
+                case MessageDefinition md:
+                    bound = md.MinimalEncodedSize(Schema);
+                    foreach (var field in md.Fields.Where(f => f.DeprecatedDecorator == null))
+                    {
+                        bound += 1 + FieldBound(field.Type);
+                    }
+                    break;
+                case StructDefinition sd:
+                    foreach (var field in sd.Fields)
+                    {
+                        bound += FieldBound(field.Type);
+                    }
+                    break;
+                case UnionDefinition ud:
+                    foreach (var branch in ud.Branches)
+                    {
+                        var size = MaxEncodedSize(branch.Definition, enclosing);
+                        bound = size is null ? null : Math.Max(bound ?? 0, size.Value);
+                        if (bound is null) break;
+                    }
+                    bound += 4 + 1;
+                    break;
+            }
+            enclosing.Remove(definition.Name);
+            return bound;
+        }
+
+        /// <summary>
+        /// Generate the body of the <c>maxEncodedSize</c> function for a <see cref="RecordDefinition"/> whose size has no bound.
+        /// Fields that do have one are counted as present at their largest size, so only the others are inspected.
+        /// </summary>
+        /// <param name="definition">The definition to generate code for.</param>
+        /// <returns>The generated CPlusPlus <c>maxEncodedSize</c> function body.</returns>
+        public string CompileMaxEncodedSize(RecordDefinition definition)
+        {
+            var builder = new IndentedStringBuilder(4);
+            switch (definition)
+            {
+                case MessageDefinition md:
+                    var fields = md.Fields.Where(f => f.DeprecatedDecorator == null).ToList();
+                    var bounded = fields.Sum(f => MaxEncodedSize(f.Type) is { } size ? 1 + size : 0);
+                    builder.AppendLine($"size_t byteCount = {md.MinimalEncodedSize(Schema) + bounded};");
+                    foreach (var field in fields.Where(f => MaxEncodedSize(f.Type) is null))
+                    {
+                        builder.AppendLine($"if (message.{field.Name}.has_value()) {{");
+                        builder.AppendLine($"  byteCount += 1;");
+                        builder.AppendLine($"  {CompileSizeAssignment(field.Type, $"message.{field.Name}.value()", 0, 1, false)}");
+                        builder.AppendLine("}");
+                    }
+                    break;
+                case StructDefinition sd:
+                    builder.AppendLine($"size_t byteCount = {sd.Fields.Sum(f => MaxEncodedSize(f.Type) ?? 0)};");
+                    foreach (var field in sd.Fields.Where(f => MaxEncodedSize(f.Type) is null))
+                    {
+                        builder.AppendLine(CompileSizeAssignment(field.Type, $"message.{field.Name}", 0, 0, false));
+                    }
+                    break;
+                case UnionDefinition ud:
+                    builder.AppendLine("size_t byteCount = 4 + 1;");
+                    builder.AppendLine("switch (message.variant.index()) {");
+                    var i = 0;
+                    foreach (var branch in ud.Branches)
+                    {
+                        builder.AppendLine($"  case {i}:");
+                        builder.AppendLine($"    byteCount += {branch.Definition.Name}::maxEncodedSize(std::get<{i++}>(message.variant));");
+                        builder.AppendLine("    break;");
+                    }
+                    builder.AppendLine("}");
+                    break;
+                default:
+                    throw new InvalidOperationException($"invalid CompileMaxEncodedSize kind: {definition}");
+            }
+            builder.AppendLine("return byteCount;");
+            return builder.ToString();
+        }
+
+        /// <summary>
+        /// Generate the body of the <c>encodedSize</c> function for the given <see cref="RecordDefinition"/>.
+        /// </summary>
+        /// <param name="definition">The definition to generate code for.</param>
+        /// <returns>The generated CPlusPlus <c>encodedSize</c> function body.</returns>
+        public string CompileEncodedSize(RecordDefinition definition)
+        {
+            var builder = new IndentedStringBuilder(4);
+            switch (definition)
+            {
+                case MessageDefinition md:
+                    builder.AppendLine($"size_t byteCount = {md.MinimalEncodedSize(Schema)};");
+                    foreach (var field in md.Fields)
+                    {
+                        if (field.DeprecatedDecorator != null)
+                        {
+                            continue;
+                        }
+                        builder.AppendLine($"if (message.{field.Name}.has_value()) {{");
+                        builder.AppendLine($"  byteCount += 1;");
+                        builder.AppendLine($"  {CompileSizeAssignment(field.Type, $"message.{field.Name}.value()", 0, 1)}");
+                        builder.AppendLine("}");
+                    }
+                    break;
+                case StructDefinition sd:
+                    builder.AppendLine("size_t byteCount = 0;");
+                    foreach (var field in sd.Fields)
+                    {
+                        builder.AppendLine(CompileSizeAssignment(field.Type, $"message.{field.Name}"));
+                    }
+                    break;
+                case UnionDefinition ud:
+                    builder.AppendLine("size_t byteCount = 4 + 1;");
+                    builder.AppendLine("switch (message.variant.index()) {");
+                    var i = 0;
+                    foreach (var branch in ud.Branches)
+                    {
+                        builder.AppendLine($"  case {i}:");
+                        builder.AppendLine($"    byteCount += {branch.Definition.Name}::encodedSize(std::get<{i++}>(message.variant));");
+                        builder.AppendLine("    break;");
+                    }
+                    builder.AppendLine("}");
+                    break;
+                default:
+                    throw new InvalidOperationException($"invalid CompileEncodedSize kind: {definition}");
+            }
+            builder.AppendLine("return byteCount;");
+            return builder.ToString();
+        }
+
+        /// <param name="isAccurate">Whether to count the exact size, or the cheaper upper bound that <c>maxEncodedSize</c> returns.</param>
+        private string CompileSizeAssignment(TypeBase type, string target, int depth = 0, int indentDepth = 0, bool isAccurate = true)
+        {
+            var tab = new string(' ', indentStep);
+            var nl = "\n" + new string(' ', indentDepth * indentStep);
+            var i = GeneratorUtils.LoopVariable(depth);
+            int? Bound(TypeBase t) => isAccurate ? FixedEncodedSize(t) : MaxEncodedSize(t);
+            return type switch
+            {
+                _ when Bound(type) is { } size => $"byteCount += {size};",
+                ScalarType st when st.BaseType == BaseType.String => $"byteCount += 4 + {target}.size();",
+                ArrayType at when at.IsBytes() => $"byteCount += 4 + {target}.size();",
+                ArrayType at when Bound(at.MemberType) is { } size => $"byteCount += 4 + {target}.size() * {size};",
+                ArrayType at =>
+                    $"byteCount += 4;" + nl +
+                    $"for (const auto& {i} : {target}) {{" + nl +
+                    $"{tab}{CompileSizeAssignment(at.MemberType, i, depth + 1, indentDepth + 1, isAccurate)}" + nl +
+                    $"}}",
+                MapType mt when Bound(mt.KeyType) is { } keySize && Bound(mt.ValueType) is { } valueSize =>
+                    $"byteCount += 4 + {target}.size() * {keySize + valueSize};",
+                MapType mt =>
+                    $"byteCount += 4;" + nl +
+                    $"for (const auto& e{depth} : {target}) {{" + nl +
+                    $"{tab}{CompileSizeAssignment(mt.KeyType, $"e{depth}.first", depth + 1, indentDepth + 1, isAccurate)}" + nl +
+                    $"{tab}{CompileSizeAssignment(mt.ValueType, $"e{depth}.second", depth + 1, indentDepth + 1, isAccurate)}" + nl +
+                    $"}}",
+                DefinedType dt => $"byteCount += {dt.Name}::{(isAccurate ? "encodedSize" : "maxEncodedSize")}({target});",
+                _ => throw new InvalidOperationException($"CompileSizeAssignment: {type}")
+            };
+        }
+
         /// <summary>
         /// Generate the body of the <c>decode</c> function for the given <see cref="RecordDefinition"/>.
         /// </summary>
@@ -170,24 +396,73 @@ namespace Core.Generators.CPlusPlus
         private string CompileDecodeMessage(MessageDefinition definition)
         {
             var builder = new IndentedStringBuilder(4);
+            if (ReuseStorage)
+            {
+                return CompileDecodeMessageReusing(definition);
+            }
             builder.AppendLine("const auto length = reader.readLengthPrefix();");
             builder.AppendLine("const auto end = reader.pointer() + length;");
             builder.AppendLine("while (true) {");
-            builder.Indent(2);
-            builder.AppendLine("switch (reader.readByte()) {");
-            builder.AppendLine("  case 0:");
+            builder.AppendLine("  const auto tag = reader.readByte();");
+            builder.AppendLine("  if (tag == 0) {");
+            builder.AppendLine("    return reader.bytesRead();");
+            builder.AppendLine("  }");
+            builder.AppendLine($"  if (!{definition.Name}::decodeFieldInto(reader, tag, target{ResourceArgument})) {{");
+            builder.AppendLine("    reader.seek(end);");
             builder.AppendLine("    return reader.bytesRead();");
+            builder.AppendLine("  }");
+            builder.AppendLine("}");
+            return builder.ToString();
+        }
+
+        /// <summary>
+        /// Generate the body of the <c>decode</c> function for the given <see cref="MessageDefinition"/> in
+        /// <c>reuseStorage</c> mode. The fields on the wire decode into the target's existing storage; only the fields
+        /// that are absent are reset afterwards, so a message of the same shape as the last one keeps every buffer.
+        /// </summary>
+        private string CompileDecodeMessageReusing(MessageDefinition definition)
+        {
+            var builder = new IndentedStringBuilder(4);
+            builder.AppendLine("const auto length = reader.readLengthPrefix();");
+            builder.AppendLine("const auto end = reader.pointer() + length;");
+            builder.AppendLine("std::bitset<256> seen;");
+            builder.AppendLine("while (true) {");
+            builder.AppendLine("  const auto tag = reader.readByte();");
+            builder.AppendLine("  if (tag == 0) {");
+            builder.AppendLine("    break;");
+            builder.AppendLine("  }");
+            builder.AppendLine($"  if (!{definition.Name}::decodeFieldInto(reader, tag, target{ResourceArgument})) {{");
+            builder.AppendLine("    reader.seek(end);");
+            builder.AppendLine("    break;");
+            builder.AppendLine("  }");
+            builder.AppendLine("  seen.set(tag);");
+            builder.AppendLine("}");
+            foreach (var field in definition.Fields)
+            {
+                builder.AppendLine($"if (!seen.test({field.ConstantValue})) target.{field.Name}.reset();");
+            }
+            return builder.ToString();
+        }
+
+        /// <summary>
+        /// Generate the body of the <c>decodeFieldInto</c> function for the given <see cref="MessageDefinition"/>: it
+        /// decodes the value of one tagged field, and returns false for a tag the schema does not know. Both
+        /// <c>decodeInto</c> and <c>bebop::IncrementalDecoder</c> drive a message through it one field at a time.
+        /// </summary>
+        /// <param name="definition">The message definition to generate code for.</param>
+        /// <returns>The generated CPlusPlus <c>decodeFieldInto</c> function body.</returns>
+        private string CompileDecodeMessageField(MessageDefinition definition)
+        {
+            var builder = new IndentedStringBuilder(4);
+            builder.AppendLine("switch (tag) {");
             foreach (var field in definition.Fields)
             {
                 builder.AppendLine($"  case {field.ConstantValue}:");
                 builder.AppendLine($"    {CompileDecodeField(field.Type, $"target.{field.Name}", 0, 2, true)}");
-                builder.AppendLine("    break;");
+                builder.AppendLine("    return true;");
             }
             builder.AppendLine("  default:");
-            builder.AppendLine("    reader.seek(end);");
-            builder.AppendLine("    return reader.bytesRead();");
-            builder.AppendLine("}");
-            builder.Dedent(2);
+            builder.AppendLine("    return false;");
             builder.AppendLine("}");
             return builder.ToString();
         }
@@ -195,10 +470,122 @@ namespace Core.Generators.CPlusPlus
         private string CompileDecodeStruct(StructDefinition definition)
         {
             var builder = new IndentedStringBuilder(4);
+            if (IsPackable(definition))
+            {
+                builder.AppendLine("#if BEBOP_ASSUME_LITTLE_ENDIAN");
+                builder.AppendLine("Packed packed;");
+                builder.AppendLine("reader.readRaw(reinterpret_cast<uint8_t*>(&packed), sizeof(packed));");
+                builder.AppendLine($"{definition.Name}::unpack(packed, target);");
+                builder.AppendLine("#else");
+            }
             foreach (var field in definition.Fields)
             {
                 builder.AppendLine(CompileDecodeField(field.Type, $"target.{field.Name}"));
             }
+            if (IsPackable(definition))
+            {
+                builder.AppendLine("#endif");
+            }
+            return builder.ToString();
+        }
+
+        /// <summary>
+        /// Whether the given struct always encodes to the same bytes as a packed C struct of its fields, so that it
+        /// can be copied in and out of a buffer through a generated <c>Packed</c> mirror type. A struct that encodes
+        /// to nothing, such as an empty one, has no such mirror: a C++ struct cannot be zero bytes long.
+        /// </summary>
+        private bool IsPackable(StructDefinition definition) => definition.IsFixedSize(Schema) && definition.MinimalEncodedSize(Schema) > 0;
+
+        private bool IsPackable(TypeBase type) => type is DefinedType dt && Schema.Definitions[dt.Name] is StructDefinition sd && IsPackable(sd);
+
+        /// <summary>
+        /// Generate the type of a field in a <c>Packed</c> mirror struct.
+        /// </summary>
+        private string PackedTypeName(TypeBase type)
+        {
+            return type switch
+            {
+                ScalarType { BaseType: BaseType.Bool } => "uint8_t",
+                ScalarType { BaseType: BaseType.Date } => "uint64_t",
+                DefinedType dt when Schema.Definitions[dt.Name] is StructDefinition => $"{dt.Name}::Packed",
+                _ => TypeName(type),
+            };
+        }
+
+        /// <summary>
+        /// Generate the <c>Packed</c> mirror type of a fixed-size struct, along with the functions that convert to and from it.
+        /// </summary>
+        /// <param name="definition">The struct definition to generate code for.</param>
+        /// <returns>The generated CPlusPlus code.</returns>
+        private string CompilePacked(StructDefinition definition)
+        {
+            var size = definition.MinimalEncodedSize(Schema);
+            // Fields that encode to nothing, such as empty structs, are left out of the mirror and never copied.
+            var packedFields = definition.Fields.Where(f => FixedEncodedSize(f.Type) != 0).ToList();
+            var builder = new IndentedStringBuilder(2);
+            builder.AppendLine($"/// The wire layout of `{definition.Name}`: on a little-endian host, this is byte-for-byte its encoding.");
+            builder.AppendLine("#pragma pack(push, 1)");
+            builder.AppendLine("struct Packed {");
+            foreach (var field in packedFields)
+            {
+                builder.AppendLine($"  {PackedTypeName(field.Type)} {field.Name};");
+            }
+            builder.AppendLine("};");
+            builder.AppendLine("#pragma pack(pop)");
+            builder.AppendLine($"static_assert(sizeof(Packed) == {size}, \"{definition.Name}::Packed should match the wire size\");");
+            builder.AppendLine("");
+            builder.AppendLine($"static Packed pack(const {definition.Name}& message) {{");
+            builder.AppendLine("  Packed packed;");
+            foreach (var field in packedFields)
+            {
+                builder.AppendLine(field.Type switch
+                {
+                    ScalarType { BaseType: BaseType.Date } => $"  packed.{field.Name} = ::bebop::dateToTicks(message.{field.Name});",
+                    DefinedType dt when IsPackable(dt) => $"  packed.{field.Name} = {dt.Name}::pack(message.{field.Name});",
+                    _ => $"  packed.{field.Name} = message.{field.Name};",
+                });
+            }
+            builder.AppendLine("  return packed;");
+            builder.AppendLine("}");
+            builder.AppendLine("");
+            builder.AppendLine($"static void unpack(const Packed& packed, {definition.Name}& target) {{");
+            foreach (var field in packedFields)
+            {
+                builder.AppendLine(field.Type switch
+                {
+                    ScalarType { BaseType: BaseType.Bool } => $"  target.{field.Name} = packed.{field.Name} != 0;",
+                    ScalarType { BaseType: BaseType.Date } => $"  target.{field.Name} = ::bebop::ticksToDate(packed.{field.Name});",
+                    DefinedType dt when IsPackable(dt) => $"  {dt.Name}::unpack(packed.{field.Name}, target.{field.Name});",
+                    _ => $"  target.{field.Name} = packed.{field.Name};",
+                });
+            }
+            builder.AppendLine("}");
+            builder.AppendLine("");
+            builder.AppendLine($"/// Whether `{definition.Name}` itself is laid out like its encoding, so arrays of it can be copied in bulk.");
+            builder.AppendLine("static constexpr bool hasWireLayout() {");
+            if (packedFields.Count != definition.Fields.Count || definition.Fields.Any(f => f.Type is ScalarType { BaseType: BaseType.Bool or BaseType.Date }))
+            {
+                builder.AppendLine("  return false;");
+            }
+            else
+            {
+                builder.AppendLine("  return BEBOP_ASSUME_LITTLE_ENDIAN");
+                builder.AppendLine($"    && std::is_trivially_copyable<{definition.Name}>::value");
+                builder.AppendLine($"    && sizeof({definition.Name}) == {size}");
+                var offset = 0;
+                foreach (var field in definition.Fields)
+                {
+                    if (IsPackable(field.Type))
+                    {
+                        builder.AppendLine($"    && {((DefinedType)field.Type).Name}::hasWireLayout()");
+                    }
+                    builder.AppendLine($"    && offsetof({definition.Name}, {field.Name}) == {offset}");
+                    offset += FixedEncodedSize(field.Type)!.Value;
+                }
+                builder.AppendLine("    ;");
+            }
+            builder.AppendLine("}");
+            builder.AppendLine("");
             return builder.ToString();
         }
 
@@ -212,8 +599,15 @@ namespace Core.Generators.CPlusPlus
             foreach (var branch in definition.Branches)
             {
                 builder.AppendLine($"  case {branch.Discriminator}:");
-                builder.AppendLine($"    target.variant.emplace<{i}>();");
-                builder.AppendLine($"    {branch.Definition.Name}::decodeInto(reader, std::get<{i}>(target.variant));");
+                if (ReuseStorage)
+                {
+                    builder.AppendLine($"    {branch.Definition.Name}::decodeInto(reader, ::bebop::reuse<{i}>(target.variant{ResourceArgument}){ResourceArgument});");
+                }
+                else
+                {
+                    builder.AppendLine($"    target.variant.emplace<{i}>({Resource});");
+                    builder.AppendLine($"    {branch.Definition.Name}::decodeInto(reader, std::get<{i}>(target.variant){ResourceArgument});");
+                }
                 builder.AppendLine("    break;");
                 i++;
             }
@@ -224,6 +618,102 @@ namespace Core.Generators.CPlusPlus
             return builder.ToString();
         }
 
+        /// <summary>
+        /// Generate the body of the <c>validate</c> function for the given <see cref="RecordDefinition"/>. It walks the
+        /// encoding exactly as <c>decodeInto</c> would, checking every length prefix, discriminator and message
+        /// terminator, so that a buffer it accepts can be decoded with an unchecked reader.
+        /// </summary>
+        /// <param name="definition">The definition to generate code for.</param>
+        /// <returns>The generated CPlusPlus <c>validate</c> function body.</returns>
+        private string CompileValidate(Definition definition)
+        {
+            var builder = new IndentedStringBuilder(4);
+            switch (definition)
+            {
+                case StructDefinition sd when sd.IsFixedSize(Schema):
+                    builder.AppendLine($"reader.skip({sd.MinimalEncodedSize(Schema)});");
+                    break;
+                case StructDefinition sd:
+                    foreach (var field in sd.Fields)
+                    {
+                        builder.AppendLine(CompileValidateField(field.Type));
+                    }
+                    break;
+                case MessageDefinition md:
+                    builder.AppendLine("const auto length = reader.readLengthPrefix();");
+                    builder.AppendLine("const auto end = reader.pointer() + length;");
+                    builder.AppendLine("while (true) {");
+                    builder.Indent(2);
+                    builder.AppendLine("switch (reader.readByte()) {");
+                    builder.AppendLine("  case 0:");
+                    builder.AppendLine("    if (reader.pointer() != end) reader.fail();");
+                    builder.AppendLine("    return;");
+                    foreach (var field in md.Fields)
+                    {
+                        builder.AppendLine($"  case {field.ConstantValue}:");
+                        builder.AppendLine($"    {CompileValidateField(field.Type, 0, 2)}");
+                        builder.AppendLine("    break;");
+                    }
+                    builder.AppendLine("  default:");
+                    builder.AppendLine("    reader.seek(end);");
+                    builder.AppendLine("    return;");
+                    builder.AppendLine("}");
+                    builder.Dedent(2);
+                    builder.AppendLine("}");
+                    break;
+                case UnionDefinition ud:
+                    builder.AppendLine("const auto length = reader.readLengthPrefix();");
+                    builder.AppendLine("const auto end = reader.pointer() + length + 1;");
+                    builder.AppendLine("switch (reader.readByte()) {");
+                    foreach (var branch in ud.Branches)
+                    {
+                        builder.AppendLine($"  case {branch.Discriminator}:");
+                        builder.AppendLine($"    {branch.Definition.Name}::validate(reader);");
+                        builder.AppendLine("    break;");
+                    }
+                    builder.AppendLine("  default:");
+                    builder.AppendLine("    reader.seek(end);");
+                    builder.AppendLine("    return;");
+                    builder.AppendLine("}");
+                    builder.AppendLine("if (reader.pointer() != end) reader.fail();");
+                    break;
+                default:
+                    throw new InvalidOperationException($"invalid CompileValidate kind: {definition}");
+            }
+            return builder.ToString();
+        }
+
+        private string CompileValidateField(TypeBase type, int depth = 0, int indentDepth = 0)
+        {
+            var tab = new string(' ', indentStep);
+            var nl = "\n" + new string(' ', indentDepth * indentStep);
+            var i = GeneratorUtils.LoopVariable(depth);
+            return type switch
+            {
+                _ when FixedEncodedSize(type) is int size => $"reader.skip({size});",
+                ScalarType => "reader.skip(reader.readLengthPrefix());",
+                ArrayType at when FixedEncodedSize(at.MemberType) is int size =>
+                    $"reader.skip(size_t{{reader.readArrayLength({size})}} * {size});",
+                ArrayType at =>
+                    $"{{" + nl +
+                    $"{tab}const auto length{depth} = reader.readArrayLength({at.MemberType.MinimalEncodedSize(Schema)});" + nl +
+                    $"{tab}for (size_t {i} = 0; {i} < length{depth}; {i}++) {{" + nl +
+                    $"{tab}{tab}{CompileValidateField(at.MemberType, depth + 1, indentDepth + 2)}" + nl +
+                    $"{tab}}}" + nl +
+                    $"}}",
+                MapType mt =>
+                    $"{{" + nl +
+                    $"{tab}const auto length{depth} = reader.readArrayLength({mt.KeyType.MinimalEncodedSize(Schema) + mt.ValueType.MinimalEncodedSize(Schema)});" + nl +
+                    $"{tab}for (size_t {i} = 0; {i} < length{depth}; {i}++) {{" + nl +
+                    $"{tab}{tab}{CompileValidateField(mt.KeyType, depth + 1, indentDepth + 2)}" + nl +
+                    $"{tab}{tab}{CompileValidateField(mt.ValueType, depth + 1, indentDepth + 2)}" + nl +
+                    $"{tab}}}" + nl +
+                    $"}}",
+                DefinedType dt => $"{dt.Name}::validate(reader);",
+                _ => throw new InvalidOperationException($"CompileValidateField: {type}")
+            };
+        }
+
         private string ReadBaseType(BaseType baseType)
         {
             return baseType switch
@@ -253,38 +743,172 @@ namespace Core.Generators.CPlusPlus
             var dot = isOptional ? "->" : ".";
             return type switch
             {
-                ArrayType at when at.IsBytes() => $"{target} = reader.readBytes();",
+                ArrayType at when at.IsBytes() && !UsePmr && !ReuseStorage => $"{target} = reader.readBytes();",
+                ArrayType at when IsPackable(at.MemberType) => $"reader.readPackedArray({(isOptional ? CompileEngageOptional(target) : target)});",
+                ArrayType at when at.MemberType.IsFixedScalar() || at.MemberType.IsEnum(Schema) =>
+                    $"reader.readScalarArray({(isOptional ? CompileEngageOptional(target) : target)});",
+                ArrayType at when ReuseStorage =>
+                    $"{{" + nl +
+                    $"{tab}const auto length{depth} = reader.readArrayLength({at.MemberType.MinimalEncodedSize(Schema)});" + nl +
+                    $"{tab}auto& array{depth} = {(isOptional ? CompileEngageOptional(target) : target)};" + nl +
+                    $"{tab}::bebop::resizeReusing(array{depth}, length{depth}{(RecordResource(at.MemberType) == "" ? "" : ", resource")});" + nl +
+                    $"{tab}for (auto& x{depth} : array{depth}) {{" + nl +
+                    $"{tab}{tab}{CompileDecodeField(at.MemberType, $"x{depth}", depth + 1, indentDepth + 2)}" + nl +
+                    $"{tab}}}" + nl +
+                    $"}}",
                 ArrayType at =>
                     $"{{" + nl +
-                    $"{tab}const auto length{depth} = reader.readUint32();" + nl +
-                    $"{tab}{target} = {TypeName(at)}();" + nl +
-                    $"{tab}{target}{dot}reserve(length{depth});" + nl +
+                    $"{tab}const auto length{depth} = reader.readArrayLength({at.MemberType.MinimalEncodedSize(Schema)});" + nl +
+                    $"{tab}{CompileResetContainer(at, target, isOptional)}" + nl +
+                    (at.MemberType.MinimalEncodedSize(Schema) == 0 ? "" : $"{tab}{target}{dot}reserve(length{depth});" + nl) +
                     $"{tab}for (size_t {i} = 0; {i} < length{depth}; {i}++) {{" + nl +
-                    $"{tab}{tab}{TypeName(at.MemberType)} x{depth};" + nl +
+                    $"{tab}{tab}auto& x{depth} = {target}{dot}emplace_back({RecordResource(at.MemberType)});" + nl +
                     $"{tab}{tab}{CompileDecodeField(at.MemberType, $"x{depth}", depth + 1, indentDepth + 2)}" + nl +
-                    $"{tab}{tab}{target}{dot}push_back(x{depth});" + nl +
                     $"{tab}}}" + nl +
                     $"}}",
-                MapType mt =>
+                MapType mt when MapContainer == "flat" =>
                     $"{{" + nl +
-                    $"{tab}const auto length{depth} = reader.readUint32();" + nl +
-                    $"{tab}{target} = {TypeName(mt)}();" + nl +
+                    $"{tab}const auto length{depth} = reader.readArrayLength({mt.KeyType.MinimalEncodedSize(Schema) + mt.ValueType.MinimalEncodedSize(Schema)});" + nl +
+                    $"{tab}{CompileResetContainer(mt, target, isOptional)}" + nl +
+                    $"{tab}{target}{dot}reserve(length{depth});" + nl +
                     $"{tab}for (size_t {i} = 0; {i} < length{depth}; {i}++) {{" + nl +
                     $"{tab}{tab}{TypeName(mt.KeyType)} k{depth};" + nl +
                     $"{tab}{tab}{CompileDecodeField(mt.KeyType, $"k{depth}", depth + 1, indentDepth + 2)}" + nl +
-                    $"{tab}{tab}{TypeName(mt.ValueType)}& v{depth} = {target}{dot}operator[](k{depth});" + nl +
+                    $"{tab}{tab}auto& v{depth} = {target}{dot}appendUnsorted(std::move(k{depth}));" + nl +
+                    $"{tab}{tab}{CompileDecodeField(mt.ValueType, $"v{depth}", depth + 1, indentDepth + 2)}" + nl +
+                    $"{tab}}}" + nl +
+                    $"{tab}{target}{dot}sortAppended();" + nl +
+                    $"}}",
+                MapType mt =>
+                    $"{{" + nl +
+                    $"{tab}const auto length{depth} = reader.readArrayLength({mt.KeyType.MinimalEncodedSize(Schema) + mt.ValueType.MinimalEncodedSize(Schema)});" + nl +
+                    $"{tab}{CompileResetContainer(mt, target, isOptional)}" + nl +
+                    (MapContainer == "unordered" ? $"{tab}{target}{dot}reserve(length{depth});" + nl : "") +
+                    $"{tab}for (size_t {i} = 0; {i} < length{depth}; {i}++) {{" + nl +
+                    $"{tab}{tab}{TypeName(mt.KeyType)} k{depth}{(UsePmr && mt.KeyType is ScalarType kst && kst.BaseType == BaseType.String ? "{resource}" : "")};" + nl +
+                    $"{tab}{tab}{CompileDecodeField(mt.KeyType, $"k{depth}", depth + 1, indentDepth + 2)}" + nl +
+                    (UsePmr
+                        ? $"{tab}{tab}{TypeName(mt.ValueType)}& v{depth} = {target}{dot}try_emplace(std::move(k{depth}){(RecordResource(mt.ValueType) == "" ? "" : ", resource")}).first->second;" + nl
+                        : $"{tab}{tab}{TypeName(mt.ValueType)}& v{depth} = {target}{dot}operator[](k{depth});" + nl) +
                     $"{tab}{tab}{CompileDecodeField(mt.ValueType, $"v{depth}", depth + 1, indentDepth + 2)}" + nl +
                     $"{tab}}}" + nl +
                     $"}}",
+                ScalarType { BaseType: BaseType.String } when ReuseStorage && isOptional => $"{CompileEngageOptional(target)} = reader.readStringView();",
+                ScalarType { BaseType: BaseType.String } when UsePmr && isOptional => $"{target}.emplace(reader.readStringView(), resource);",
+                ScalarType { BaseType: BaseType.String } when UsePmr || ReuseStorage => $"{target} = reader.readStringView();",
                 ScalarType st => $"{target} = {ReadBaseType(st.BaseType)};",
                 DefinedType dt when Schema.Definitions[dt.Name] is EnumDefinition ed =>
                     $"{target} = static_cast<{dt.Name}>({ReadBaseType(ed.BaseType)});",
+                DefinedType dt when ReuseStorage && isOptional => $"{dt.Name}::decodeInto(reader, {CompileEngageOptional(target)}{ResourceArgument});",
+                DefinedType dt when UsePmr && isOptional => $"{dt.Name}::decodeInto(reader, {target}.emplace(resource), resource);",
+                DefinedType dt when UsePmr => $"{dt.Name}::decodeInto(reader, {target}, resource);",
                 DefinedType dt when isOptional => $"{target}.emplace({dt.Name}::decode(reader));",
                 DefinedType dt => $"{dt.Name}::decodeInto(reader, {target});",
                 _ => throw new InvalidOperationException($"CompileDecodeField: {type}")
             };
         }
 
+        /// <summary>
+        /// Generate the statement that empties a container before it is decoded into. In <c>usePmr</c> mode the
+        /// container must keep the allocator it was constructed with, so it is cleared (or engaged with the
+        /// decoding resource) rather than assigned a new one.
+        /// </summary>
+        private string CompileResetContainer(TypeBase type, string target, bool isOptional)
+        {
+            if (ReuseStorage)
+            {
+                return isOptional ? $"{CompileEngageOptional(target)}.clear();" : $"{target}.clear();";
+            }
+            if (!UsePmr)
+            {
+                return $"{target} = {TypeName(type)}();";
+            }
+            return isOptional ? $"{target}.emplace(resource);" : $"{target}.clear();";
+        }
+
+        /// <summary>
+        /// Generate an expression for the value of an optional field, engaging it first if it is empty. In
+        /// <c>reuseStorage</c> mode an engaged field keeps its value, so decoding reuses its storage.
+        /// </summary>
+        private string CompileEngageOptional(string target) =>
+            ReuseStorage ? $"::bebop::reuse({target}{ResourceArgument})" : $"{target}.emplace({Resource})";
+
+        /// <summary>
+        /// Generate the constructors of a record in <c>usePmr</c> mode: the default one, and one that builds every
+        /// string, container and nested record of a struct on the given memory resource.
+        /// </summary>
+        private string CompilePmrConstructors(RecordDefinition definition)
+        {
+            var members = definition is StructDefinition sd
+                ? sd.Fields.Where(f => f.Type is ArrayType or MapType || f.Type is ScalarType { BaseType: BaseType.String } || RecordResource(f.Type) != "").Select(f => $"{f.Name}(resource)").ToList()
+                : new List<string>();
+            var builder = new IndentedStringBuilder(2);
+            builder.AppendLine($"{definition.Name}() = default;");
+            builder.AppendLine(members.Count == 0
+                ? $"explicit {definition.Name}(std::pmr::memory_resource*) {{}}"
+                : $"explicit {definition.Name}(std::pmr::memory_resource* resource) : {string.Join(", ", members)} {{}}");
+            return builder.ToString();
+        }
+
+        /// <summary>
+        /// Whether to emit allocator-aware records whose strings and containers come from a <c>std::pmr::memory_resource</c>.
+        /// </summary>
+        private bool UsePmr => Config.GetOptionBoolValue("usePmr");
+
+        /// <summary>
+        /// Whether <c>decodeInto</c> reuses the storage of the target it decodes into: containers are cleared or resized
+        /// rather than replaced, strings are assigned in place, and optional fields and union branches that are already
+        /// engaged are decoded into directly, so decoding a stream of similar records into one object stops allocating.
+        /// </summary>
+        private bool ReuseStorage => Config.GetOptionBoolValue("reuseStorage");
+
+        /// <summary>
+        /// The container that generated maps use: <c>ordered</c> (<c>std::map</c>, the default), <c>flat</c>
+        /// (<c>bebop::FlatMap</c>, a sorted vector) or <c>unordered</c> (<c>std::unordered_map</c>).
+        /// </summary>
+        private string MapContainer
+        {
+            get
+            {
+                var container = Config.GetOptionRawValue("mapContainer") ?? "ordered";
+                return container switch
+                {
+                    "ordered" or "unordered" => container,
+                    "flat" when UsePmr => throw new InvalidOperationException("mapContainer=flat cannot be combined with usePmr; use ordered or unordered maps"),
+                    "flat" => container,
+                    _ => throw new InvalidOperationException($"unknown mapContainer \"{container}\"; expected ordered, flat or unordered"),
+                };
+            }
+        }
+
+        /// <summary>
+        /// The constructor argument for a new value that should allocate from the decoding resource, if any.
+        /// </summary>
+        private string Resource => UsePmr ? "resource" : "";
+
+        /// <summary>
+        /// The decoding resource, passed on to a nested decode call.
+        /// </summary>
+        private string ResourceArgument => UsePmr ? ", resource" : "";
+
+        /// <summary>
+        /// The trailing decoding resource parameter of a decode entry point.
+        /// </summary>
+        private string ResourceParameter => UsePmr ? ", std::pmr::memory_resource* resource = std::pmr::get_default_resource()" : "";
+
+        /// <summary>
+        /// The name a record's instrumentation counters are kept under, qualified by the namespace if there is one.
+        /// </summary>
+        private string InstrumentedName(Definition definition) =>
+            string.IsNullOrWhiteSpace(Config.Namespace) ? definition.Name : $"{Config.Namespace}::{definition.Name}";
+
+        /// <summary>
+        /// The constructor argument for a new value of the given type. Records take the decoding resource
+        /// explicitly; pmr strings and containers pick it up from their parent container's allocator.
+        /// </summary>
+        private string RecordResource(TypeBase type) =>
+            UsePmr && type is DefinedType dt && Schema.Definitions[dt.Name] is RecordDefinition ? "resource" : "";
+
         /// <summary>
         /// Generate a CPlusPlus type name for the given <see cref="TypeBase"/>.
         /// </summary>
@@ -307,7 +931,7 @@ namespace Core.Generators.CPlusPlus
                         BaseType.Int64 => "int64_t",
                         BaseType.Float32 => "float",
                         BaseType.Float64 => "double",
-                        BaseType.String => "std::string",
+                        BaseType.String => UsePmr ? "std::pmr::string" : "std::string",
                         BaseType.Guid => "::bebop::Guid",
                         BaseType.Date => "::bebop::TickDuration",
                         _ => throw new ArgumentOutOfRangeException(st.BaseType.ToString())
@@ -315,15 +939,492 @@ namespace Core.Generators.CPlusPlus
                 // case ArrayType at when at.IsBytes():
                 //     return "std::vector<uint8_t>";
                 case ArrayType at:
-                    return $"std::vector<{TypeName(at.MemberType)}>";
+                    return $"std::{(UsePmr ? "pmr::" : "")}vector<{TypeName(at.MemberType)}>";
                 case MapType mt:
-                    return $"std::map<{TypeName(mt.KeyType)}, {TypeName(mt.ValueType)}>";
+                    return MapContainer switch
+                    {
+                        "flat" => $"::bebop::FlatMap<{TypeName(mt.KeyType)}, {TypeName(mt.ValueType)}>",
+                        "unordered" => $"std::{(UsePmr ? "pmr::" : "")}unordered_map<{TypeName(mt.KeyType)}, {TypeName(mt.ValueType)}>",
+                        _ => $"std::{(UsePmr ? "pmr::" : "")}map<{TypeName(mt.KeyType)}, {TypeName(mt.ValueType)}>",
+                    };
                 case DefinedType dt:
                     return dt.Name;
             }
             throw new InvalidOperationException($"GetTypeName: {type}");
         }
 
+        /// <summary>
+        /// Whether to emit a zero-copy <c>FooView</c> alongside every owning record.
+        /// </summary>
+        private bool EmitViews => Config.GetOptionBoolValue("emitViews");
+
+        /// <summary>
+        /// Generate the name of the runtime codec that decodes a view of the given <see cref="TypeBase"/>.
+        /// </summary>
+        /// <param name="type">The field type to generate code for.</param>
+        /// <returns>The CPlusPlus codec type name.</returns>
+        private string ViewCodecName(in TypeBase type)
+        {
+            return type switch
+            {
+                ScalarType st when st.BaseType == BaseType.String => "::bebop::StringViewCodec",
+                ScalarType st => $"::bebop::ScalarCodec<{TypeName(st)}>",
+                ArrayType at => $"::bebop::ArrayView<{ViewCodecName(at.MemberType)}>",
+                MapType mt => MapContainer switch
+                {
+                    "flat" => $"::bebop::MapView<{ViewCodecName(mt.KeyType)}, {ViewCodecName(mt.ValueType)}, ::bebop::FlatMap>",
+                    "unordered" => $"::bebop::MapView<{ViewCodecName(mt.KeyType)}, {ViewCodecName(mt.ValueType)}, std::unordered_map>",
+                    _ => $"::bebop::MapView<{ViewCodecName(mt.KeyType)}, {ViewCodecName(mt.ValueType)}>",
+                },
+                DefinedType dt when Schema.Definitions[dt.Name] is EnumDefinition => $"::bebop::EnumCodec<{dt.Name}>",
+                DefinedType dt => $"{dt.Name}View",
+                _ => throw new InvalidOperationException($"ViewCodecName: {type}")
+            };
+        }
+
+        /// <summary>
+        /// Generate the name of the runtime codec that decodes a view of a field of the given <see cref="TypeBase"/>.
+        /// Records nested in a field are wrapped in a <c>LazyView</c>, so they are only decoded when accessed;
+        /// array and map elements already are.
+        /// </summary>
+        /// <param name="type">The field type to generate code for.</param>
+        /// <returns>The CPlusPlus codec type name.</returns>
+        private string FieldViewCodecName(in TypeBase type)
+        {
+            return type switch
+            {
+                DefinedType dt when Schema.Definitions[dt.Name] is not EnumDefinition => $"::bebop::LazyView<{dt.Name}View>",
+                _ => ViewCodecName(type),
+            };
+        }
+
+        /// <summary>
+        /// Generate the CPlusPlus type that a view exposes for a field of the given <see cref="TypeBase"/>.
+        /// </summary>
+        /// <param name="type">The field type to generate code for.</param>
+        /// <returns>The CPlusPlus view type name.</returns>
+        private string ViewTypeName(in TypeBase type)
+        {
+            return type switch
+            {
+                ScalarType st when st.BaseType == BaseType.String => "std::string_view",
+                ScalarType => TypeName(type),
+                DefinedType dt when Schema.Definitions[dt.Name] is EnumDefinition => TypeName(type),
+                _ => FieldViewCodecName(type),
+            };
+        }
+
+        /// <summary>
+        /// Generate the body of the <c>decode</c> function of a view for the given <see cref="RecordDefinition"/>.
+        /// </summary>
+        /// <param name="definition">The definition to generate code for.</param>
+        /// <returns>The generated CPlusPlus view <c>decode</c> function body.</returns>
+        private string CompileDecodeView(RecordDefinition definition)
+        {
+            var builder = new IndentedStringBuilder(4);
+            switch (definition)
+            {
+                case MessageDefinition md:
+                    builder.AppendLine("const auto length = reader.readLengthPrefix();");
+                    builder.AppendLine("const auto end = reader.pointer() + length;");
+                    builder.AppendLine("while (true) {");
+                    builder.AppendLine("  switch (reader.readByte()) {");
+                    builder.AppendLine("    case 0:");
+                    builder.AppendLine("      return view;");
+                    foreach (var field in md.Fields)
+                    {
+                        builder.AppendLine($"    case {field.ConstantValue}:");
+                        builder.AppendLine($"      view.{field.Name} = {FieldViewCodecName(field.Type)}::decode(reader);");
+                        builder.AppendLine("      break;");
+                    }
+                    builder.AppendLine("    default:");
+                    builder.AppendLine("      reader.seek(end);");
+                    builder.AppendLine("      return view;");
+                    builder.AppendLine("  }");
+                    builder.AppendLine("}");
+                    break;
+                case StructDefinition sd:
+                    foreach (var field in sd.Fields)
+                    {
+                        builder.AppendLine($"view.{field.Name} = {FieldViewCodecName(field.Type)}::decode(reader);");
+                    }
+                    break;
+                case UnionDefinition ud:
+                    builder.AppendLine("const auto length = reader.readLengthPrefix();");
+                    builder.AppendLine("const auto end = reader.pointer() + length + 1;");
+                    builder.AppendLine("switch (reader.readByte()) {");
+                    var i = 0;
+                    foreach (var branch in ud.Branches)
+                    {
+                        builder.AppendLine($"  case {branch.Discriminator}:");
+                        builder.AppendLine($"    view.variant.emplace<{i++}>(::bebop::LazyView<{branch.Definition.Name}View>::decode(reader));");
+                        builder.AppendLine("    break;");
+                    }
+                    builder.AppendLine("  default:");
+                    builder.AppendLine("    reader.seek(end);");
+                    builder.AppendLine("    break;");
+                    builder.AppendLine("}");
+                    break;
+                default:
+                    throw new InvalidOperationException($"invalid CompileDecodeView kind: {definition}");
+            }
+            return builder.ToString();
+        }
+
+        /// <summary>
+        /// Generate the body of the <c>skip</c> function of a view for the given <see cref="RecordDefinition"/>.
+        /// Messages and unions are skipped by their length prefix; only structs visit their fields.
+        /// </summary>
+        /// <param name="definition">The definition to generate code for.</param>
+        /// <returns>The generated CPlusPlus view <c>skip</c> function body.</returns>
+        private string CompileSkipView(RecordDefinition definition)
+        {
+            var builder = new IndentedStringBuilder(4);
+            switch (definition)
+            {
+                case MessageDefinition:
+                    builder.AppendLine("reader.skip(reader.readLengthPrefix());");
+                    break;
+                case StructDefinition sd:
+                    foreach (var field in sd.Fields)
+                    {
+                        builder.AppendLine($"{ViewCodecName(field.Type)}::skip(reader);");
+                    }
+                    break;
+                case UnionDefinition:
+                    // The length does not count the discriminator.
+                    builder.AppendLine("reader.skip(reader.readLengthPrefix() + size_t{1});");
+                    break;
+                default:
+                    throw new InvalidOperationException($"invalid CompileSkipView kind: {definition}");
+            }
+            return builder.ToString();
+        }
+
+        /// <summary>
+        /// Generate the body of a view's <c>toOwned</c> function for the given <see cref="RecordDefinition"/>.
+        /// </summary>
+        /// <param name="definition">The definition to generate code for.</param>
+        /// <returns>The generated CPlusPlus <c>toOwned</c> function body.</returns>
+        private string CompileViewToOwned(RecordDefinition definition)
+        {
+            var builder = new IndentedStringBuilder(4);
+            builder.AppendLine($"{definition.Name} result;");
+            switch (definition)
+            {
+                case MessageDefinition md:
+                    foreach (var field in md.Fields)
+                    {
+                        builder.AppendLine($"if ({field.Name}.has_value()) result.{field.Name} = {FieldViewCodecName(field.Type)}::own(*{field.Name});");
+                    }
+                    break;
+                case StructDefinition sd:
+                    foreach (var field in sd.Fields)
+                    {
+                        builder.AppendLine($"result.{field.Name} = {FieldViewCodecName(field.Type)}::own({field.Name});");
+                    }
+                    break;
+                case UnionDefinition ud:
+                    builder.AppendLine("switch (variant.index()) {");
+                    for (var i = 0; i < ud.Branches.Count; i++)
+                    {
+                        builder.AppendLine($"  case {i}:");
+                        builder.AppendLine($"    result.variant.emplace<{i}>(std::get<{i}>(variant).toOwned());");
+                        builder.AppendLine("    break;");
+                    }
+                    builder.AppendLine("}");
+                    break;
+            }
+            builder.AppendLine("return result;");
+            return builder.ToString();
+        }
+
+        /// <summary>
+        /// Generate a zero-copy view type for the given <see cref="RecordDefinition"/>.
+        /// </summary>
+        /// <param name="definition">The definition to generate code for.</param>
+        /// <returns>The generated CPlusPlus view type.</returns>
+        private string CompileView(RecordDefinition definition)
+        {
+            var name = $"{definition.Name}View";
+            var builder = new IndentedStringBuilder();
+            builder.AppendLine($"/// A read-only view of an encoded `{definition.Name}` that borrows from the source buffer.");
+            builder.AppendLine($"struct {name} {{");
+            builder.AppendLine($"  using value_type = {name};");
+            builder.AppendLine($"  using owned_type = {definition.Name};");
+            builder.AppendLine("  static constexpr size_t fixedSize = 0;");
+            builder.AppendLine("");
+            if (definition is FieldsDefinition fd)
+            {
+                var isMessage = fd is MessageDefinition;
+                foreach (var field in fd.Fields)
+                {
+                    var type = ViewTypeName(field.Type);
+                    builder.AppendLine($"  {(isMessage ? Optional(type) : type)} {field.Name}{(isMessage ? "" : "{}")};");
+                }
+            }
+            else if (definition is UnionDefinition ud)
+            {
+                var types = string.Join(", ", ud.Branches.Select(b => $"::bebop::LazyView<{b.Definition.Name}View>"));
+                builder.AppendLine($"  std::variant<{types}> variant;");
+            }
+            builder.AppendLine("");
+            builder.AppendLine($"  static {name} decode(const uint8_t* sourceBuffer, size_t sourceBufferSize) {{");
+            builder.AppendLine("    ::bebop::Reader reader{sourceBuffer, sourceBufferSize};");
+            builder.AppendLine($"    return {name}::decode(reader);");
+            builder.AppendLine("  }");
+            builder.AppendLine("");
+            builder.AppendLine($"  static {name} decode(const std::vector<uint8_t>& sourceBuffer) {{");
+            builder.AppendLine($"    return {name}::decode(sourceBuffer.data(), sourceBuffer.size());");
+            builder.AppendLine("  }");
+            builder.AppendLine("");
+            builder.AppendLine($"  static {name} decode(::bebop::Reader& reader) {{");
+            builder.AppendLine($"    {name} view;");
+            builder.AppendLine(CompileDecodeView(definition));
+            builder.AppendLine("    return view;");
+            builder.AppendLine("  }");
+            builder.AppendLine("");
+            builder.AppendLine("  static void skip(::bebop::Reader& reader) {");
+            builder.AppendLine(CompileSkipView(definition));
+            builder.AppendLine("  }");
+            builder.AppendLine("");
+            // The runtime's owning codecs build std containers, which cannot be moved into pmr records.
+            if (!UsePmr)
+            {
+                builder.AppendLine($"  {definition.Name} toOwned() const {{");
+                builder.AppendLine(CompileViewToOwned(definition));
+                builder.AppendLine("  }");
+                builder.AppendLine("");
+                builder.AppendLine($"  static {definition.Name} own(const {name}& view) {{ return view.toOwned(); }}");
+            }
+            builder.AppendLine("};");
+            builder.AppendLine("");
+            return builder.ToString();
+        }
+
+        /// <summary>
+        /// Generate the stubs for a service: an abstract <c>Base{Name}Service</c> whose <c>dispatch</c> decodes each
+        /// method's requests and encodes its responses around a pure virtual handler, and a <c>{Name}Client</c> that
+        /// makes calls over any <c>::bebop::ClientTransport</c>. <see cref="GeneratorConfig.Services"/> picks which
+        /// side is emitted.
+        /// </summary>
+        /// <param name="definition">The service to generate code for.</param>
+        /// <returns>The generated CPlusPlus service and client classes.</returns>
+        private string CompileService(ServiceDefinition definition)
+        {
+            var builder = new IndentedStringBuilder();
+            var methods = definition.Methods.Select(m => (
+                Method: m,
+                Name: m.Definition.Name.ToCamelCase(),
+                Request: TypeName(m.Definition.RequestDefinition),
+                Response: TypeName(m.Definition.ResponseDefintion))).ToList();
+
+            void AppendMethodIds()
+            {
+                foreach (var (method, name, _, _) in methods)
+                {
+                    builder.AppendLine($"  static constexpr uint32_t {name}Id = 0x{method.Id:X8};");
+                }
+            }
+
+            void AppendDocumentation(ServiceMethod method)
+            {
+                if (!string.IsNullOrWhiteSpace(method.Documentation))
+                {
+                    builder.AppendLine(FormatDocumentation(method.Documentation, 2));
+                }
+            }
+
+            if (Config.Services is TempoServices.Server or TempoServices.Both)
+            {
+                builder.AppendLine($"class {definition.BaseClassName()} : public ::bebop::Service {{");
+                builder.AppendLine("public:");
+                AppendMethodIds();
+                builder.AppendLine("");
+                builder.AppendLine($"  const char* serviceName() const override {{ return \"{definition.ClassName()}\"; }}");
+                builder.AppendLine("");
+                foreach (var (method, name, request, response) in methods)
+                {
+                    AppendDocumentation(method);
+                    builder.AppendLine(method.Definition.Type switch
+                    {
+                        MethodType.Unary => $"  virtual {response} {name}(const {request}& request, ::bebop::CallContext& context) = 0;",
+                        MethodType.ServerStream => $"  virtual void {name}(const {request}& request, ::bebop::StreamWriter<{response}>& responses, ::bebop::CallContext& context) = 0;",
+                        MethodType.ClientStream => $"  virtual {response} {name}(::bebop::StreamReader<{request}>& requests, ::bebop::CallContext& context) = 0;",
+                        MethodType.DuplexStream => $"  virtual void {name}(::bebop::StreamReader<{request}>& requests, ::bebop::StreamWriter<{response}>& responses, ::bebop::CallContext& context) = 0;",
+                        _ => throw new InvalidOperationException($"Unsupported method type {method.Definition.Type}")
+                    });
+                }
+                builder.AppendLine("");
+                builder.AppendLine("  void dispatch(uint32_t methodId, ::bebop::PayloadSource& requests, ::bebop::PayloadSink& responses, ::bebop::CallContext& context) override {");
+                builder.AppendLine("    context.methodId = methodId;");
+                builder.AppendLine("    switch (methodId) {");
+                foreach (var (method, name, request, response) in methods)
+                {
+                    builder.AppendLine($"      case {name}Id:");
+                    builder.AppendLine($"        return ::bebop::serve{method.Definition.Type}<{request}, {response}>(requests, responses, context, [this](auto&... args) {{ return {name}(args...); }});");
+                }
+                builder.AppendLine("      default:");
+                builder.AppendLine("        context.status = ::bebop::RpcStatus::UnknownMethod;");
+                builder.AppendLine("    }");
+                builder.AppendLine("  }");
+                builder.AppendLine("};");
+                builder.AppendLine("");
+            }
+
+            if (Config.Services is TempoServices.Client or TempoServices.Both)
+            {
+                var clientName = definition.ClassName().ReplaceLastOccurrence("Service", "Client");
+                builder.AppendLine($"/// Calls `{definition.ClassName()}` over a transport, which must outlive the client.");
+                builder.AppendLine($"class {clientName} {{");
+                builder.AppendLine("public:");
+                AppendMethodIds();
+                builder.AppendLine("");
+                builder.AppendLine($"  explicit {clientName}(::bebop::ClientTransport& transport) : m_transport(transport) {{}}");
+                builder.AppendLine("");
+                foreach (var (method, name, request, response) in methods)
+                {
+                    AppendDocumentation(method);
+                    switch (method.Definition.Type)
+                    {
+                        case MethodType.Unary:
+                            builder.AppendLine($"  ::bebop::CallContext {name}(const {request}& request, {response}& response) {{");
+                            builder.AppendLine($"    return ::bebop::callUnary(m_transport, {name}Id, request, response);");
+                            break;
+                        case MethodType.ServerStream:
+                            builder.AppendLine($"  /// `onResponse` is called with each `const {response}&` the service sends.");
+                            builder.AppendLine($"  template<typename G> ::bebop::CallContext {name}(const {request}& request, G&& onResponse) {{");
+                            builder.AppendLine($"    return ::bebop::callServerStream<{request}, {response}>(m_transport, {name}Id, request, onResponse);");
+                            break;
+                        case MethodType.ClientStream:
+                            builder.AppendLine($"  /// `nextRequest` fills in each `{request}&` to send, and returns false at the end of the stream.");
+                            builder.AppendLine($"  template<typename F> ::bebop::CallContext {name}(F&& nextRequest, {response}& response) {{");
+                            builder.AppendLine($"    return ::bebop::callClientStream<{request}, {response}>(m_transport, {name}Id, nextRequest, response);");
+                            break;
+                        case MethodType.DuplexStream:
+                            builder.AppendLine($"  /// `nextRequest` fills in each `{request}&` to send, and returns false at the end of the stream;");
+                            builder.AppendLine($"  /// `onResponse` is called with each `const {response}&` the service sends.");
+                            builder.AppendLine($"  template<typename F, typename G> ::bebop::CallContext {name}(F&& nextRequest, G&& onResponse) {{");
+                            builder.AppendLine($"    return ::bebop::callDuplexStream<{request}, {response}>(m_transport, {name}Id, nextRequest, onResponse);");
+                            break;
+                        default:
+                            throw new InvalidOperationException($"Unsupported method type {method.Definition.Type}");
+                    }
+                    builder.AppendLine("  }");
+                }
+                builder.AppendLine("");
+                builder.AppendLine("private:");
+                builder.AppendLine("  ::bebop::ClientTransport& m_transport;");
+                builder.AppendLine("};");
+                builder.AppendLine("");
+            }
+            return builder.ToString();
+        }
+
+        /// <summary>
+        /// Generate the schema's <c>dispatchOpcode</c> functions, which decode a record by its opcode and hand it to a
+        /// handler. Opcodes that are dense enough are switched on directly, which compilers turn into a jump table.
+        /// Sparse opcodes such as fourccs are first mapped to a dense slot by a perfect hash built here.
+        /// </summary>
+        /// <param name="records">The records that have an opcode.</param>
+        /// <returns>The generated CPlusPlus dispatch functions.</returns>
+        private string CompileOpcodeDispatch(List<(RecordDefinition Definition, uint Opcode)> records)
+        {
+            var builder = new IndentedStringBuilder();
+            builder.AppendLine("/// Decode a record by its opcode and pass it to `handler`, which must accept every record with an opcode.");
+            builder.AppendLine("template<typename Handler> ::bebop::DispatchStatus dispatchOpcode(uint32_t opcode, const uint8_t* data, size_t size, Handler&& handler) {");
+            var span = (ulong)records.Max(r => r.Opcode) - records.Min(r => r.Opcode) + 1;
+            if (span <= 2 * (ulong)records.Count)
+            {
+                builder.AppendLine("  switch (opcode) {");
+                foreach (var (definition, _) in records)
+                {
+                    builder.AppendLine($"    case {definition.Name}::opcode:");
+                    builder.AppendLine($"      return ::bebop::decodeAndDispatch<{definition.Name}>(data, size, handler);");
+                }
+            }
+            else
+            {
+                var (seeds, slotMask) = BuildOpcodeHash(records.Select(r => r.Opcode).ToList());
+                if (seeds.Length == 1)
+                {
+                    builder.AppendLine($"  switch (::bebop::opcodeHash(opcode, {seeds[0]}) & {slotMask}) {{");
+                }
+                else
+                {
+                    builder.AppendLine($"  static constexpr uint32_t seeds[{seeds.Length}] = {{{string.Join(", ", seeds)}}};");
+                    builder.AppendLine($"  switch (::bebop::opcodeHash(opcode, seeds[::bebop::opcodeHash(opcode, 0) & {seeds.Length - 1}]) & {slotMask}) {{");
+                }
+                foreach (var (definition, opcode) in records.OrderBy(r => OpcodeSlot(r.Opcode, seeds, slotMask)))
+                {
+                    builder.AppendLine($"    case {OpcodeSlot(opcode, seeds, slotMask)}:");
+                    builder.AppendLine($"      if (opcode != {definition.Name}::opcode) break;");
+                    builder.AppendLine($"      return ::bebop::decodeAndDispatch<{definition.Name}>(data, size, handler);");
+                }
+            }
+            builder.AppendLine("  }");
+            builder.AppendLine("  return ::bebop::DispatchStatus::UnknownOpcode;");
+            builder.AppendLine("}");
+            builder.AppendLine("");
+            builder.AppendLine("template<typename Handler> ::bebop::DispatchStatus dispatchOpcode(const ::bebop::Frame& frame, Handler&& handler) {");
+            builder.AppendLine("  return dispatchOpcode(frame.opcode, frame.data, frame.size, handler);");
+            builder.AppendLine("}");
+            builder.AppendLine("");
+            return builder.ToString();
+        }
+
+        /// <summary>
+        /// The runtime's <c>bebop::opcodeHash</c>: murmur3's 32-bit finalizer over the seeded opcode.
+        /// </summary>
+        private static uint OpcodeHash(uint opcode, uint seed)
+        {
+            unchecked
+            {
+                var h = opcode ^ seed;
+                h ^= h >> 16;
+                h *= 0x85ebca6b;
+                h ^= h >> 13;
+                h *= 0xc2b2ae35;
+                h ^= h >> 16;
+                return h;
+            }
+        }
+
+        private static uint OpcodeSlot(uint opcode, uint[] seeds, uint slotMask) =>
+            OpcodeHash(opcode, seeds[OpcodeHash(opcode, 0) & (uint)(seeds.Length - 1)]) & slotMask;
+
+        /// <summary>
+        /// Build a perfect hash of the given opcodes by hash-and-displace: opcodes are split into buckets, and each
+        /// bucket, largest first, gets the first seed that sends all of its opcodes to slots no other opcode took.
+        /// There are twice as many slots as opcodes (rounded up to a power of two), so a seed is found quickly.
+        /// </summary>
+        private static (uint[] Seeds, uint SlotMask) BuildOpcodeHash(List<uint> opcodes)
+        {
+            var bucketCount = 1;
+            while (bucketCount * 2 < opcodes.Count) bucketCount *= 2;
+            var slotCount = 2;
+            while (slotCount < 2 * opcodes.Count) slotCount *= 2;
+            var slotMask = (uint)(slotCount - 1);
+
+            var seeds = new uint[bucketCount];
+            var taken = new bool[slotCount];
+            var buckets = opcodes.GroupBy(o => OpcodeHash(o, 0) & (uint)(bucketCount - 1)).OrderByDescending(g => g.Count());
+            foreach (var bucket in buckets)
+            {
+                for (uint seed = 1; ; seed++)
+                {
+                    var slots = bucket.Select(o => OpcodeHash(o, seed) & slotMask).ToList();
+                    if (slots.Distinct().Count() == slots.Count && slots.All(slot => !taken[slot]))
+                    {
+                        seeds[bucket.Key] = seed;
+                        slots.ForEach(slot => taken[slot] = true);
+                        break;
+                    }
+                }
+            }
+            return (seeds, slotMask);
+        }
+
         private static string Optional(string type) => "std::optional<" + type + ">";
 
         private static string EscapeStringLiteral(string value)
@@ -362,12 +1463,28 @@ namespace Core.Generators.CPlusPlus
                 builder.AppendLine(GeneratorUtils.GetXmlAutoGeneratedNotice());
             }
             builder.AppendLine("#pragma once");
+            if (ReuseStorage)
+            {
+                builder.AppendLine("#include <bitset>");
+            }
             builder.AppendLine("#include <cstddef>");
             builder.AppendLine("#include <cstdint>");
             builder.AppendLine("#include <map>");
             builder.AppendLine("#include <memory>");
+            if (UsePmr)
+            {
+                builder.AppendLine("#include <memory_resource>");
+            }
             builder.AppendLine("#include <optional>");
             builder.AppendLine("#include <string>");
+            if (MapContainer == "unordered")
+            {
+                builder.AppendLine("#include <unordered_map>");
+            }
+            if (EmitViews)
+            {
+                builder.AppendLine("#include <string_view>");
+            }
             builder.AppendLine("#include <variant>");
             builder.AppendLine("#include <vector>");
             builder.AppendLine("#include \"bebop.hpp\"");
@@ -408,9 +1525,10 @@ namespace Core.Generators.CPlusPlus
                     case RecordDefinition td:
                         builder.AppendLine($"struct {td.Name} {{");
                         builder.AppendLine($"  static const size_t minimalEncodedSize = {td.MinimalEncodedSize(Schema)};");
+                        builder.AppendLine($"  static const ::bebop::RecordKind recordKind = ::bebop::RecordKind::{td switch { MessageDefinition => "Message", UnionDefinition => "Union", _ => "Struct" }};");
                         if (td.OpcodeDecorator is not null && td.OpcodeDecorator.TryGetValue("fourcc", out var fourcc))
                         {
-                            builder.AppendLine($"  static const uint32_t opcode = {fourcc};");
+                            builder.AppendLine($"  static constexpr uint32_t opcode = {fourcc};");
                             builder.AppendLine("");
                         }
 
@@ -432,81 +1550,196 @@ namespace Core.Generators.CPlusPlus
                                 builder.AppendLine($"  {(isMessage ? Optional(type) : type)} {field.Name};");
                             }
                             builder.AppendLine("");
+                            if (UsePmr)
+                            {
+                                builder.AppendLine(CompilePmrConstructors(td));
+                            }
+                            if (fd is StructDefinition packable && IsPackable(packable))
+                            {
+                                builder.AppendLine(CompilePacked(packable));
+                                builder.AppendLine("");
+                            }
                         }
                         else if (td is UnionDefinition ud)
                         {
                             var types = string.Join(", ", ud.Branches.Select(b => b.Definition.Name));
                             builder.AppendLine($"  std::variant<{types}> variant;");
+                            builder.AppendLine("");
+                            if (UsePmr)
+                            {
+                                builder.AppendLine(CompilePmrConstructors(td));
+                            }
                         }
                         else
                         {
                             throw new InvalidOperationException($"unsupported definition {td}");
                         }
 
+                        if (td is StructDefinition sd && sd.IsFixedSize(Schema))
+                        {
+                            builder.AppendLine($"  static constexpr size_t encodedSize(const {td.Name}&) {{ return {sd.MinimalEncodedSize(Schema)}; }}");
+                            builder.AppendLine($"  constexpr size_t encodedSize() const {{ return {sd.MinimalEncodedSize(Schema)}; }}");
+                        }
+                        else
+                        {
+                            builder.AppendLine($"  static size_t encodedSize(const {td.Name}& message) {{");
+                            builder.AppendLine(CompileEncodedSize(td));
+                            builder.AppendLine("  }");
+                            builder.AppendLine("");
+                            builder.AppendLine($"  size_t encodedSize() const {{ return {td.Name}::encodedSize(*this); }}");
+                        }
+                        builder.AppendLine("");
+                        if (MaxEncodedSize(td) is { } maximalEncodedSize)
+                        {
+                            builder.AppendLine($"  /// No `{td.Name}` encodes to more than this many bytes.");
+                            builder.AppendLine($"  static constexpr size_t maximalEncodedSize = {maximalEncodedSize};");
+                            builder.AppendLine($"  static constexpr size_t maxEncodedSize(const {td.Name}&) {{ return maximalEncodedSize; }}");
+                        }
+                        else
+                        {
+                            builder.AppendLine($"  /// An upper bound on `encodedSize(message)` that is cheaper to compute.");
+                            builder.AppendLine($"  static size_t maxEncodedSize(const {td.Name}& message) {{");
+                            builder.AppendLine(CompileMaxEncodedSize(td));
+                            builder.AppendLine("  }");
+                        }
+                        builder.AppendLine($"  size_t maxEncodedSize() const {{ return {td.Name}::maxEncodedSize(*this); }}");
+                        builder.AppendLine("");
+                        builder.AppendLine($"  static std::vector<uint8_t> encode(const {td.Name}& message) {{");
+                        builder.AppendLine("    std::vector<uint8_t> buffer;");
+                        builder.AppendLine($"    {td.Name}::encodeInto(message, buffer);");
+                        builder.AppendLine("    return buffer;");
+                        builder.AppendLine("  }");
+                        builder.AppendLine("");
+                        builder.AppendLine($"  std::vector<uint8_t> encode() const {{ return {td.Name}::encode(*this); }}");
+                        builder.AppendLine("");
                         builder.AppendLine($"  static size_t encodeInto(const {td.Name}& message, std::vector<uint8_t>& targetBuffer) {{");
                         builder.AppendLine("    ::bebop::Writer writer{targetBuffer};");
+                        builder.AppendLine($"    writer.reserve({td.Name}::encodedSize(message));");
+                        builder.AppendLine($"    return {td.Name}::encodeInto(message, writer);");
+                        builder.AppendLine("  }");
+                        builder.AppendLine("");
+                        builder.AppendLine($"  static size_t encodeInto(const {td.Name}& message, ::bebop::ByteBuffer& targetBuffer) {{");
+                        builder.AppendLine("    ::bebop::ByteBufferWriter writer{targetBuffer};");
+                        builder.AppendLine($"    writer.reserve({td.Name}::encodedSize(message));");
                         builder.AppendLine($"    return {td.Name}::encodeInto(message, writer);");
                         builder.AppendLine("  }");
                         builder.AppendLine("");
                         builder.AppendLine($"  template<typename T = ::bebop::Writer> static size_t encodeInto(const {td.Name}& message, T& writer) {{");
+                        builder.AppendLine($"    BEBOP_INSTRUMENT_ENCODE(\"{InstrumentedName(td)}\", writer);");
                         builder.AppendLine("    size_t before = writer.length();");
-                        builder.Append(CompileEncode(td));
+                        builder.AppendLine(CompileEncode(td));
                         builder.AppendLine("    size_t after = writer.length();");
                         builder.AppendLine("    return after - before;");
                         builder.AppendLine("  }");
                         builder.AppendLine("");
                         builder.AppendLine($"  size_t encodeInto(std::vector<uint8_t>& targetBuffer) {{ return {td.Name}::encodeInto(*this, targetBuffer); }}");
-                        builder.AppendLine($"  size_t encodeInto(::bebop::Writer& writer) {{ return {td.Name}::encodeInto(*this, writer); }}");
+                        builder.AppendLine($"  size_t encodeInto(::bebop::ByteBuffer& targetBuffer) {{ return {td.Name}::encodeInto(*this, targetBuffer); }}");
+                        builder.AppendLine($"  template<typename T> size_t encodeInto(T& writer) {{ return {td.Name}::encodeInto(*this, writer); }}");
                         builder.AppendLine("");
-                        builder.AppendLine($"  static {td.Name} decode(const uint8_t* sourceBuffer, size_t sourceBufferSize) {{");
-                        builder.AppendLine($"    {td.Name} result;");
-                        builder.AppendLine($"    {td.Name}::decodeInto(sourceBuffer, sourceBufferSize, result);");
+                        builder.AppendLine($"  static {td.Name} decode(const uint8_t* sourceBuffer, size_t sourceBufferSize{ResourceParameter}) {{");
+                        builder.AppendLine($"    {td.Name} result{(UsePmr ? "{resource}" : "")};");
+                        builder.AppendLine($"    {td.Name}::decodeInto(sourceBuffer, sourceBufferSize, result{ResourceArgument});");
                         builder.AppendLine($"    return result;");
                         builder.AppendLine("  }");
                         builder.AppendLine("");
-                        builder.AppendLine($"  static {td.Name} decode(const std::vector<uint8_t>& sourceBuffer) {{");
-                        builder.AppendLine($"    return {td.Name}::decode(sourceBuffer.data(), sourceBuffer.size());");
+                        builder.AppendLine($"  static {td.Name} decode(const std::vector<uint8_t>& sourceBuffer{ResourceParameter}) {{");
+                        builder.AppendLine($"    return {td.Name}::decode(sourceBuffer.data(), sourceBuffer.size(){ResourceArgument});");
                         builder.AppendLine("  }");
                         builder.AppendLine("");
-                        builder.AppendLine($"  static {td.Name} decode(::bebop::Reader& reader) {{");
-                        builder.AppendLine($"    {td.Name} result;");
-                        builder.AppendLine($"    {td.Name}::decodeInto(reader, result);");
+                        builder.AppendLine($"  template<typename P> static {td.Name} decode(::bebop::BasicReader<P>& reader{ResourceParameter}) {{");
+                        builder.AppendLine($"    {td.Name} result{(UsePmr ? "{resource}" : "")};");
+                        builder.AppendLine($"    {td.Name}::decodeInto(reader, result{ResourceArgument});");
                         builder.AppendLine($"    return result;");
                         builder.AppendLine("  }");
                         builder.AppendLine("");
-                        builder.AppendLine($"  static size_t decodeInto(const uint8_t* sourceBuffer, size_t sourceBufferSize, {td.Name}& target) {{");
+                        builder.AppendLine($"  static size_t decodeInto(const uint8_t* sourceBuffer, size_t sourceBufferSize, {td.Name}& target{ResourceParameter}) {{");
                         builder.AppendLine("    ::bebop::Reader reader{sourceBuffer, sourceBufferSize};");
-                        builder.AppendLine($"    return {td.Name}::decodeInto(reader, target);");
+                        builder.AppendLine($"    return {td.Name}::decodeInto(reader, target{ResourceArgument});");
                         builder.AppendLine("  }");
                         builder.AppendLine("");
-                        builder.AppendLine($"  static size_t decodeInto(const std::vector<uint8_t>& sourceBuffer, {td.Name}& target) {{");
-                        builder.AppendLine($"    return {td.Name}::decodeInto(sourceBuffer.data(), sourceBuffer.size(), target);");
+                        builder.AppendLine($"  static size_t decodeInto(const std::vector<uint8_t>& sourceBuffer, {td.Name}& target{ResourceParameter}) {{");
+                        builder.AppendLine($"    return {td.Name}::decodeInto(sourceBuffer.data(), sourceBuffer.size(), target{ResourceArgument});");
                         builder.AppendLine("  }");
                         builder.AppendLine("");
-                        builder.AppendLine($"  static size_t decodeInto(::bebop::Reader& reader, {td.Name}& target) {{");
-                        builder.Append(CompileDecode(td));
-                        builder.AppendLine("    return reader.bytesRead();");
+                        builder.AppendLine($"  static ::bebop::DecodeResult tryDecodeInto(const uint8_t* sourceBuffer, size_t sourceBufferSize, {td.Name}& target{ResourceParameter}) {{");
+                        builder.AppendLine("    ::bebop::Reader reader{sourceBuffer, sourceBufferSize, ::bebop::ErrorMode::Status};");
+                        builder.AppendLine($"    {td.Name}::decodeInto(reader, target{ResourceArgument});");
+                        builder.AppendLine("    return reader.result();");
+                        builder.AppendLine("  }");
+                        builder.AppendLine("");
+                        builder.AppendLine($"  static ::bebop::DecodeResult tryDecodeInto(const std::vector<uint8_t>& sourceBuffer, {td.Name}& target{ResourceParameter}) {{");
+                        builder.AppendLine($"    return {td.Name}::tryDecodeInto(sourceBuffer.data(), sourceBuffer.size(), target{ResourceArgument});");
+                        builder.AppendLine("  }");
+                        builder.AppendLine("");
+                        builder.AppendLine($"  /// Check that the buffer holds a well-formed `{td.Name}`, without decoding it.");
+                        builder.AppendLine("  static ::bebop::DecodeResult validate(const uint8_t* sourceBuffer, size_t sourceBufferSize) {");
+                        builder.AppendLine("    ::bebop::Reader reader{sourceBuffer, sourceBufferSize, ::bebop::ErrorMode::Status};");
+                        builder.AppendLine($"    {td.Name}::validate(reader);");
+                        builder.AppendLine("    return reader.result();");
+                        builder.AppendLine("  }");
+                        builder.AppendLine("");
+                        builder.AppendLine("  static void validate(::bebop::Reader& reader) {");
+                        builder.AppendLine(CompileValidate(td));
+                        builder.AppendLine("  }");
+                        builder.AppendLine("");
+                        builder.AppendLine($"  /// Decode a buffer that `validate` has accepted, skipping every bounds check.");
+                        builder.AppendLine($"  static {td.Name} decodeUnchecked(const uint8_t* sourceBuffer, size_t sourceBufferSize{ResourceParameter}) {{");
+                        builder.AppendLine($"    {td.Name} result{(UsePmr ? "{resource}" : "")};");
+                        builder.AppendLine($"    {td.Name}::decodeUncheckedInto(sourceBuffer, sourceBufferSize, result{ResourceArgument});");
+                        builder.AppendLine("    return result;");
+                        builder.AppendLine("  }");
+                        builder.AppendLine("");
+                        builder.AppendLine($"  static size_t decodeUncheckedInto(const uint8_t* sourceBuffer, size_t sourceBufferSize, {td.Name}& target{ResourceParameter}) {{");
+                        builder.AppendLine("    ::bebop::UncheckedReader reader{sourceBuffer, sourceBufferSize};");
+                        builder.AppendLine($"    return {td.Name}::decodeInto(reader, target{ResourceArgument});");
                         builder.AppendLine("  }");
                         builder.AppendLine("");
-                        builder.AppendLine("  size_t byteCount() {");
-                        builder.AppendLine("    ::bebop::ByteCounter counter{};");
-                        builder.AppendLine($"    {td.Name}::encodeInto<::bebop::ByteCounter>(*this, counter);");
-                        builder.AppendLine("    return counter.length();");
+                        builder.AppendLine($"  template<typename P> static size_t decodeInto(::bebop::BasicReader<P>& reader, {td.Name}& target{ResourceParameter}) {{");
+                        builder.AppendLine($"    BEBOP_INSTRUMENT_DECODE(\"{InstrumentedName(td)}\", reader);");
+                        builder.AppendLine(CompileDecode(td));
+                        builder.AppendLine("    return reader.bytesRead();");
                         builder.AppendLine("  }");
+                        builder.AppendLine("");
+                        if (td is MessageDefinition md)
+                        {
+                            builder.AppendLine($"  /// Decode the value of the field with the given tag; returns false for a tag this schema does not know.");
+                            builder.AppendLine($"  template<typename P> static bool decodeFieldInto(::bebop::BasicReader<P>& reader, uint8_t tag, {td.Name}& target{ResourceParameter}) {{");
+                            builder.AppendLine(CompileDecodeMessageField(md));
+                            builder.AppendLine("  }");
+                            builder.AppendLine("");
+                        }
+                        builder.AppendLine($"  size_t byteCount() const {{ return {td.Name}::encodedSize(*this); }}");
                         builder.AppendLine("};");
                         builder.AppendLine("");
+                        if (EmitViews)
+                        {
+                            builder.Append(CompileView(td));
+                        }
                         break;
                     case ConstDefinition cd:
                         builder.AppendLine($"const {TypeName(cd.Value.Type)} {cd.Name} = {EmitLiteral(cd.Value)};");
                         builder.AppendLine("");
                         break;
-                    case ServiceDefinition:
+                    case ServiceDefinition service:
+                        if (Config.Services is not TempoServices.None)
+                        {
+                            builder.Append(CompileService(service));
+                        }
                         break;
                     default:
                         throw new InvalidOperationException($"unsupported definition {definition}");
                 }
             }
 
+            var opcodeRecords = Schema.SortedDefinitions().OfType<RecordDefinition>()
+                .Where(d => d.OpcodeDecorator is not null && d.OpcodeDecorator.TryGetValue("fourcc", out _))
+                .Select(d => (d, Convert.ToUInt32(d.OpcodeDecorator!.Arguments["fourcc"], 16)))
+                .ToList();
+            if (opcodeRecords.Count > 0)
+            {
+                builder.AppendLine(CompileOpcodeDispatch(opcodeRecords));
+            }
+
             if (!string.IsNullOrWhiteSpace(Config.Namespace))
             {
                 builder.AppendLine($"}} // namespace {Config.Namespace}");
@@ -0,0 +1,261 @@
+#pragma once
+
+/*
+ * The C half of the benchmark harness. The C runtime has no convenient way
+ * to build sample records by hand, so each c/<schema>.c decodes the samples
+ * that the C++ benchmark of the same schema wrote with --sample-dir, then
+ * times encode, decode, encoded_size and an encode-decode round trip of each
+ * one. It prints one JSON object per measurement on stdout, in the same shape
+ * as the C++ harness, with a readable summary on stderr.
+ *
+ * Every operation runs against a context that is reset after each op, as a
+ * request loop would. Allocations are the arena's calls to malloc.
+ */
+
+/* clock_gettime and syscall; include this before anything else. */
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "gen/c/bebop.h"
+#include "perf_counters.h"
+
+typedef struct {
+  bebop_context_t *context;
+  const uint8_t *encoded;
+  size_t encoded_length;
+  const void *record;
+} bench_state_t;
+
+typedef void (*bench_loop_t)(bench_state_t *state, size_t iterations);
+
+typedef struct {
+  bench_loop_t encode;
+  bench_loop_t decode;
+  bench_loop_t encoded_size;
+  bench_loop_t round_trip;
+  size_t record_size;
+  bebop_result_t (*decode_sample)(bebop_reader_t *reader, void *record);
+} bench_ops_t;
+
+typedef struct {
+  const char *schema;
+  int samples;
+  double min_batch_ns;
+  const char *filter;
+  const char *sample_dir;
+  int perf;
+  bench_perf_t counters;
+} bench_runner_t;
+
+static size_t bench_mallocs = 0;
+
+static void *bench_counting_malloc(size_t size) {
+  bench_mallocs++;
+  return malloc(size);
+}
+
+#if defined(__GNUC__) || defined(__clang__)
+#define bench_do_not_optimize(value) __asm__ volatile("" : : "r,m"(value) : "memory")
+#else
+#define bench_do_not_optimize(value) ((void)(value))
+#endif
+
+static double bench_now_ns(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static void bench_init(bench_runner_t *runner, const char *schema, int argc, char **argv) {
+  *runner = (bench_runner_t){.schema = schema, .samples = 15, .min_batch_ns = 10e6, .sample_dir = "samples"};
+  for (int i = 0; i < BENCH_PERF_COUNTERS; i++) runner->counters.fds[i] = -1;
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--perf") == 0) {
+      runner->perf = bench_perf_open(&runner->counters) > 0;
+      if (!runner->perf) fprintf(stderr, "%s: no hardware counters are available\n", schema);
+    } else if (strcmp(argv[i], "--samples") == 0 && i + 1 < argc) {
+      runner->samples = atoi(argv[++i]);
+      if (runner->samples < 1) runner->samples = 1;
+    } else if (strcmp(argv[i], "--min-time") == 0 && i + 1 < argc) {
+      runner->min_batch_ns = atof(argv[++i]) * 1e6;
+    } else if (strcmp(argv[i], "--filter") == 0 && i + 1 < argc) {
+      runner->filter = argv[++i];
+    } else if (strcmp(argv[i], "--sample-dir") == 0 && i + 1 < argc) {
+      runner->sample_dir = argv[++i];
+    } else {
+      fprintf(stderr, "usage: %s [--samples N] [--min-time MS] [--filter TEXT] [--sample-dir DIR] [--perf]\n", argv[0]);
+      exit(2);
+    }
+  }
+}
+
+static int bench_compare_doubles(const void *a, const void *b) {
+  const double x = *(const double *)a, y = *(const double *)b;
+  return x < y ? -1 : x > y;
+}
+
+static double bench_median(double *sorted, int n) {
+  return n % 2 ? sorted[n / 2] : (sorted[n / 2 - 1] + sorted[n / 2]) / 2;
+}
+
+static void bench_measure(bench_runner_t *runner, const char *record, const char *operation, bench_loop_t loop,
+                          bench_state_t *state) {
+  char id[256];
+  snprintf(id, sizeof(id), "%s/%s/%s", runner->schema, record, operation);
+  if (runner->filter && !strstr(id, runner->filter)) return;
+
+  size_t iterations = 1;
+  for (;;) {
+    const double start = bench_now_ns();
+    loop(state, iterations);
+    const double elapsed = bench_now_ns() - start;
+    if (elapsed >= runner->min_batch_ns) break;
+    double scale = elapsed > 0 ? 1.2 * runner->min_batch_ns / elapsed : 10;
+    if (scale > 10) scale = 10;
+    const size_t next = (size_t)(iterations * scale);
+    iterations = next > iterations ? next : iterations + 1;
+  }
+
+  double *ns = (double *)malloc(sizeof(double) * runner->samples);
+  double *deviations = (double *)malloc(sizeof(double) * runner->samples);
+  for (int s = 0; s < runner->samples; s++) {
+    const double start = bench_now_ns();
+    loop(state, iterations);
+    ns[s] = (bench_now_ns() - start) / iterations;
+  }
+  qsort(ns, runner->samples, sizeof(double), bench_compare_doubles);
+  const double median = bench_median(ns, runner->samples);
+  for (int s = 0; s < runner->samples; s++) deviations[s] = fabs(ns[s] - median);
+  qsort(deviations, runner->samples, sizeof(double), bench_compare_doubles);
+  const double mad = bench_median(deviations, runner->samples);
+
+  const size_t mallocs_before = bench_mallocs;
+  loop(state, iterations);
+  const double allocations = (double)(bench_mallocs - mallocs_before) / iterations;
+
+  int64_t counters[BENCH_PERF_COUNTERS];
+  if (runner->perf) {
+    bench_perf_start(&runner->counters);
+    loop(state, iterations);
+    bench_perf_stop(&runner->counters, counters);
+  }
+
+  const size_t bytes = state->encoded_length;
+  printf("{\"language\":\"c\",\"schema\":\"%s\",\"record\":\"%s\",\"operation\":\"%s\",\"encoded_bytes\":%zu,"
+         "\"iterations\":%zu,\"samples\":%d,\"ns_per_op\":%.3f,\"ns_per_op_mad\":%.3f,\"ns_per_op_min\":%.3f,"
+         "\"ns_per_op_max\":%.3f,\"bytes_per_second\":%.0f,\"allocations_per_op\":%.3f",
+         runner->schema, record, operation, bytes, iterations, runner->samples, median, mad, ns[0],
+         ns[runner->samples - 1], bytes * 1e9 / median, allocations);
+  for (int i = 0; runner->perf && i < BENCH_PERF_COUNTERS; i++) {
+    if (counters[i] >= 0) printf(",\"%s_per_op\":%.3f", bench_perf_names[i], (double)counters[i] / iterations);
+  }
+  printf("}\n");
+  fflush(stdout);
+  fprintf(stderr, "c   %-56s %10.1f ns/op  +-%5.1f  %9.1f MB/s  %6.2f allocs/op\n", id, median, mad,
+          bytes * 1e3 / median, allocations);
+  free(ns);
+  free(deviations);
+}
+
+/* Decode the sample the C++ benchmark wrote for `record`, then time every operation on it. */
+static void bench_run(bench_runner_t *runner, const char *record, const bench_ops_t *ops) {
+  char path[1024];
+  snprintf(path, sizeof(path), "%s/%s.%s.bin", runner->sample_dir, runner->schema, record);
+  FILE *file = fopen(path, "rb");
+  if (!file) {
+    fprintf(stderr, "no sample at %s; run the C++ benchmark with --sample-dir first\n", path);
+    exit(1);
+  }
+  fseek(file, 0, SEEK_END);
+  const size_t length = (size_t)ftell(file);
+  fseek(file, 0, SEEK_SET);
+  uint8_t *encoded = (uint8_t *)malloc(length ? length : 1);
+  if (fread(encoded, 1, length, file) != length) abort();
+  fclose(file);
+
+  bebop_context_t *sample_context = bebop_context_create();
+  void *value = bebop_context_alloc(sample_context, ops->record_size);
+  bebop_reader_t reader;
+  if (!sample_context || !value || bebop_context_get_reader(sample_context, encoded, length, &reader) != BEBOP_OK ||
+      ops->decode_sample(&reader, value) != BEBOP_OK) {
+    fprintf(stderr, "could not decode %s\n", path);
+    exit(1);
+  }
+
+  bebop_context_options_t options = bebop_context_default_options();
+  options.arena_options.allocator.malloc_func = bench_counting_malloc;
+  bench_state_t state = {bebop_context_create_with_options(&options), encoded, length, value};
+  if (!state.context) abort();
+
+  bench_measure(runner, record, "encode", ops->encode, &state);
+  bench_measure(runner, record, "decode", ops->decode, &state);
+  bench_measure(runner, record, "byteCount", ops->encoded_size, &state);
+  bench_measure(runner, record, "roundTrip", ops->round_trip, &state);
+
+  bebop_context_destroy(state.context);
+  bebop_context_destroy(sample_context);
+  free(encoded);
+}
+
+/* Define the timing loops for the generated record type `prefix##_t`. */
+#define BENCH_DEFINE(prefix)                                                                            \
+  static void prefix##_bench_encode(bench_state_t *state, size_t iterations) {                          \
+    for (size_t i = 0; i < iterations; i++) {                                                           \
+      bebop_writer_t writer;                                                                            \
+      if (bebop_context_get_writer(state->context, &writer) != BEBOP_OK ||                              \
+          prefix##_encode_into((const prefix##_t *)state->record, &writer) != BEBOP_OK)                 \
+        abort();                                                                                        \
+      bench_do_not_optimize(writer.current);                                                            \
+      bebop_context_reset(state->context);                                                              \
+    }                                                                                                   \
+  }                                                                                                     \
+  static void prefix##_bench_decode(bench_state_t *state, size_t iterations) {                          \
+    for (size_t i = 0; i < iterations; i++) {                                                           \
+      bebop_reader_t reader;                                                                            \
+      prefix##_t decoded;                                                                               \
+      if (bebop_context_get_reader(state->context, state->encoded, state->encoded_length, &reader) !=   \
+              BEBOP_OK ||                                                                               \
+          prefix##_decode_into(&reader, &decoded) != BEBOP_OK)                                          \
+        abort();                                                                                        \
+      bench_do_not_optimize(decoded);                                                                   \
+      bebop_context_reset(state->context);                                                              \
+    }                                                                                                   \
+  }                                                                                                     \
+  static void prefix##_bench_encoded_size(bench_state_t *state, size_t iterations) {                    \
+    for (size_t i = 0; i < iterations; i++) {                                                           \
+      size_t size = prefix##_encoded_size((const prefix##_t *)state->record);                           \
+      bench_do_not_optimize(size);                                                                      \
+    }                                                                                                   \
+  }                                                                                                     \
+  static void prefix##_bench_round_trip(bench_state_t *state, size_t iterations) {                      \
+    for (size_t i = 0; i < iterations; i++) {                                                           \
+      bebop_writer_t writer;                                                                            \
+      bebop_reader_t reader;                                                                            \
+      prefix##_t decoded;                                                                               \
+      uint8_t *buffer;                                                                                  \
+      size_t length;                                                                                    \
+      if (bebop_context_get_writer(state->context, &writer) != BEBOP_OK ||                              \
+          prefix##_encode_into((const prefix##_t *)state->record, &writer) != BEBOP_OK ||               \
+          bebop_writer_get_buffer(&writer, &buffer, &length) != BEBOP_OK ||                             \
+          bebop_context_get_reader(state->context, buffer, length, &reader) != BEBOP_OK ||              \
+          prefix##_decode_into(&reader, &decoded) != BEBOP_OK)                                          \
+        abort();                                                                                        \
+      bench_do_not_optimize(decoded);                                                                   \
+      bebop_context_reset(state->context);                                                              \
+    }                                                                                                   \
+  }                                                                                                     \
+  static bebop_result_t prefix##_bench_decode_sample(bebop_reader_t *reader, void *record) {            \
+    return prefix##_decode_into(reader, (prefix##_t *)record);                                          \
+  }                                                                                                     \
+  static const bench_ops_t prefix##_bench_ops = {                                                       \
+      prefix##_bench_encode,       prefix##_bench_decode, prefix##_bench_encoded_size,                  \
+      prefix##_bench_round_trip,   sizeof(prefix##_t),    prefix##_bench_decode_sample};
+
+#define BENCH_RUN(runner, prefix, record) bench_run(runner, record, &prefix##_bench_ops)
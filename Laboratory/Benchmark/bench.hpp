@@ -0,0 +1,178 @@
+#pragma once
+
+// The C++ half of the benchmark harness. Each cpp/<schema>.cpp builds sample records and hands them to a
+// Runner, which times encode (into a std::vector and into a bebop::ByteBuffer), decode, byteCount and an
+// encode-decode round trip of each one and prints one JSON object per measurement on stdout, with a readable
+// summary on stderr.
+//
+// Every measurement is calibrated to an iteration count whose batch takes at least --min-time milliseconds,
+// then timed over --samples batches. The median batch is reported along with its median absolute deviation, so
+// a single preempted batch cannot move the result. Allocations are counted through a replaced operator new.
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "perf_counters.h"
+
+namespace bench {
+
+inline size_t allocations = 0;
+
+template<typename T> inline void doNotOptimize(const T& value) { asm volatile("" : : "r,m"(value) : "memory"); }
+
+struct Statistics {
+    double median;
+    double mad;
+    double min;
+    double max;
+};
+
+inline Statistics summarize(std::vector<double> values) {
+    std::sort(values.begin(), values.end());
+    const auto middle = [](const std::vector<double>& sorted) {
+        const size_t n = sorted.size();
+        return n % 2 ? sorted[n / 2] : (sorted[n / 2 - 1] + sorted[n / 2]) / 2;
+    };
+    const double median = middle(values);
+    std::vector<double> deviations;
+    for (double value : values) deviations.push_back(std::fabs(value - median));
+    std::sort(deviations.begin(), deviations.end());
+    return Statistics{median, middle(deviations), values.front(), values.back()};
+}
+
+class Runner {
+public:
+    Runner(const char* schema, int argc, char** argv) : m_schema(schema) {
+        for (int& fd : m_counters.fds) fd = -1;
+        for (int i = 1; i < argc; i++) {
+            const std::string arg = argv[i];
+            if (arg == "--perf") {
+                m_perf = bench_perf_open(&m_counters) > 0;
+                if (!m_perf) fprintf(stderr, "%s: no hardware counters are available\n", schema);
+            } else if (arg == "--samples" && i + 1 < argc) {
+                m_samples = std::max(1, atoi(argv[++i]));
+            } else if (arg == "--min-time" && i + 1 < argc) {
+                m_minBatchNs = atof(argv[++i]) * 1e6;
+            } else if (arg == "--filter" && i + 1 < argc) {
+                m_filter = argv[++i];
+            } else if (arg == "--sample-dir" && i + 1 < argc) {
+                m_sampleDir = argv[++i];
+            } else if (arg == "--write-samples") {
+                m_writeSamplesOnly = true;
+            } else {
+                fprintf(stderr, "usage: %s [--samples N] [--min-time MS] [--filter TEXT] [--sample-dir DIR] [--write-samples] [--perf]\n", argv[0]);
+                exit(2);
+            }
+        }
+    }
+    ~Runner() { bench_perf_close(&m_counters); }
+
+    /// Benchmark every operation on `record`, named `name` in the results.
+    template<typename T> void record(const char* name, const T& record) {
+        const std::vector<uint8_t> encoded = T::encode(record);
+        if (!m_sampleDir.empty()) writeSample(name, encoded);
+        if (m_writeSamplesOnly) return;
+
+        std::vector<uint8_t> buffer;
+        measure(name, "encode", encoded.size(), [&] {
+            buffer.clear();
+            T::encodeInto(record, buffer);
+            doNotOptimize(buffer.data());
+        });
+        bebop::ByteBuffer byteBuffer;
+        measure(name, "encodeByteBuffer", encoded.size(), [&] {
+            byteBuffer.clear();
+            T::encodeInto(record, byteBuffer);
+            doNotOptimize(byteBuffer.data());
+        });
+        measure(name, "decode", encoded.size(), [&] {
+            T decoded;
+            T::decodeInto(encoded, decoded);
+            doNotOptimize(decoded);
+        });
+        measure(name, "byteCount", encoded.size(), [&] { doNotOptimize(record.byteCount()); });
+        measure(name, "roundTrip", encoded.size(), [&] {
+            const auto bytes = T::encode(record);
+            T decoded;
+            T::decodeInto(bytes, decoded);
+            doNotOptimize(decoded);
+        });
+    }
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    template<typename F> static double time(size_t iterations, F& op) {
+        const auto start = Clock::now();
+        for (size_t i = 0; i < iterations; i++) op();
+        return std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+    }
+
+    template<typename F> void measure(const char* record, const char* operation, size_t bytes, F op) {
+        const std::string id = std::string(m_schema) + "/" + record + "/" + operation;
+        if (!m_filter.empty() && id.find(m_filter) == std::string::npos) return;
+
+        size_t iterations = 1;
+        for (double elapsed = time(iterations, op); elapsed < m_minBatchNs; elapsed = time(iterations, op)) {
+            const double scale = elapsed > 0 ? 1.2 * m_minBatchNs / elapsed : 10;
+            iterations = std::max(iterations + 1, static_cast<size_t>(iterations * std::min(scale, 10.0)));
+        }
+        std::vector<double> nsPerOp;
+        for (int sample = 0; sample < m_samples; sample++) nsPerOp.push_back(time(iterations, op) / iterations);
+        const Statistics ns = summarize(nsPerOp);
+
+        const size_t allocationsBefore = allocations;
+        time(iterations, op);
+        const double allocationsPerOp = static_cast<double>(allocations - allocationsBefore) / iterations;
+
+        int64_t counters[BENCH_PERF_COUNTERS];
+        if (m_perf) {
+            bench_perf_start(&m_counters);
+            time(iterations, op);
+            bench_perf_stop(&m_counters, counters);
+        }
+
+        printf("{\"language\":\"cpp\",\"schema\":\"%s\",\"record\":\"%s\",\"operation\":\"%s\",\"encoded_bytes\":%zu,"
+               "\"iterations\":%zu,\"samples\":%d,\"ns_per_op\":%.3f,\"ns_per_op_mad\":%.3f,\"ns_per_op_min\":%.3f,"
+               "\"ns_per_op_max\":%.3f,\"bytes_per_second\":%.0f,\"allocations_per_op\":%.3f",
+            m_schema, record, operation, bytes, iterations, m_samples, ns.median, ns.mad, ns.min, ns.max,
+            bytes * 1e9 / ns.median, allocationsPerOp);
+        for (int i = 0; m_perf && i < BENCH_PERF_COUNTERS; i++) {
+            if (counters[i] >= 0) printf(",\"%s_per_op\":%.3f", bench_perf_names[i], static_cast<double>(counters[i]) / iterations);
+        }
+        printf("}\n");
+        fflush(stdout);
+        fprintf(stderr, "cpp %-56s %10.1f ns/op  +-%5.1f  %9.1f MB/s  %6.2f allocs/op\n", id.c_str(), ns.median, ns.mad,
+            bytes * 1e3 / ns.median, allocationsPerOp);
+    }
+
+    void writeSample(const char* name, const std::vector<uint8_t>& encoded) const {
+        const std::string path = m_sampleDir + "/" + m_schema + "." + name + ".bin";
+        FILE* file = fopen(path.c_str(), "wb");
+        if (!file || fwrite(encoded.data(), 1, encoded.size(), file) != encoded.size()) {
+            fprintf(stderr, "could not write %s\n", path.c_str());
+            exit(1);
+        }
+        fclose(file);
+    }
+
+    const char* m_schema;
+    int m_samples = 15;
+    double m_minBatchNs = 10e6;
+    std::string m_filter;
+    std::string m_sampleDir;
+    bool m_writeSamplesOnly = false;
+    bool m_perf = false;
+    bench_perf_t m_counters;
+};
+
+} // namespace bench
+
+#define COUNT_ALLOCATION() (bench::allocations++)
+#include "../C++/test/count_allocations.hpp"
@@ -0,0 +1,13 @@
+#include "../bench.h"
+#include "../gen/c/album.h"
+
+BENCH_DEFINE(album)
+
+int main(int argc, char **argv) {
+  bench_runner_t runner;
+  bench_init(&runner, "album", argc, argv);
+  BENCH_RUN(&runner, album, "StudioAlbum");
+  BENCH_RUN(&runner, album, "LiveAlbum");
+  bench_perf_close(&runner.counters);
+  return 0;
+}
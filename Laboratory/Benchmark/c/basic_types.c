@@ -0,0 +1,12 @@
+#include "../bench.h"
+#include "../gen/c/basic_types.h"
+
+BENCH_DEFINE(basic_types)
+
+int main(int argc, char **argv) {
+  bench_runner_t runner;
+  bench_init(&runner, "basic_types", argc, argv);
+  BENCH_RUN(&runner, basic_types, "BasicTypes");
+  bench_perf_close(&runner.counters);
+  return 0;
+}
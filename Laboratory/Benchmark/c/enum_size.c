@@ -0,0 +1,12 @@
+#include "../bench.h"
+#include "../gen/c/enum_size.h"
+
+BENCH_DEFINE(small_and_huge)
+
+int main(int argc, char **argv) {
+  bench_runner_t runner;
+  bench_init(&runner, "enum_size", argc, argv);
+  BENCH_RUN(&runner, small_and_huge, "SmallAndHuge");
+  bench_perf_close(&runner.counters);
+  return 0;
+}
@@ -0,0 +1,16 @@
+#include "../bench.h"
+#include "../gen/c/fixed_layout.h"
+
+BENCH_DEFINE(tick)
+BENCH_DEFINE(sample)
+BENCH_DEFINE(sample_batch)
+
+int main(int argc, char **argv) {
+  bench_runner_t runner;
+  bench_init(&runner, "fixed_layout", argc, argv);
+  BENCH_RUN(&runner, tick, "Tick");
+  BENCH_RUN(&runner, sample, "Sample");
+  BENCH_RUN(&runner, sample_batch, "SampleBatch");
+  bench_perf_close(&runner.counters);
+  return 0;
+}
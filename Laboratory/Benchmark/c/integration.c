@@ -0,0 +1,12 @@
+#include "../bench.h"
+#include "../gen/c/integration.h"
+
+BENCH_DEFINE(library)
+
+int main(int argc, char **argv) {
+  bench_runner_t runner;
+  bench_init(&runner, "integration", argc, argv);
+  BENCH_RUN(&runner, library, "Library");
+  bench_perf_close(&runner.counters);
+  return 0;
+}
@@ -0,0 +1,18 @@
+#include "../bench.h"
+#include "../gen/c/jazz.h"
+
+BENCH_DEFINE(musician)
+BENCH_DEFINE(song)
+BENCH_DEFINE(library)
+BENCH_DEFINE(audio_data)
+
+int main(int argc, char **argv) {
+  bench_runner_t runner;
+  bench_init(&runner, "jazz", argc, argv);
+  BENCH_RUN(&runner, musician, "Musician");
+  BENCH_RUN(&runner, song, "Song");
+  BENCH_RUN(&runner, library, "Library");
+  BENCH_RUN(&runner, audio_data, "AudioData");
+  bench_perf_close(&runner.counters);
+  return 0;
+}
@@ -0,0 +1,14 @@
+#include "../bench.h"
+#include "../gen/c/nested_message.h"
+
+BENCH_DEFINE(outer_m)
+BENCH_DEFINE(outer_s)
+
+int main(int argc, char **argv) {
+  bench_runner_t runner;
+  bench_init(&runner, "nested_message", argc, argv);
+  BENCH_RUN(&runner, outer_m, "OuterM");
+  BENCH_RUN(&runner, outer_s, "OuterS");
+  bench_perf_close(&runner.counters);
+  return 0;
+}
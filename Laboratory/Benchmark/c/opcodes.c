@@ -0,0 +1,12 @@
+#include "../bench.h"
+#include "../gen/c/opcodes.h"
+
+BENCH_DEFINE(op00)
+
+int main(int argc, char **argv) {
+  bench_runner_t runner;
+  bench_init(&runner, "opcodes", argc, argv);
+  BENCH_RUN(&runner, op00, "Op00");
+  bench_perf_close(&runner.counters);
+  return 0;
+}
@@ -0,0 +1,12 @@
+#include "../bench.h"
+#include "../gen/c/toposort.h"
+
+BENCH_DEFINE(toposort9)
+
+int main(int argc, char **argv) {
+  bench_runner_t runner;
+  bench_init(&runner, "toposort", argc, argv);
+  BENCH_RUN(&runner, toposort9, "Toposort9");
+  bench_perf_close(&runner.counters);
+  return 0;
+}
@@ -0,0 +1,12 @@
+#include "../bench.h"
+#include "../gen/c/union.h"
+
+BENCH_DEFINE(U)
+
+int main(int argc, char **argv) {
+  bench_runner_t runner;
+  bench_init(&runner, "union", argc, argv);
+  BENCH_RUN(&runner, U, "U");
+  bench_perf_close(&runner.counters);
+  return 0;
+}
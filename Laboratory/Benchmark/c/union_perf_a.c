@@ -0,0 +1,12 @@
+#include "../bench.h"
+#include "../gen/c/union_perf_a.h"
+
+BENCH_DEFINE(union_perf_a)
+
+int main(int argc, char **argv) {
+  bench_runner_t runner;
+  bench_init(&runner, "union_perf_a", argc, argv);
+  BENCH_RUN(&runner, union_perf_a, "UnionPerfA");
+  bench_perf_close(&runner.counters);
+  return 0;
+}
@@ -0,0 +1,66 @@
+#!/usr/bin/env python3
+"""Compare two benchmark result files written by run.sh.
+
+Usage: ./compare.py results/<base>.json results/<head>.json [--threshold PCT] [--fail-on-regression]
+
+A change is reported as a regression or an improvement only when it is larger
+than --threshold percent of the base median (default 5) and larger than twice
+the combined median absolute deviation of both runs, so noisy measurements are
+shown but not flagged.
+"""
+
+import argparse
+import json
+import sys
+
+
+def load(path):
+    with open(path) as f:
+        data = json.load(f)
+    keyed = {}
+    for result in data["results"]:
+        key = (result["language"], result["schema"], result["record"], result["operation"])
+        keyed[key] = result
+    return data, keyed
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Compare two benchmark result files.")
+    parser.add_argument("base")
+    parser.add_argument("head")
+    parser.add_argument("--threshold", type=float, default=5.0, help="smallest change to flag, in percent")
+    parser.add_argument("--fail-on-regression", action="store_true", help="exit with status 1 on any regression")
+    args = parser.parse_args()
+
+    base_data, base = load(args.base)
+    head_data, head = load(args.head)
+    print(f"base {base_data['commit']} ({base_data['date']})  head {head_data['commit']} ({head_data['date']})")
+    print(f"{'benchmark':<56} {'base ns':>10} {'head ns':>10} {'change':>8}  {'allocs':>13}")
+
+    regressions = 0
+    for key in sorted(base.keys() & head.keys()):
+        b, h = base[key], head[key]
+        delta = h["ns_per_op"] - b["ns_per_op"]
+        percent = 100.0 * delta / b["ns_per_op"] if b["ns_per_op"] else 0.0
+        noise = 2.0 * (b["ns_per_op_mad"] + h["ns_per_op_mad"])
+        verdict = ""
+        if abs(percent) >= args.threshold and abs(delta) > noise:
+            verdict = "slower" if delta > 0 else "faster"
+            regressions += delta > 0
+        allocs = f"{b['allocations_per_op']:.2f}->{h['allocations_per_op']:.2f}"
+        if h["allocations_per_op"] > b["allocations_per_op"]:
+            verdict = (verdict + " more-allocs").strip()
+            regressions += 1
+        line = f"{'/'.join(key):<56} {b['ns_per_op']:>10.1f} {h['ns_per_op']:>10.1f} {percent:>+7.1f}%  {allocs:>13}  {verdict}"
+        print(line.rstrip())
+
+    for name, only in (("base", base.keys() - head.keys()), ("head", head.keys() - base.keys())):
+        for key in sorted(only):
+            print(f"{'/'.join(key):<56} only in {name}")
+
+    print(f"{regressions} regression(s)")
+    return 1 if regressions and args.fail_on_regression else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
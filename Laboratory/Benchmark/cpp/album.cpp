@@ -0,0 +1,30 @@
+#include "../gen/cpp/album.hpp"
+#include "../bench.hpp"
+
+static std::vector<Song> makeTracks(size_t count) {
+    std::vector<Song> tracks;
+    for (size_t i = 0; i < count; i++) {
+        Song song;
+        song.title = "Track " + std::to_string(i + 1);
+        song.year = 1959;
+        song.performers = std::vector<Musician>{{"John Coltrane", Instrument::Sax}, {"Tommy Flanagan", Instrument::Clarinet}};
+        tracks.push_back(song);
+    }
+    return tracks;
+}
+
+int main(int argc, char** argv) {
+    bench::Runner run{"album", argc, argv};
+    Album studio;
+    studio.variant = StudioAlbum{makeTracks(7)};
+    run.record("StudioAlbum", studio);
+
+    LiveAlbum live;
+    live.tracks = makeTracks(12);
+    live.venueName = "Village Vanguard";
+    live.concertDate = bebop::TickDuration{630000000000000000};
+    Album album;
+    album.variant = live;
+    run.record("LiveAlbum", album);
+    return 0;
+}
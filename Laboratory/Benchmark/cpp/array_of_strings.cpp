@@ -0,0 +1,10 @@
+#include "../gen/cpp/array_of_strings.hpp"
+#include "../bench.hpp"
+
+int main(int argc, char** argv) {
+    bench::Runner run{"array_of_strings", argc, argv};
+    ArrayOfStrings strings;
+    for (int i = 0; i < 256; i++) strings.strings.push_back("string number " + std::to_string(i));
+    run.record("ArrayOfStrings", strings);
+    return 0;
+}
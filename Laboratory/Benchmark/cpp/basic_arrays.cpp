@@ -0,0 +1,27 @@
+#include "../gen/cpp/basic_arrays.hpp"
+#include "../bench.hpp"
+
+int main(int argc, char** argv) {
+    bench::Runner run{"basic_arrays", argc, argv};
+    BasicArrays arrays;
+    for (int i = 0; i < 64; i++) {
+        arrays.a_bool.push_back(i % 2);
+        arrays.a_byte.push_back(static_cast<uint8_t>(i));
+        arrays.a_int16.push_back(static_cast<int16_t>(-i));
+        arrays.a_uint16.push_back(static_cast<uint16_t>(i));
+        arrays.a_int32.push_back(-i * 1000);
+        arrays.a_uint32.push_back(i * 1000);
+        arrays.a_int64.push_back(-i * 1000000000LL);
+        arrays.a_uint64.push_back(i * 1000000000ULL);
+        arrays.a_float32.push_back(i / 3.0f);
+        arrays.a_float64.push_back(i / 3.0);
+        arrays.a_string.push_back("item " + std::to_string(i));
+        arrays.a_guid.push_back(bebop::Guid::fromString("81c6987b-48b7-495f-ad01-ec20cc5f5be1"));
+    }
+    run.record("BasicArrays", arrays);
+
+    TestInt32Array ints;
+    for (int i = 0; i < 4096; i++) ints.a.push_back(i * 7919);
+    run.record("TestInt32Array", ints);
+    return 0;
+}
@@ -0,0 +1,22 @@
+#include "../gen/cpp/basic_types.hpp"
+#include "../bench.hpp"
+
+int main(int argc, char** argv) {
+    bench::Runner run{"basic_types", argc, argv};
+    BasicTypes types;
+    types.a_bool = true;
+    types.a_byte = 200;
+    types.a_int16 = -12345;
+    types.a_uint16 = 54321;
+    types.a_int32 = -1234567890;
+    types.a_uint32 = 3234567890u;
+    types.a_int64 = -1234567890123456789LL;
+    types.a_uint64 = 12345678901234567890ULL;
+    types.a_float32 = 3.14159f;
+    types.a_float64 = 2.718281828459045;
+    types.a_string = "Hello, Bebop!";
+    types.a_guid = bebop::Guid::fromString("81c6987b-48b7-495f-ad01-ec20cc5f5be1");
+    types.a_date = bebop::TickDuration{630000000000000000};
+    run.record("BasicTypes", types);
+    return 0;
+}
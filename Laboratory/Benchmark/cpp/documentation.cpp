@@ -0,0 +1,13 @@
+#include "../gen/cpp/documentation.hpp"
+#include "../bench.hpp"
+
+int main(int argc, char** argv) {
+    bench::Runner run{"documentation", argc, argv};
+    DocM message;
+    message.x = 1;
+    message.y = 2;
+    message.z = 3;
+    run.record("DocM", message);
+    run.record("DocS", DocS{42});
+    return 0;
+}
@@ -0,0 +1,8 @@
+#include "../gen/cpp/enum_size.hpp"
+#include "../bench.hpp"
+
+int main(int argc, char** argv) {
+    bench::Runner run{"enum_size", argc, argv};
+    run.record("SmallAndHuge", SmallAndHuge{SmallEnum::B, HugeEnum::MaxInt});
+    return 0;
+}
@@ -0,0 +1,17 @@
+#include "../gen/cpp/fixed_layout.hpp"
+#include "../bench.hpp"
+
+int main(int argc, char** argv) {
+    bench::Runner run{"fixed_layout", argc, argv};
+    const auto session = bebop::Guid::fromString("81c6987b-48b7-495f-ad01-ec20cc5f5be1");
+    SampleBatch batch;
+    for (uint32_t i = 0; i < 256; i++) {
+        const Tick tick{i, static_cast<int32_t>(10000 + i), i * 0.5f, i & 7};
+        batch.ticks.push_back(tick);
+        batch.samples.push_back(Sample{i, static_cast<Channel>(i % 3), session, bebop::TickDuration{630000000000000000 + i}, 0.75, i % 5 == 0, tick});
+    }
+    run.record("Tick", batch.ticks[0]);
+    run.record("Sample", batch.samples[0]);
+    run.record("SampleBatch", batch);
+    return 0;
+}
@@ -0,0 +1,11 @@
+#include "../gen/cpp/imports.hpp"
+#include "../bench.hpp"
+
+int main(int argc, char** argv) {
+    bench::Runner run{"imports", argc, argv};
+    Band band;
+    for (int i = 0; i < 5; i++) band.members.push_back(Musician{"Member " + std::to_string(i), static_cast<Instrument>(i % 3)});
+    run.record("Band", band);
+    run.record("Something", Something{DocE::X});
+    return 0;
+}
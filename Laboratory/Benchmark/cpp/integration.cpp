@@ -0,0 +1,9 @@
+#include "../../Integration/makelib.hpp"
+#include "../bench.hpp"
+
+// The Library that the cross-language integration test encodes.
+int main(int argc, char** argv) {
+    bench::Runner run{"integration", argc, argv};
+    run.record("Library", make_library());
+    return 0;
+}
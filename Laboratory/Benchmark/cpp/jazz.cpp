@@ -0,0 +1,32 @@
+#include "../gen/cpp/jazz.hpp"
+#include "../bench.hpp"
+
+static Song makeSong(size_t performers) {
+    Song song;
+    song.title = "A Night in Tunisia";
+    song.year = 1942;
+    song.performers.emplace();
+    for (size_t i = 0; i < performers; i++) {
+        song.performers->push_back(Musician{"Musician #" + std::to_string(i), static_cast<Instrument>(i % 3)});
+    }
+    return song;
+}
+
+int main(int argc, char** argv) {
+    bench::Runner run{"jazz", argc, argv};
+    run.record("Musician", Musician{"Dizzy Gillespie", Instrument::Trumpet});
+    run.record("Song", makeSong(8));
+
+    Library library;
+    for (int i = 0; i < 64; i++) {
+        auto id = bebop::Guid::fromString("81c6987b-48b7-495f-ad01-ec20cc5f5be1");
+        id.m_a = static_cast<uint32_t>(i);
+        library.songs.emplace(id, makeSong(i % 5));
+    }
+    run.record("Library", library);
+
+    AudioData audio;
+    for (int i = 0; i < 4096; i++) audio.samples.push_back(static_cast<float>(i % 100) / 100.0f);
+    run.record("AudioData", audio);
+    return 0;
+}
@@ -0,0 +1,28 @@
+#include "../gen/cpp/lab.hpp"
+#include "../bench.hpp"
+
+int main(int argc, char** argv) {
+    bench::Runner run{"lab", argc, argv};
+    Int32s int32s;
+    Float64s float64s;
+    for (int i = 0; i < 4096; i++) {
+        int32s.a.push_back(i * 7919);
+        float64s.a.push_back(i / 7.0);
+    }
+    run.record("Int32s", int32s);
+    run.record("Float64s", float64s);
+
+    MediaMessage media;
+    media.codec = VideoCodec::H265;
+    media.data = VideoData{12.5, 1920, 1080, std::vector<uint8_t>(16384, 0x5a)};
+    run.record("MediaMessage", media);
+
+    SkipTestNewContainer container;
+    container.s = SkipTestNew{};
+    container.s->x = 1;
+    container.s->y = 2;
+    container.s->z = 3;
+    container.after = 4;
+    run.record("SkipTestNewContainer", container);
+    return 0;
+}
@@ -0,0 +1,26 @@
+#include "../gen/cpp/map_types.hpp"
+#include "../bench.hpp"
+
+int main(int argc, char** argv) {
+    bench::Runner run{"map_types", argc, argv};
+    SomeMaps maps;
+    maps.m1 = {{true, false}, {false, true}};
+    for (int i = 0; i < 8; i++) {
+        auto& inner = maps.m2["outer " + std::to_string(i)];
+        for (int j = 0; j < 8; j++) inner["key " + std::to_string(j)] = "value " + std::to_string(i * j);
+    }
+    maps.m3.resize(4);
+    for (int i = 0; i < 4; i++) maps.m3[i][i] = {{{true, S{i, -i}}, {false, S{-i, i}}}};
+    maps.m4.resize(4);
+    for (int i = 0; i < 4; i++) maps.m4[i]["floats"] = std::vector<float>(32, i / 2.0f);
+    for (int i = 0; i < 16; i++) {
+        auto id = bebop::Guid::fromString("81c6987b-48b7-495f-ad01-ec20cc5f5be1");
+        id.m_a = static_cast<uint32_t>(i);
+        M m;
+        m.a = i / 3.0f;
+        m.b = i / 7.0;
+        maps.m5[id] = m;
+    }
+    run.record("SomeMaps", maps);
+    return 0;
+}
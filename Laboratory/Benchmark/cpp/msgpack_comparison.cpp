@@ -0,0 +1,31 @@
+#include "../gen/cpp/msgpack_comparison.hpp"
+#include "../bench.hpp"
+
+// The values of msgpack-javascript's benchmark-from-msgpack-lite-data.json, as the schema's comments describe.
+int main(int argc, char** argv) {
+    bench::Runner run{"msgpack_comparison", argc, argv};
+    MsgpackComparison value;
+    value.ant0 = 0;
+    value.ant1 = 1;
+    value.ant1x = -1;
+    value.ant8 = 255;
+    value.ant8x = -255;
+    value.ant16 = 256;
+    value.ant16x = -256;
+    value.ant32 = 65536;
+    value.ant32x = -65536;
+    value.arue = true;
+    value.aalse = false;
+    value.aloat = 0.5;
+    value.aloatx = -0.5;
+    value.atring0 = "";
+    value.atring1 = "A";
+    value.atring4 = "foobarbaz";
+    value.atring8 = "Omnes viae Romam ducunt.";
+    value.atring16 = "L’homme n’est qu’un roseau, le plus faible de la nature ; mais c’est un roseau pensant. Il ne faut "
+                     "pas que l’univers entier s’arme pour l’écraser : une vapeur, une goutte d’eau, suffit pour le tuer.";
+    value.array1 = {"foo"};
+    for (int i = 0; i < 8; i++) value.array8.push_back(1 << i);
+    run.record("MsgpackComparison", value);
+    return 0;
+}
@@ -0,0 +1,14 @@
+#include "../gen/cpp/nested_message.hpp"
+#include "../bench.hpp"
+
+int main(int argc, char** argv) {
+    bench::Runner run{"nested_message", argc, argv};
+    InnerM inner;
+    inner.x = 42;
+    OuterM outer;
+    outer.innerM = inner;
+    outer.innerS = InnerS{true};
+    run.record("OuterM", outer);
+    run.record("OuterS", OuterS{inner, InnerS{true}});
+    return 0;
+}
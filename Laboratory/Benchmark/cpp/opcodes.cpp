@@ -0,0 +1,10 @@
+#include "../gen/cpp/opcodes.hpp"
+#include "../bench.hpp"
+
+int main(int argc, char** argv) {
+    bench::Runner run{"opcodes", argc, argv};
+    Op00 op;
+    op.value = 123456;
+    run.record("Op00", op);
+    return 0;
+}
@@ -0,0 +1,16 @@
+#include "../gen/cpp/request.hpp"
+#include "../bench.hpp"
+
+int main(int argc, char** argv) {
+    bench::Runner run{"request", argc, argv};
+    RequestCatalog catalog;
+    catalog.family = FurnitureFamily::Table;
+    run.record("RequestCatalog", catalog);
+
+    RequestResponse response;
+    for (uint32_t i = 0; i < 32; i++) {
+        response.availableFurniture.push_back(Furniture{"Furniture #" + std::to_string(i), 1000 + i, static_cast<FurnitureFamily>(i % 3)});
+    }
+    run.record("RequestResponse", response);
+    return 0;
+}
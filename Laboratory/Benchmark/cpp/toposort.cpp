@@ -0,0 +1,10 @@
+#include "../gen/cpp/toposort.hpp"
+#include "../bench.hpp"
+
+int main(int argc, char** argv) {
+    bench::Runner run{"toposort", argc, argv};
+    Toposort9 nested;
+    nested.x.x.x.x.x.x.x.x.x.x = 7;
+    run.record("Toposort9", nested);
+    return 0;
+}
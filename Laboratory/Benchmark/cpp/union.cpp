@@ -0,0 +1,12 @@
+#include "../gen/cpp/union.hpp"
+#include "../bench.hpp"
+
+int main(int argc, char** argv) {
+    bench::Runner run{"union", argc, argv};
+    InnerM2 inner;
+    inner.x = 42;
+    U u;
+    u.variant = D{inner};
+    run.record("U", u);
+    return 0;
+}
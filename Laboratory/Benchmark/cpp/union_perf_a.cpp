@@ -0,0 +1,19 @@
+#include "../gen/cpp/union_perf_a.hpp"
+#include "../bench.hpp"
+
+int main(int argc, char** argv) {
+    bench::Runner run{"union_perf_a", argc, argv};
+    A14 inner;
+    inner.i14 = 1;
+    inner.u = 11111;
+    inner.f = 3.14;
+    inner.s = "yeah";
+    inner.g = bebop::Guid::fromString("81c6987b-48b7-495f-ad01-ec20cc5f5be1");
+    inner.b = true;
+    UnionPerfA a;
+    a.containerOpcode = 123;
+    a.protocolVersion = 456;
+    a.u.variant.emplace<A14>(inner);
+    run.record("UnionPerfA", a);
+    return 0;
+}
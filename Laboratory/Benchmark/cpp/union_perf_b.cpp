@@ -0,0 +1,19 @@
+#include "../gen/cpp/union_perf_b.hpp"
+#include "../bench.hpp"
+
+int main(int argc, char** argv) {
+    bench::Runner run{"union_perf_b", argc, argv};
+    B41 inner;
+    inner.i41 = 1;
+    inner.u = 11111;
+    inner.f = 3.14;
+    inner.s = "yeah";
+    inner.g = bebop::Guid::fromString("81c6987b-48b7-495f-ad01-ec20cc5f5be1");
+    inner.b = true;
+    UnionPerfB b;
+    b.protocolVersion = 456;
+    b.incomingOpcode = 41;
+    b.encodedData = B41::encode(inner);
+    run.record("UnionPerfB", b);
+    return 0;
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+/*
+ * Hardware counters for the C and C++ benchmark harnesses, read through
+ * Linux perf_event_open. Counters that cannot be opened (another OS, a
+ * container without perf access, perf_event_paranoid) are simply absent
+ * from the results.
+ */
+
+#include <stdint.h>
+#include <string.h>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#define BENCH_PERF_COUNTERS 4
+
+static const char *const bench_perf_names[BENCH_PERF_COUNTERS] = {
+    "instructions", "cycles", "cache_misses", "branch_misses"};
+
+typedef struct {
+  int fds[BENCH_PERF_COUNTERS];
+} bench_perf_t;
+
+/* Open every counter that is available. Returns how many were opened. */
+static int bench_perf_open(bench_perf_t *perf) {
+  int opened = 0;
+  for (int i = 0; i < BENCH_PERF_COUNTERS; i++) perf->fds[i] = -1;
+#ifdef __linux__
+  static const uint64_t configs[BENCH_PERF_COUNTERS] = {
+      PERF_COUNT_HW_INSTRUCTIONS, PERF_COUNT_HW_CPU_CYCLES,
+      PERF_COUNT_HW_CACHE_MISSES, PERF_COUNT_HW_BRANCH_MISSES};
+  for (int i = 0; i < BENCH_PERF_COUNTERS; i++) {
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.config = configs[i];
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    perf->fds[i] = (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+    if (perf->fds[i] >= 0) opened++;
+  }
+#endif
+  return opened;
+}
+
+static void bench_perf_start(bench_perf_t *perf) {
+#ifdef __linux__
+  for (int i = 0; i < BENCH_PERF_COUNTERS; i++) {
+    if (perf->fds[i] < 0) continue;
+    ioctl(perf->fds[i], PERF_EVENT_IOC_RESET, 0);
+    ioctl(perf->fds[i], PERF_EVENT_IOC_ENABLE, 0);
+  }
+#else
+  (void)perf;
+#endif
+}
+
+/* Stop counting and read each counter into `values`; -1 for a counter that is not open. */
+static void bench_perf_stop(bench_perf_t *perf, int64_t values[BENCH_PERF_COUNTERS]) {
+  for (int i = 0; i < BENCH_PERF_COUNTERS; i++) {
+    values[i] = -1;
+#ifdef __linux__
+    uint64_t value;
+    if (perf->fds[i] < 0) continue;
+    ioctl(perf->fds[i], PERF_EVENT_IOC_DISABLE, 0);
+    if (read(perf->fds[i], &value, sizeof(value)) == sizeof(value)) values[i] = (int64_t)value;
+#endif
+  }
+}
+
+static void bench_perf_close(bench_perf_t *perf) {
+  for (int i = 0; i < BENCH_PERF_COUNTERS; i++) {
+#ifdef __linux__
+    if (perf->fds[i] >= 0) close(perf->fds[i]);
+#endif
+    perf->fds[i] = -1;
+  }
+}
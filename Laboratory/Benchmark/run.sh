@@ -0,0 +1,89 @@
+#!/usr/bin/env bash
+# Usage: ./run.sh [--perf] [--samples N] [--min-time MS] [--filter TEXT] [--no-c] [--no-cpp]
+#
+# Builds a benchmark per schema for each language, runs them, and merges their
+# JSON lines into results/<commit>.json. Compare two runs with compare.py.
+set -e
+cd "$(dirname "$0")"
+
+args=()
+run_cpp=1
+run_c=1
+while [ $# -gt 0 ]; do
+  case "$1" in
+    --perf) args+=("$1") ;;
+    --samples|--min-time|--filter) args+=("$1" "$2"); shift ;;
+    --no-c) run_c=0 ;;
+    --no-cpp) run_cpp=0 ;;
+    *) >&2 echo "unknown option $1"; exit 2 ;;
+  esac
+  shift
+done
+
+if [ -e /proc/version ] && grep -q Microsoft /proc/version; then
+  # Windows: Visual Studio + WSL to run this script
+  bebopc="../../bin/compiler/Windows-Debug/bebopc.exe"
+else
+  # Linux or Mac
+  bebopc="dotnet run --project ../../Compiler"
+fi
+
+mkdir -p gen/cpp gen/c build samples results
+cp ../../Runtime/C++/src/bebop.hpp gen/cpp/
+cp ../../Runtime/C/src/bebop.h ../../Runtime/C/src/bebop.c gen/c/
+
+schema_path() {
+  # The integration fixture reuses the record built by ../Integration/makelib.hpp
+  if [ "$1" = integration ]; then echo ../Integration/schema.bop; else echo "../Schemas/Valid/$1.bop"; fi
+}
+
+# The C++ benchmarks write the samples the C benchmarks decode, so they are built
+# and run first even with --no-cpp, which only skips timing them.
+for fixture in cpp/*.cpp; do
+  schema=$(basename "$fixture" .cpp)
+  header=$schema
+  [ "$schema" = integration ] && header=schema
+  $bebopc --include "$(schema_path "$schema")" build --generator "cpp:gen/cpp/$header.hpp" > /dev/null
+  g++ -std=c++17 -O3 -march=native -DNDEBUG -Wall -I gen/cpp -o "build/cpp_$schema" "$fixture"
+done
+if [ $run_c = 1 ]; then
+  for fixture in c/*.c; do
+    schema=$(basename "$fixture" .c)
+    $bebopc --include "$(schema_path "$schema")" build --generator "c:gen/c/$schema.c" > /dev/null
+    gcc -std=c11 -O3 -march=native -DNDEBUG -Wall -I gen/c -o "build/c_$schema" "$fixture" "gen/c/$schema.c" gen/c/bebop.c -lm
+  done
+fi
+
+lines=$(mktemp)
+trap 'rm -f "$lines"' EXIT
+if [ $run_cpp = 0 ] && [ $run_c = 1 ]; then
+  for binary in build/cpp_*; do
+    "$binary" --write-samples --sample-dir samples
+  done
+fi
+languages=()
+[ $run_cpp = 1 ] && languages+=(cpp)
+[ $run_c = 1 ] && languages+=(c)
+for language in "${languages[@]}"; do
+  for binary in build/"$language"_*; do
+    "$binary" "${args[@]}" --sample-dir samples >> "$lines"
+  done
+done
+
+commit=$(git rev-parse --short HEAD 2>/dev/null || echo unknown)
+output="results/$commit.json"
+python3 - "$lines" "$output" "$commit" <<'PY'
+import datetime, json, platform, sys
+lines, output, commit = sys.argv[1:]
+with open(lines) as f:
+    results = [json.loads(line) for line in f if line.strip()]
+with open(output, "w") as f:
+    json.dump({
+        "commit": commit,
+        "date": datetime.datetime.now(datetime.timezone.utc).isoformat(timespec="seconds"),
+        "machine": platform.machine(),
+        "results": results,
+    }, f, indent=1)
+    f.write("\n")
+PY
+>&2 echo "Wrote $output"
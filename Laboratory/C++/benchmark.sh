@@ -0,0 +1,32 @@
+#!/usr/bin/env bash
+# Usage: ./benchmark.sh <schema> [bench] [generator options]
+set -e
+schema=$1
+bench=${2:-$1_bench}
+options=${3:+,$3}
+>&2 echo "Timing bebopc:"
+
+if [ -e /proc/version ] && grep -q Microsoft /proc/version; then
+  # Windows: Visual Studio + WSL to run this script
+  bebopc="../../bin/compiler/Windows-Debug/bebopc.exe"
+else
+  # Linux or Mac
+  bebopc="dotnet run --project ../../Compiler"
+fi
+# Schemas that only some generators support live outside Valid/
+path="../Schemas/Valid/$schema.bop"
+[ -e "$path" ] || path="../Schemas/$schema.bop"
+$bebopc --include "$path" build --generator "cpp:gen/$schema.hpp$options"
+rm "$bench".out || true
+>&2 echo "Timing C++ compiler:"
+time g++ \
+  -std=c++17 \
+  -O3 \
+  -march=native \
+  -DNDEBUG \
+  -Wall \
+  -pthread \
+  -o "$bench".out \
+  test/"$bench".cpp
+
+./"$bench".out
@@ -1,5 +1,9 @@
 #!/usr/bin/env bash
+# Usage: ./run_test.sh <schema> [test] [generator options]
 set -e
+schema=$1
+test=${2:-$1}
+options=${3:+,$3}
 >&2 echo "Timing bebopc:"
 
 if [ -e /proc/version ] && grep -q Microsoft /proc/version; then
@@ -9,7 +13,10 @@ else
   # Linux or Mac
   bebopc="dotnet run --project ../../Compiler"
 fi
-$bebopc --include "../Schemas/Valid/$1.bop" build --generator "cpp:gen/$1.hpp"
+# Schemas that only some generators support live outside Valid/
+path="../Schemas/Valid/$schema.bop"
+[ -e "$path" ] || path="../Schemas/$schema.bop"
+$bebopc --include "$path" build --generator "cpp:gen/$schema.hpp$options"
 >&2 echo "Timing C++ compiler:"
-time g++ -std=c++17 test/$1.cpp
+time g++ -std=c++17 ${CXXFLAGS:-} test/$test.cpp
 ./a.out
@@ -1,4 +1,5 @@
 #include "../gen/basic_arrays.hpp"
+#include <cassert>
 #include <cstdlib>
 
 int main(int argc, char **argv) {
@@ -6,5 +7,15 @@ int main(int argc, char **argv) {
     std::vector<uint8_t> vec {};
     a.encodeInto(vec);
     assert(vec.size() == a.byteCount());
+
+    BasicArrays b;
+    b.a_bool = {true, false};
+    b.a_int64 = {1, 2, 3};
+    b.a_string = {"", "hello", "world"};
+    b.a_guid = {bebop::Guid::fromString("81c6987b-48b7-495f-ad01-ec20cc5f5be1")};
+    bebop::ByteCounter counter{};
+    BasicArrays::encodeInto(b, counter);
+    assert(b.encodedSize() == counter.length());
+    assert(b.encode().size() == counter.length());
     return 0;
 }
@@ -0,0 +1,85 @@
+#include "../gen/basic_arrays.hpp"
+#include <cassert>
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+// The element-at-a-time decoding that CPlusPlusGenerator emitted before scalar arrays were copied in bulk.
+template<typename T, typename F> static void decodeArrayPerElement(bebop::Reader& reader, std::vector<T>& target, F readElement) {
+    const auto length = reader.readUint32();
+    target = std::vector<T>();
+    target.reserve(length);
+    for (size_t i = 0; i < length; i++) {
+        T x = readElement();
+        target.push_back(x);
+    }
+}
+
+static void decodePerElement(bebop::Reader& reader, BasicArrays& target) {
+    decodeArrayPerElement(reader, target.a_bool, [&] { return reader.readBool(); });
+    decodeArrayPerElement(reader, target.a_byte, [&] { return reader.readByte(); });
+    decodeArrayPerElement(reader, target.a_int16, [&] { return reader.readInt16(); });
+    decodeArrayPerElement(reader, target.a_uint16, [&] { return reader.readUint16(); });
+    decodeArrayPerElement(reader, target.a_int32, [&] { return reader.readInt32(); });
+    decodeArrayPerElement(reader, target.a_uint32, [&] { return reader.readUint32(); });
+    decodeArrayPerElement(reader, target.a_int64, [&] { return reader.readInt64(); });
+    decodeArrayPerElement(reader, target.a_uint64, [&] { return reader.readUint64(); });
+    decodeArrayPerElement(reader, target.a_float32, [&] { return reader.readFloat32(); });
+    decodeArrayPerElement(reader, target.a_float64, [&] { return reader.readFloat64(); });
+    decodeArrayPerElement(reader, target.a_string, [&] { return reader.readString(); });
+    decodeArrayPerElement(reader, target.a_guid, [&] { return reader.readGuid(); });
+}
+
+template<typename F> static double nsPerOp(int iterations, F f) {
+    const auto t1 = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; i++) f();
+    const auto t2 = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::nano>(t2 - t1).count() / iterations;
+}
+
+int main() {
+    BasicArrays b;
+    const auto guid = bebop::Guid::fromString("81c6987b-48b7-495f-ad01-ec20cc5f5be1");
+    for (int i = 0; i < 4096; i++) {
+        b.a_bool.push_back(i % 3 == 0);
+        b.a_byte.push_back(i);
+        b.a_int16.push_back(-i);
+        b.a_uint16.push_back(i);
+        b.a_int32.push_back(-i * 1000);
+        b.a_uint32.push_back(i * 1000);
+        b.a_int64.push_back(-i * 1000000LL);
+        b.a_uint64.push_back(i * 1000000ULL);
+        b.a_float32.push_back(i / 4.0f);
+        b.a_float64.push_back(i / 3.0);
+        b.a_guid.push_back(guid);
+    }
+    b.a_string = std::vector<std::string>(64, "hello");
+    const auto buffer = b.encode();
+
+    BasicArrays bulk, perElement;
+    BasicArrays::decodeInto(buffer, bulk);
+    bebop::Reader reader{buffer.data(), buffer.size()};
+    decodePerElement(reader, perElement);
+    assert(bulk.encode() == buffer);
+    assert(perElement.encode() == buffer);
+    assert(bulk.a_guid[4095] == guid && bulk.a_bool == b.a_bool && bulk.a_float64 == b.a_float64);
+    assert(BasicArrays::validate(buffer.data(), buffer.size()));
+    BasicArrays unchecked;
+    BasicArrays::decodeUncheckedInto(buffer.data(), buffer.size(), unchecked);
+    assert(unchecked.encode() == buffer);
+
+    const int iterations = 2000;
+    const double bulkNs = nsPerOp(iterations, [&] { BasicArrays::decodeInto(buffer, bulk); });
+    const double perElementNs = nsPerOp(iterations, [&] {
+        bebop::Reader reader{buffer.data(), buffer.size()};
+        decodePerElement(reader, perElement);
+    });
+
+    const double validateNs = nsPerOp(iterations, [&] { BasicArrays::validate(buffer.data(), buffer.size()); });
+    const double uncheckedNs = nsPerOp(iterations, [&] { BasicArrays::decodeUncheckedInto(buffer.data(), buffer.size(), unchecked); });
+
+    printf("BasicArrays with 4096 elements per scalar array (%zu bytes)\n", buffer.size());
+    printf("decode: generated %10.0f ns/op, per-element %10.0f ns/op (%.1fx)\n", bulkNs, perElementNs, perElementNs / bulkNs);
+    printf("validate %10.0f ns/op + decodeUnchecked %10.0f ns/op\n", validateNs, uncheckedNs);
+    return 0;
+}
@@ -0,0 +1,25 @@
+// Counts every heap allocation the program makes by replacing the global operator new and delete.
+// Include it from the one translation unit that holds main. To count somewhere other than
+// `allocations`, define COUNT_ALLOCATION() before including it.
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+#ifndef COUNT_ALLOCATION
+inline std::atomic<size_t> allocations{0};
+#define COUNT_ALLOCATION() allocations.fetch_add(1, std::memory_order_relaxed)
+#endif
+
+void* operator new(size_t size) {
+    COUNT_ALLOCATION();
+    if (void* pointer = malloc(size ? size : 1)) return pointer;
+    throw std::bad_alloc();
+}
+// GCC sees the inlined malloc behind operator new and flags the matching free as a mismatch.
+#if defined(__GNUC__) && !defined(__clang__) && __GNUC__ >= 11
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+void operator delete(void* pointer) noexcept { free(pointer); }
+void operator delete(void* pointer, size_t) noexcept { free(pointer); }
@@ -0,0 +1,29 @@
+#include "../gen/empty_struct_field.hpp"
+#include <cassert>
+#include <cstdio>
+#include <vector>
+
+int main() {
+    // The empty struct takes no bytes on the wire, but a byte in the C++ struct.
+    static_assert(sizeof(Bracketed::Packed) == 6, "only `before` and `after` are packed");
+    static_assert(!Bracketed::hasWireLayout(), "Bracketed has a member that is not on the wire");
+
+    Bracketed b{0x01020304, Nothing{}, 0x0506};
+    const std::vector<uint8_t> expected = {0x04, 0x03, 0x02, 0x01, 0x06, 0x05};
+    assert(Bracketed::encode(b) == expected);
+    const Bracketed decoded = Bracketed::decode(expected);
+    assert(decoded.before == b.before && decoded.after == b.after);
+
+    Hollow h;
+    assert(Hollow::encode(h).empty());
+
+    BracketedBatch batch;
+    for (uint16_t i = 0; i < 100; i++) batch.items.push_back(Bracketed{i * 7u, Nothing{}, i});
+    const auto buf = BracketedBatch::encode(batch);
+    assert(buf.size() == 4 + 6 * 100);
+    const auto batch2 = BracketedBatch::decode(buf);
+    assert(batch2.items.size() == 100);
+    for (uint16_t i = 0; i < 100; i++) assert(batch2.items[i].before == i * 7u && batch2.items[i].after == i);
+
+    printf("empty struct fields are left out of the packed layout\n");
+}
@@ -0,0 +1,136 @@
+#include "../gen/fixed_layout.hpp"
+#include <cassert>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+// The per-field encoding that CPlusPlusGenerator emitted before fixed-size structs had a packed fast path.
+static void encodeTickPerField(const Tick& t, bebop::Writer& writer) {
+    writer.writeUint32(t.sequence);
+    writer.writeInt32(t.price);
+    writer.writeFloat32(t.volume);
+    writer.writeUint32(t.flags);
+}
+
+static void encodeSamplePerField(const Sample& s, bebop::Writer& writer) {
+    writer.writeUint32(s.id);
+    writer.writeUint16(static_cast<uint16_t>(s.channel));
+    writer.writeGuid(s.session);
+    writer.writeDate(s.recorded);
+    writer.writeFloat64(s.gain);
+    writer.writeBool(s.muted);
+    encodeTickPerField(s.tick, writer);
+}
+
+static void encodeBatchPerField(const SampleBatch& b, bebop::Writer& writer) {
+    writer.writeUint32(b.samples.size());
+    for (const auto& s : b.samples) encodeSamplePerField(s, writer);
+    writer.writeUint32(b.ticks.size());
+    for (const auto& t : b.ticks) encodeTickPerField(t, writer);
+}
+
+template<typename R> static void decodeTickPerField(R& reader, Tick& t) {
+    t.sequence = reader.readUint32();
+    t.price = reader.readInt32();
+    t.volume = reader.readFloat32();
+    t.flags = reader.readUint32();
+}
+
+template<typename R> static void decodeBatchPerField(R& reader, SampleBatch& b) {
+    const auto samples = reader.readUint32();
+    b.samples = std::vector<Sample>();
+    b.samples.reserve(samples);
+    for (size_t i = 0; i < samples; i++) {
+        Sample s;
+        s.id = reader.readUint32();
+        s.channel = static_cast<Channel>(reader.readUint16());
+        s.session = reader.readGuid();
+        s.recorded = reader.readDate();
+        s.gain = reader.readFloat64();
+        s.muted = reader.readBool();
+        decodeTickPerField(reader, s.tick);
+        b.samples.push_back(s);
+    }
+    const auto ticks = reader.readUint32();
+    b.ticks = std::vector<Tick>();
+    b.ticks.reserve(ticks);
+    for (size_t i = 0; i < ticks; i++) {
+        Tick t;
+        decodeTickPerField(reader, t);
+        b.ticks.push_back(t);
+    }
+}
+
+template<typename F> static double nsPerOp(int iterations, F f) {
+    const auto t1 = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; i++) f();
+    const auto t2 = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::nano>(t2 - t1).count() / iterations;
+}
+
+int main() {
+#if BEBOP_ASSUME_LITTLE_ENDIAN
+    static_assert(Tick::hasWireLayout(), "Tick should be copied in bulk");
+#endif
+    static_assert(!Sample::hasWireLayout(), "Sample needs converting through Sample::Packed");
+
+    SampleBatch batch;
+    const auto session = bebop::Guid::fromString("81c6987b-48b7-495f-ad01-ec20cc5f5be1");
+    for (uint32_t i = 0; i < 1000; i++) {
+        const Tick tick {i, static_cast<int32_t>(i * 7) - 3000, i * 0.25f, i ^ 0x5a5a};
+        batch.ticks.push_back(tick);
+        batch.samples.push_back(Sample {i, static_cast<Channel>(i % 3), session, bebop::TickDuration(i * 10000000LL), i / 3.0, i % 2 == 0, tick});
+    }
+
+    std::vector<uint8_t> packed, perField;
+    SampleBatch::encodeInto(batch, packed);
+    bebop::Writer perFieldWriter{perField};
+    encodeBatchPerField(batch, perFieldWriter);
+    assert(packed == perField);
+
+    SampleBatch decoded;
+    SampleBatch::decodeInto(packed, decoded);
+    std::vector<uint8_t> roundTrip;
+    SampleBatch::encodeInto(decoded, roundTrip);
+    assert(roundTrip == packed);
+    assert(decoded.samples[999].recorded == batch.samples[999].recorded);
+    assert(decoded.samples[998].muted && !decoded.samples[999].muted);
+    assert(SampleBatch::validate(packed.data(), packed.size()));
+    assert(!SampleBatch::validate(packed.data(), packed.size() - 1));
+
+    const int iterations = 2000;
+    std::vector<uint8_t> buffer;
+    buffer.reserve(packed.size());
+    const double encodePacked = nsPerOp(iterations, [&] {
+        buffer.clear();
+        bebop::Writer writer{buffer};
+        SampleBatch::encodeInto(batch, writer);
+    });
+    const double encodePerField = nsPerOp(iterations, [&] {
+        buffer.clear();
+        bebop::Writer writer{buffer};
+        encodeBatchPerField(batch, writer);
+    });
+    const double decodePacked = nsPerOp(iterations, [&] {
+        SampleBatch::decodeInto(packed, decoded);
+    });
+    const double decodePerField = nsPerOp(iterations, [&] {
+        bebop::Reader reader{packed.data(), packed.size()};
+        decodeBatchPerField(reader, decoded);
+    });
+    const double decodePerFieldUnchecked = nsPerOp(iterations, [&] {
+        bebop::UncheckedReader reader{packed.data(), packed.size()};
+        decodeBatchPerField(reader, decoded);
+    });
+    const double validateNs = nsPerOp(iterations, [&] { SampleBatch::validate(packed.data(), packed.size()); });
+    const double decodeUnchecked = nsPerOp(iterations, [&] {
+        SampleBatch::decodeUncheckedInto(packed.data(), packed.size(), decoded);
+    });
+
+    printf("SampleBatch of 1000 samples + 1000 ticks (%zu bytes)\n", packed.size());
+    printf("encode: packed %10.0f ns/op, per-field %10.0f ns/op (%.1fx)\n", encodePacked, encodePerField, encodePerField / encodePacked);
+    printf("decode: packed %10.0f ns/op, per-field %10.0f ns/op (%.1fx)\n", decodePacked, decodePerField, decodePerField / decodePacked);
+    printf("validate %10.0f ns/op + decodeUnchecked %10.0f ns/op (per-field with an UncheckedReader %10.0f ns/op)\n", validateNs, decodeUnchecked, decodePerFieldUnchecked);
+    return 0;
+}
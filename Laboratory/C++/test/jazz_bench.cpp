@@ -0,0 +1,110 @@
+#include "../gen/jazz.hpp"
+#include <cassert>
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+// Song::decodeInto as CPlusPlusGenerator emitted it before array elements were constructed in place:
+// each Musician is decoded into a temporary and then copied into the vector.
+static void decodeSongPerElement(bebop::Reader& reader, Song& target) {
+    const auto length = reader.readLengthPrefix();
+    const auto end = reader.pointer() + length;
+    while (true) {
+        switch (reader.readByte()) {
+            case 0:
+                return;
+            case 1:
+                target.title = reader.readString();
+                break;
+            case 2:
+                target.year = reader.readUint16();
+                break;
+            case 3: {
+                const auto length0 = reader.readUint32();
+                target.performers = std::vector<Musician>();
+                target.performers->reserve(length0);
+                for (size_t i0 = 0; i0 < length0; i0++) {
+                    Musician x0;
+                    Musician::decodeInto(reader, x0);
+                    target.performers->push_back(x0);
+                }
+                break;
+            }
+            default:
+                reader.seek(end);
+                return;
+        }
+    }
+}
+
+static void decodeLibraryPerElement(bebop::Reader& reader, Library& target) {
+    const auto length0 = reader.readUint32();
+    target.songs = std::map<bebop::Guid, Song>();
+    for (size_t i0 = 0; i0 < length0; i0++) {
+        const auto k0 = reader.readGuid();
+        decodeSongPerElement(reader, target.songs[k0]);
+    }
+}
+
+template<typename F> static double nsPerOp(int iterations, F f) {
+    const auto t1 = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; i++) f();
+    const auto t2 = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::nano>(t2 - t1).count() / iterations;
+}
+
+int main() {
+    Library library;
+    uint8_t guidBytes[16] = {};
+    for (uint32_t i = 0; i < 256; i++) {
+        memcpy(guidBytes, &i, sizeof(i));
+        Song song;
+        song.title = "Donna Lee, take " + std::to_string(i);
+        song.year = 1947;
+        song.performers = std::vector<Musician>();
+        for (int j = 0; j < 32; j++) {
+            song.performers->push_back(Musician {"Performer with a name too long for the small string buffer #" + std::to_string(j), static_cast<Instrument>(j % 3)});
+        }
+        library.songs[bebop::Guid(guidBytes)] = song;
+    }
+    const auto buffer = Library::encode(library);
+
+    Library inPlace, perElement;
+    Library::decodeInto(buffer, inPlace);
+    bebop::Reader reader{buffer.data(), buffer.size()};
+    decodeLibraryPerElement(reader, perElement);
+    assert(Library::encode(inPlace) == buffer);
+    assert(Library::encode(perElement) == buffer);
+    assert(Library::validate(buffer.data(), buffer.size()));
+    Library unchecked;
+    Library::decodeUncheckedInto(buffer.data(), buffer.size(), unchecked);
+    assert(Library::encode(unchecked) == buffer);
+
+    AudioData audio {std::vector<float>(1 << 16, 0.5f)};
+    const auto audioBuffer = AudioData::encode(audio);
+    assert(AudioData::decode(audioBuffer).samples == audio.samples);
+
+    const int iterations = 50;
+    const double inPlaceNs = nsPerOp(iterations, [&] { Library::decodeInto(buffer, inPlace); });
+    const double perElementNs = nsPerOp(iterations, [&] {
+        bebop::Reader reader{buffer.data(), buffer.size()};
+        decodeLibraryPerElement(reader, perElement);
+    });
+    const double validateNs = nsPerOp(iterations, [&] { Library::validate(buffer.data(), buffer.size()); });
+    const double uncheckedNs = nsPerOp(iterations, [&] { Library::decodeUncheckedInto(buffer.data(), buffer.size(), unchecked); });
+    const double audioBulkNs = nsPerOp(iterations, [&] { AudioData::decode(audioBuffer); });
+    const double audioPerElementNs = nsPerOp(iterations, [&] {
+        bebop::Reader reader{audioBuffer.data(), audioBuffer.size()};
+        const auto length = reader.readUint32();
+        std::vector<float> samples;
+        samples.reserve(length);
+        for (size_t i = 0; i < length; i++) samples.push_back(reader.readFloat32());
+    });
+
+    printf("Library of 256 songs with 32 performers each (%zu bytes)\n", buffer.size());
+    printf("decode: generated %10.0f ns/op, copy per element %10.0f ns/op (%.1fx)\n", inPlaceNs, perElementNs, perElementNs / inPlaceNs);
+    printf("validate %10.0f ns/op + decodeUnchecked %10.0f ns/op\n", validateNs, uncheckedNs);
+    printf("AudioData of 65536 samples (%zu bytes)\n", audioBuffer.size());
+    printf("decode: generated %10.0f ns/op, per element %10.0f ns/op (%.1fx)\n", audioBulkNs, audioPerElementNs, audioPerElementNs / audioBulkNs);
+    return 0;
+}
@@ -0,0 +1,48 @@
+#include "../gen/jazz.hpp"
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <string>
+#include <vector>
+#include "count_allocations.hpp"
+
+int main() {
+    Library library;
+    for (uint32_t i = 0; i < 64; i++) {
+        uint8_t guidBytes[16] = {static_cast<uint8_t>(i)};
+        Song& song = library.songs[bebop::Guid(guidBytes)];
+        song.title = "A song title that is too long for the small string optimization #" + std::to_string(i);
+        song.year = 1940 + i;
+        song.performers.emplace();
+        for (int j = 0; j < 4; j++) {
+            song.performers->push_back(Musician{"A musician whose name does not fit inline #" + std::to_string(j), static_cast<Instrument>(j % 3)});
+        }
+    }
+    const auto expected = Library::encode(library);
+
+    // Encoding into a buffer with room for the record never allocates: strings and byte arrays are
+    // written straight from the fields that hold them.
+    std::vector<uint8_t> buffer;
+    buffer.reserve(Library::encodedSize(library));
+    size_t before = allocations;
+    Library::encodeInto(library, buffer);
+    if (allocations != before || buffer != expected) {
+        printf("encoding into a reserved vector made %zu allocations\n", allocations - before);
+        return 1;
+    }
+
+    // Neither does encoding into a fixed region, or counting the bytes first.
+    std::vector<uint8_t> region(expected.size());
+    before = allocations;
+    bebop::ByteCounter counter;
+    Library::encodeInto(library, counter);
+    bebop::FixedBufferWriter writer{bebop::FixedBufferSink{region.data(), region.size()}};
+    Library::encodeInto(library, writer);
+    if (allocations != before || counter.length() != expected.size() || region != expected) {
+        printf("encoding into a fixed region made %zu allocations\n", allocations - before);
+        return 1;
+    }
+
+    printf("encoded %zu bytes without allocating\n", expected.size());
+    return 0;
+}
@@ -0,0 +1,70 @@
+// Build with: ./run_test.sh jazz jazz_flat_map mapContainer=flat
+#include "../gen/jazz.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+static bebop::Guid guidFor(uint32_t i) {
+    uint8_t bytes[16] = {static_cast<uint8_t>(i * 37), static_cast<uint8_t>(i >> 3), 0xab};
+    return bebop::Guid(bytes);
+}
+
+// The keys of an encoded Library, in wire order.
+static std::vector<bebop::Guid> wireKeys(const std::vector<uint8_t>& buf) {
+    std::vector<bebop::Guid> keys;
+    bebop::Reader reader{buf.data(), buf.size()};
+    const size_t length = reader.readUint32();
+    for (size_t i = 0; i < length; i++) {
+        keys.push_back(reader.readGuid());
+        Song song;
+        Song::decodeInto(reader, song);
+    }
+    return keys;
+}
+
+int main() {
+    // Insert out of order: the map stays sorted and encodes in key order.
+    std::vector<uint32_t> order(200);
+    for (uint32_t i = 0; i < order.size(); i++) order[i] = i;
+    std::shuffle(order.begin(), order.end(), std::mt19937{7});
+    Library library;
+    for (uint32_t i : order) {
+        Song& song = library.songs[guidFor(i)];
+        song.title = "Take #" + std::to_string(i);
+        song.year = 1950 + i % 20;
+    }
+    const auto buf = Library::encode(library);
+    const auto keys = wireKeys(buf);
+    if (keys.size() != order.size() || !std::is_sorted(keys.begin(), keys.end())) {
+        printf("flat map did not encode %zu keys in order\n", order.size());
+        return 1;
+    }
+
+    // Decoding builds the map in bulk and reproduces the same bytes.
+    const Library decoded = Library::decode(buf);
+    if (decoded.songs.size() != order.size() || Library::encode(decoded) != buf) return 1;
+    if (decoded.songs.at(guidFor(42)).title != "Take #42" || decoded.songs.contains(guidFor(1000))) return 1;
+
+    // Out-of-order input on the wire decodes to a sorted map; a repeated key keeps its last value,
+    // as std::map's operator[] would.
+    {
+        const uint32_t wireOrder[] = {5, 1, 5};
+        std::vector<uint8_t> wire;
+        bebop::Writer writer{wire};
+        writer.writeUint32(3);
+        for (uint16_t year = 0; year < 3; year++) {
+            writer.writeGuid(guidFor(wireOrder[year]));
+            Song song;
+            song.year = year;
+            Song::encodeInto(song, writer);
+        }
+        const Library unsorted = Library::decode(wire);
+        if (unsorted.songs.size() != 2 || !(unsorted.songs.begin()->first == std::min(guidFor(1), guidFor(5)))) return 1;
+        if (unsorted.songs.at(guidFor(5)).year != 2) return 1;
+    }
+
+    printf("flat maps decoded and encoded %zu songs in key order\n", decoded.songs.size());
+    return 0;
+}
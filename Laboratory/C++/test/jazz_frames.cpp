@@ -0,0 +1,54 @@
+#include "../gen/jazz.hpp"
+#include <cstdio>
+#include <string>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+
+int main() {
+    int fds[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds) != 0) return 1;
+
+    bebop::FrameOptions options;
+    options.opcodes = true;
+    options.flushDelay = std::chrono::milliseconds(1);
+    const int count = 10000;
+
+    std::thread sender([&] {
+        bebop::FrameWriter writer{fds[1], options};
+        for (int i = 0; i < count; i++) {
+            if (i % 2 == 0) {
+                writer.write(Musician{"Musician #" + std::to_string(i), Instrument::Clarinet});
+            } else {
+                Song song;
+                song.year = static_cast<uint16_t>(i);
+                writer.write(song, 0);
+            }
+        }
+        writer.flush();
+        close(fds[1]);
+    });
+
+    bebop::FrameReader reader{fds[0], options};
+    bebop::Frame frame;
+    int received = 0;
+    bebop::FrameStatus status;
+    while ((status = reader.next(frame)) == bebop::FrameStatus::Ok) {
+        if (received % 2 == 0) {
+            Musician m;
+            if (frame.opcode != Musician::opcode || !frame.decodeInto(m) || m.name != "Musician #" + std::to_string(received)) return 1;
+        } else {
+            Song song;
+            if (frame.opcode != 0 || !frame.decodeInto(song) || song.year != received) return 1;
+        }
+        received++;
+    }
+    sender.join();
+    close(fds[0]);
+    if (status != bebop::FrameStatus::End || received != count) {
+        printf("received %d of %d frames\n", received, count);
+        return 1;
+    }
+    printf("received %d frames over a Unix socket\n", received);
+    return 0;
+}
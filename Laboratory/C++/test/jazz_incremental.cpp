@@ -0,0 +1,94 @@
+#include "../gen/jazz.hpp"
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+static Song makeSong(size_t performers) {
+    Song s;
+    s.title = "Donna Lee";
+    s.year = 1947;
+    s.performers.emplace();
+    for (size_t i = 0; i < performers; i++) {
+        s.performers->push_back(Musician{"Musician #" + std::to_string(i), static_cast<Instrument>(i % 3)});
+    }
+    return s;
+}
+
+// Feed `buf` in chunks of the sizes `nextChunk` picks; returns the bytes consumed when the record completes.
+template<typename F> static size_t feedAll(const std::vector<uint8_t>& buf, Song& target, F nextChunk) {
+    bebop::IncrementalDecoder<Song> decoder{target};
+    size_t offset = 0;
+    while (offset < buf.size()) {
+        const size_t n = std::min(nextChunk(), buf.size() - offset);
+        const auto result = decoder.feed(buf.data() + offset, n);
+        offset += result.bytesConsumed;
+        if (result.status == bebop::FeedStatus::Done) return offset;
+        if (result.status == bebop::FeedStatus::MalformedPacket || result.bytesConsumed != n) return 0;
+    }
+    return 0;
+}
+
+int main() {
+    const auto buf = Song::encode(makeSong(2000));
+
+    // Any chunking decodes to the same record, and leaves the next record's bytes unconsumed.
+    auto stream = buf;
+    stream.insert(stream.end(), {0xde, 0xad});
+    std::mt19937 rng{1};
+    for (size_t maxChunk : {size_t(1), size_t(3), size_t(64), size_t(4096), stream.size()}) {
+        Song decoded;
+        const size_t consumed = feedAll(stream, decoded, [&] { return size_t{1} + rng() % maxChunk; });
+        if (consumed != buf.size() || Song::encode(decoded) != buf) {
+            printf("chunks of up to %zu bytes: consumed %zu of %zu\n", maxChunk, consumed, buf.size());
+            return 1;
+        }
+    }
+
+    // An unknown tag skips to the end of the message, as decodeInto does.
+    {
+        Song s;
+        s.title = "Confirmation";
+        auto withUnknown = Song::encode(s);
+        withUnknown.insert(withUnknown.end() - 1, {9, 1, 2, 3});
+        withUnknown[0] += 4;
+        Song decoded;
+        if (feedAll(withUnknown, decoded, [] { return size_t{1}; }) != withUnknown.size() || decoded.title != "Confirmation") return 1;
+    }
+
+    // Truncated and corrupt records never complete.
+    for (size_t n = 0; n < 64; n++) {
+        Song decoded;
+        bebop::IncrementalDecoder<Song> decoder{decoded};
+        for (size_t i = 0; i < n; i++) {
+            if (decoder.feed(buf.data() + i, 1).status != bebop::FeedStatus::NeedMore) return 1;
+        }
+    }
+    {
+        auto corrupt = buf;
+        corrupt[0] = 6;  // the body ends in the middle of the title
+        corrupt[1] = corrupt[2] = corrupt[3] = 0;
+        Song decoded;
+        bebop::IncrementalDecoder<Song> decoder{decoded};
+        if (decoder.feed(corrupt).status != bebop::FeedStatus::MalformedPacket) return 1;
+        bebop::IncrementalDecoder<Song> limited{decoded, 1024};
+        if (limited.feed(buf).status != bebop::FeedStatus::MalformedPacket) return 1;
+    }
+
+    // Reset decodes the next record of a stream.
+    {
+        const auto second = Song::encode(makeSong(3));
+        auto both = buf;
+        both.insert(both.end(), second.begin(), second.end());
+        Song first, next;
+        bebop::IncrementalDecoder<Song> decoder{first};
+        auto result = decoder.feed(both);
+        if (!result.done() || result.bytesConsumed != buf.size()) return 1;
+        decoder.reset(next);
+        result = decoder.feed(both.data() + buf.size(), second.size());
+        if (!result.done() || Song::encode(next) != second) return 1;
+    }
+
+    printf("incremental decoding matched for every chunking\n");
+    return 0;
+}
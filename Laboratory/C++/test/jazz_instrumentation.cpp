@@ -0,0 +1,92 @@
+// Instrumentation is opt-in: it must be switched on before the runtime is included.
+#define BEBOP_INSTRUMENTATION 1
+#include "../gen/jazz.hpp"
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <string>
+#include <thread>
+#include <vector>
+#define COUNT_ALLOCATION() bebop::instrumentation::noteAllocation()
+#include "count_allocations.hpp"
+
+using bebop::instrumentation::Direction;
+using bebop::instrumentation::Operation;
+
+static bebop::instrumentation::RecordCounters counted(const bebop::instrumentation::Snapshot& snapshot, const char* type, Operation operation) {
+    for (const auto& record : snapshot.records) {
+        if (record.type == type && record.operation == operation) return record.counters;
+    }
+    return {};
+}
+
+static uint64_t primitiveBytes(const bebop::instrumentation::Snapshot& snapshot, Direction direction) {
+    uint64_t bytes = 0;
+    for (const auto& counters : snapshot.primitives[static_cast<size_t>(direction)]) bytes += counters.bytes;
+    return bytes;
+}
+
+static Song makeSong(size_t performers) {
+    Song s;
+    s.title = "Giant Steps";
+    s.year = 1960;
+    s.performers.emplace();
+    for (size_t i = 0; i < performers; i++) {
+        s.performers->push_back(Musician{"Musician #" + std::to_string(i), Instrument::Trumpet});
+    }
+    return s;
+}
+
+int main() {
+    Library library;
+    for (uint32_t i = 0; i < 5; i++) {
+        bebop::Guid id{};
+        id.m_a = i;
+        library.songs[id] = makeSong(3);
+    }
+    const auto buffer = Library::encode(library);
+    const Library decoded = Library::decode(buffer);
+
+    // Every record is counted, nested ones included, with inclusive bytes.
+    auto snapshot = bebop::instrumentation::snapshot();
+    const auto libraryEncode = counted(snapshot, "Library", Operation::Encode);
+    if (libraryEncode.calls != 1 || libraryEncode.bytes != buffer.size() || libraryEncode.nanoseconds == 0) return 1;
+    if (counted(snapshot, "Song", Operation::Encode).calls != 5 || counted(snapshot, "Musician", Operation::Encode).calls != 15) return 1;
+    if (counted(snapshot, "Song", Operation::Decode).calls != 5 || counted(snapshot, "Library", Operation::Decode).bytes != buffer.size()) return 1;
+    // Decoding allocates at least one map node per song.
+    if (counted(snapshot, "Library", Operation::Decode).allocations < 5) return 1;
+
+    // Primitives add up to every byte written and read, each counted once.
+    if (primitiveBytes(snapshot, Direction::Write) != buffer.size() || primitiveBytes(snapshot, Direction::Read) != buffer.size()) return 1;
+    if (snapshot.primitives[static_cast<size_t>(Direction::Write)][static_cast<size_t>(bebop::instrumentation::Primitive::Guid)].calls != 5) return 1;
+
+    // Threads count on their own, and what they counted outlives them.
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; t++) {
+        threads.emplace_back([] {
+            const Song song = makeSong(1);
+            for (int i = 0; i < 1000; i++) Song::encode(song);
+        });
+    }
+    for (auto& thread : threads) thread.join();
+    snapshot = bebop::instrumentation::snapshot();
+    if (counted(snapshot, "Song", Operation::Encode).calls != 4005) return 1;
+
+    const auto text = snapshot.toText();
+    if (text.find("bebop_record_calls_total{type=\"Song\",operation=\"encode\"} 4005\n") == std::string::npos) return 1;
+    if (text.find("bebop_primitive_calls_total{primitive=\"guid\",direction=\"write\"} 5\n") == std::string::npos) return 1;
+    const auto json = snapshot.toJson();
+    if (json.find("{\"type\":\"Song\",\"operation\":\"encode\",\"calls\":4005,") == std::string::npos) return 1;
+
+    // Type names are escaped in both formats.
+    bebop::instrumentation::Snapshot odd;
+    bebop::instrumentation::RecordCounters once;
+    once.calls = 1;
+    odd.records.push_back({"ns::\"Odd\"\\Name\n\t", Operation::Encode, once});
+    if (odd.toText().find("{type=\"ns::\\\"Odd\\\"\\\\Name\\n\t\",operation=\"encode\"} 1\n") == std::string::npos) return 1;
+    if (odd.toJson().find("{\"type\":\"ns::\\\"Odd\\\"\\\\Name\\u000a\\u0009\",\"operation\"") == std::string::npos) return 1;
+
+    printf("%s", text.c_str());
+    printf("%s\n", json.c_str());
+    return decoded.songs.size() == 5 ? 0 : 1;
+}
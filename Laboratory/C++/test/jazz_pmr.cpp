@@ -0,0 +1,45 @@
+// Build with: ./run_test.sh jazz jazz_pmr usePmr=true
+#include "../gen/jazz.hpp"
+#include <cstdio>
+#include <memory_resource>
+#include <string>
+#include <vector>
+
+int main() {
+    Library library;
+    for (uint32_t i = 0; i < 64; i++) {
+        uint8_t guidBytes[16] = {static_cast<uint8_t>(i)};
+        Song& song = library.songs[bebop::Guid(guidBytes)];
+        song.title.emplace("A song title that is too long for the small string optimization #" + std::to_string(i));
+        song.year = 1940 + i;
+        song.performers.emplace();
+        for (int j = 0; j < 4; j++) {
+            Musician& m = song.performers->emplace_back();
+            m.name = "A musician whose name does not fit in a std::string #" + std::to_string(j);
+            m.plays = static_cast<Instrument>(j % 3);
+        }
+    }
+    const auto buf = Library::encode(library);
+
+    // Every allocation of the decoded tree must come from the arena: anything that
+    // falls back to the default resource, or outgrows the arena, throws bad_alloc.
+    static uint8_t arena[1 << 20];
+    std::pmr::monotonic_buffer_resource resource{arena, sizeof(arena), std::pmr::null_memory_resource()};
+    std::pmr::set_default_resource(std::pmr::null_memory_resource());
+    {
+        const Library decoded = Library::decode(buf, &resource);
+        std::pmr::set_default_resource(nullptr);
+        if (Library::encode(decoded) != buf) {
+            printf("round trip mismatch\n");
+            return 1;
+        }
+        if (decoded.songs.get_allocator().resource() != &resource) return 1;
+        const auto& performers = *decoded.songs.begin()->second.performers;
+        if (performers.get_allocator().resource() != &resource) return 1;
+        if (performers[0].name.get_allocator().resource() != &resource) return 1;
+    }
+    // Releasing the arena frees the whole tree at once.
+    resource.release();
+    printf("decoded %zu bytes into one monotonic_buffer_resource\n", buf.size());
+    return 0;
+}
@@ -0,0 +1,154 @@
+#include "../gen/jazz.hpp"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <new>
+#include <string>
+#include <thread>
+#include <vector>
+#include "count_allocations.hpp"
+
+// A bounded queue standing in for a socket: senders hand encoded messages to a network
+// thread, which drops them once "sent". Its slots are allocated up front.
+template<typename Payload> class Channel {
+    std::mutex m_mutex;
+    std::condition_variable m_notEmpty, m_notFull;
+    std::vector<Payload> m_slots;
+    size_t m_head = 0, m_count = 0;
+    bool m_closed = false;
+public:
+    explicit Channel(size_t capacity) : m_slots(capacity) {}
+
+    void push(Payload&& payload) {
+        std::unique_lock<std::mutex> lock{m_mutex};
+        m_notFull.wait(lock, [&] { return m_count < m_slots.size(); });
+        m_slots[(m_head + m_count++) % m_slots.size()] = std::move(payload);
+        m_notEmpty.notify_one();
+    }
+
+    bool pop(Payload& payload) {
+        std::unique_lock<std::mutex> lock{m_mutex};
+        m_notEmpty.wait(lock, [&] { return m_count || m_closed; });
+        if (!m_count) return false;
+        payload = std::move(m_slots[m_head]);
+        m_head = (m_head + 1) % m_slots.size();
+        m_count--;
+        m_notFull.notify_one();
+        return true;
+    }
+
+    void close() {
+        std::lock_guard<std::mutex> lock{m_mutex};
+        m_closed = true;
+        m_notEmpty.notify_all();
+    }
+};
+
+struct Result {
+    double nsPerMessage;
+    double allocationsPerMessage;
+};
+
+// `pairs` sender threads each encode `messages` songs for their own network thread, after
+// as many again to warm up. Only the second half is measured.
+template<typename Payload, typename Encode> static Result run(int pairs, size_t messages, Encode encode) {
+    std::vector<std::unique_ptr<Channel<Payload>>> channels;
+    for (int i = 0; i < pairs; i++) channels.push_back(std::make_unique<Channel<Payload>>(32));
+    std::atomic<size_t> consumed{0};
+    std::atomic<int> warm{0};
+    std::atomic<bool> go{false};
+    std::vector<std::thread> threads;
+    for (int i = 0; i < pairs; i++) {
+        auto& channel = *channels[i];
+        threads.emplace_back([&] {
+            for (size_t j = 0; j < messages; j++) channel.push(encode());
+            warm++;
+            while (!go.load()) std::this_thread::yield();
+            for (size_t j = 0; j < messages; j++) channel.push(encode());
+        });
+        threads.emplace_back([&] {
+            Payload payload;
+            while (channel.pop(payload)) {
+                payload = Payload();
+                consumed++;
+            }
+        });
+    }
+    while (warm.load() < pairs) std::this_thread::yield();
+    while (consumed.load() < pairs * messages) std::this_thread::yield();
+    const size_t before = allocations.load();
+    const auto t1 = std::chrono::steady_clock::now();
+    go = true;
+    while (consumed.load() < 2 * pairs * messages) std::this_thread::yield();
+    const auto t2 = std::chrono::steady_clock::now();
+    const size_t after = allocations.load();
+    for (auto& channel : channels) channel->close();
+    for (auto& thread : threads) thread.join();
+    const double total = static_cast<double>(pairs * messages);
+    return {std::chrono::duration<double, std::nano>(t2 - t1).count() / total, (after - before) / total};
+}
+
+int main() {
+    Song song;
+    song.title = "A song title that is too long for the small string optimization";
+    song.year = 1959;
+    song.performers.emplace();
+    for (int j = 0; j < 4; j++) {
+        song.performers->push_back(Musician{"A musician whose name does not fit inline #" + std::to_string(j), static_cast<Instrument>(j % 3)});
+    }
+    const auto expected = Song::encode(song);
+    // Room for every buffer that can be in flight: a full channel per pair, and one more at each end.
+    bebop::BufferPoolOptions options;
+    options.overflowBuffers = 4 * (32 + 2);
+    bebop::BufferPool pool{options};
+
+    // On one thread, every lease after the first is served from the thread's own cache.
+    const size_t iterations = 100000;
+    size_t before = allocations.load();
+    auto t1 = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < iterations; i++) {
+        auto buffer = Song::encode(song);
+        if (buffer.size() != expected.size()) return 1;
+    }
+    auto t2 = std::chrono::steady_clock::now();
+    const double freshNs = std::chrono::duration<double, std::nano>(t2 - t1).count() / iterations;
+    const double freshAllocations = static_cast<double>(allocations.load() - before) / iterations;
+    before = allocations.load();
+    t1 = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < iterations; i++) {
+        auto lease = pool.lease(song.encodedSize());
+        Song::encodeInto(song, *lease);
+        if (lease.size() != expected.size()) return 1;
+    }
+    t2 = std::chrono::steady_clock::now();
+    const double pooledNs = std::chrono::duration<double, std::nano>(t2 - t1).count() / iterations;
+    const double pooledAllocations = static_cast<double>(allocations.load() - before) / iterations;
+
+    printf("Song of %zu bytes, encoded and dropped on one thread\n", expected.size());
+    printf("fresh vector  %8.0f ns/message %6.3f allocations/message\n", freshNs, freshAllocations);
+    printf("pooled lease  %8.0f ns/message %6.3f allocations/message\n", pooledNs, pooledAllocations);
+
+    // Across threads, leases end on the network threads. Their caches fill up and the rest
+    // reach the senders through the pool's overflow list.
+    for (const int pairs : {1, 4}) {
+        const size_t messages = 100000;
+        const auto fresh = run<std::vector<uint8_t>>(pairs, messages, [&] { return Song::encode(song); });
+        const auto pooled = run<bebop::BufferPool::Lease>(pairs, messages, [&] {
+            auto lease = pool.lease(song.encodedSize());
+            Song::encodeInto(song, *lease);
+            return lease;
+        });
+        printf("%d sender/network thread pair(s)\n", pairs);
+        printf("fresh vector  %8.0f ns/message %6.3f allocations/message\n", fresh.nsPerMessage, fresh.allocationsPerMessage);
+        printf("pooled lease  %8.0f ns/message %6.3f allocations/message\n", pooled.nsPerMessage, pooled.allocationsPerMessage);
+    }
+
+    const auto stats = pool.stats();
+    printf("pool: %llu leases, hit rate %.4f (%llu from thread caches, %llu from the overflow list), %llu dropped, %zu buffers (%zu bytes) cached\n",
+        static_cast<unsigned long long>(stats.leases), stats.hitRate(), static_cast<unsigned long long>(stats.threadHits),
+        static_cast<unsigned long long>(stats.overflowHits), static_cast<unsigned long long>(stats.dropped), stats.buffersCached, stats.bytesCached);
+    return 0;
+}
@@ -0,0 +1,49 @@
+// Build with: ./run_test.sh jazz jazz_reuse reuseStorage=true
+#include "../gen/jazz.hpp"
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <string>
+#include <vector>
+#include "count_allocations.hpp"
+
+static Song makeSong(int take, size_t performers) {
+    Song s;
+    s.title = "A song title that is too long for the small string optimization, take " + std::to_string(take);
+    s.year = 1950 + take;
+    s.performers.emplace();
+    for (size_t i = 0; i < performers; i++) {
+        s.performers->push_back(Musician{"A musician whose name does not fit inline #" + std::to_string(i), static_cast<Instrument>(i % 3)});
+    }
+    return s;
+}
+
+int main() {
+    std::vector<std::vector<uint8_t>> stream;
+    for (int take = 0; take < 32; take++) stream.push_back(Song::encode(makeSong(take, 8)));
+
+    // Strings, arrays and the records in them keep their storage from one decode to the next.
+    Song target;
+    for (const auto& buf : stream) Song::decodeInto(buf, target);
+    const size_t before = allocations;
+    for (int pass = 0; pass < 100; pass++) {
+        for (const auto& buf : stream) Song::decodeInto(buf, target);
+    }
+    if (allocations != before) {
+        printf("decoding %zu songs made %zu allocations\n", 100 * stream.size(), allocations - before);
+        return 1;
+    }
+    if (Song::encode(target) != stream.back()) return 1;
+
+    // A shorter array drops its extra elements; fields missing from the wire are reset.
+    const auto shorter = Song::encode(makeSong(7, 3));
+    Song::decodeInto(shorter, target);
+    if (target.performers->size() != 3 || Song::encode(target) != shorter) return 1;
+    Song untitled;
+    untitled.year = 1959;
+    Song::decodeInto(Song::encode(untitled), target);
+    if (target.title || target.performers || target.year != 1959) return 1;
+
+    printf("decoded %zu songs without allocating\n", 100 * stream.size());
+    return 0;
+}
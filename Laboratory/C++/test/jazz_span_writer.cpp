@@ -0,0 +1,46 @@
+#include "../gen/jazz.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+int main() {
+    Library library;
+    for (uint32_t i = 0; i < 16; i++) {
+        uint8_t guidBytes[16] = {static_cast<uint8_t>(i)};
+        Song& song = library.songs[bebop::Guid(guidBytes)];
+        song.title = "Take " + std::to_string(i);
+        if (i % 2) song.year = 1950 + i;
+        song.performers.emplace();
+        for (uint32_t j = 0; j < i % 4; j++) {
+            song.performers->push_back(Musician{"Musician #" + std::to_string(j), Instrument::Trumpet});
+        }
+    }
+    const auto expected = Library::encode(library);
+    if (Library::maxEncodedSize(library) < expected.size()) {
+        printf("maxEncodedSize %zu is below the encoded size %zu\n", Library::maxEncodedSize(library), expected.size());
+        return 1;
+    }
+
+    // Records written back to back into one region match their separate encodings.
+    const Musician musician{"Thelonious Monk", Instrument::Sax};
+    std::vector<uint8_t> region(Library::maxEncodedSize(library) + Musician::maxEncodedSize(musician));
+    bebop::SpanWriter writer{region.data(), region.size()};
+    if (writer.encode(library) != expected.size() || writer.encode(musician) != musician.encodedSize()) return 1;
+    if (!std::equal(expected.begin(), expected.end(), region.begin())) return 1;
+    if (Musician::decode(region.data() + expected.size(), musician.encodedSize()).name != musician.name) return 1;
+
+    // A region that might be too small is refused before anything is written.
+    const size_t used = writer.length();
+    if (writer.tryEncode(library) || writer.length() != used) return 1;
+    bool threw = false;
+    try {
+        writer.encode(library);
+    } catch (const bebop::BufferOverflowException&) {
+        threw = true;
+    }
+    if (!threw || writer.length() != used) return 1;
+
+    printf("SpanWriter encoded %zu bytes with one capacity check per record\n", used);
+    return 0;
+}
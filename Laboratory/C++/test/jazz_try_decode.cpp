@@ -0,0 +1,44 @@
+// Uses only the exception-free decode API, so it also builds with -fno-exceptions.
+#include "../gen/jazz.hpp"
+#include <cstdio>
+#include <vector>
+
+int main() {
+    Song s;
+    s.title = "Donna Lee";
+    s.year = 1947;
+    s.performers = std::vector<Musician> {{"Charlie Parker", Instrument::Sax}, {"Miles Davis", Instrument::Trumpet}};
+    Library l;
+    l.songs[bebop::Guid::fromString("81c6987b-48b7-495f-ad01-ec20cc5f5be1")] = s;
+    const auto buf = Library::encode(l);
+
+    Library decoded;
+    const auto result = Library::tryDecodeInto(buf, decoded);
+    if (!result || result.bytesRead != buf.size()) return 1;
+    if (Library::encode(decoded) != buf) return 1;
+
+    // Every truncation of the buffer must be reported as malformed.
+    for (size_t n = 0; n < buf.size(); n++) {
+        Library partial;
+        if (Library::tryDecodeInto(buf.data(), n, partial).status != bebop::DecodeStatus::MalformedPacket) {
+            printf("truncation to %zu bytes was not reported\n", n);
+            return 1;
+        }
+        if (Library::validate(buf.data(), n)) {
+            printf("truncation to %zu bytes passed validation\n", n);
+            return 1;
+        }
+    }
+
+    // A validated buffer decodes the same without bounds checks.
+    if (!Library::validate(buf.data(), buf.size())) return 1;
+    if (Library::encode(Library::decodeUnchecked(buf.data(), buf.size())) != buf) return 1;
+
+    // A corrupt element count must fail without allocating for it.
+    auto corrupt = buf;
+    corrupt[0] = corrupt[1] = corrupt[2] = corrupt[3] = 0xff;
+    if (Library::tryDecodeInto(corrupt, decoded)) return 1;
+
+    printf("tryDecodeInto and validate reported every malformed buffer\n");
+    return 0;
+}
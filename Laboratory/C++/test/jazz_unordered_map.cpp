@@ -0,0 +1,45 @@
+// Build with: ./run_test.sh jazz jazz_unordered_map mapContainer=unordered
+#include "../gen/jazz.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+static bebop::Guid guidFor(uint32_t i) {
+    uint8_t bytes[16] = {static_cast<uint8_t>(i * 37), static_cast<uint8_t>(i >> 3), 0xab};
+    return bebop::Guid(bytes);
+}
+
+int main() {
+    // Equal maps encode to identical bytes, whatever order their buckets are in.
+    std::vector<uint32_t> order(500);
+    for (uint32_t i = 0; i < order.size(); i++) order[i] = i;
+    Library forward, shuffled;
+    for (uint32_t i : order) forward.songs[guidFor(i)].title = "Take #" + std::to_string(i);
+    std::shuffle(order.begin(), order.end(), std::mt19937{7});
+    shuffled.songs.reserve(4096);
+    for (uint32_t i : order) shuffled.songs[guidFor(i)].title = "Take #" + std::to_string(i);
+    const auto buf = Library::encode(forward);
+    if (Library::encode(shuffled) != buf) {
+        printf("unordered maps with equal entries encoded differently\n");
+        return 1;
+    }
+
+    // The entries are on the wire in key order.
+    bebop::Reader reader{buf.data(), buf.size()};
+    std::vector<bebop::Guid> keys(reader.readUint32());
+    for (auto& key : keys) {
+        key = reader.readGuid();
+        Song song;
+        Song::decodeInto(reader, song);
+    }
+    if (keys.size() != order.size() || !std::is_sorted(keys.begin(), keys.end())) return 1;
+
+    const Library decoded = Library::decode(buf);
+    if (decoded.songs.size() != forward.songs.size() || Library::encode(decoded) != buf) return 1;
+    if (decoded.songs.at(guidFor(42)).title != "Take #42") return 1;
+
+    printf("unordered maps encoded %zu songs deterministically\n", decoded.songs.size());
+    return 0;
+}
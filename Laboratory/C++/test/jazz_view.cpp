@@ -0,0 +1,85 @@
+#include "../gen/jazz.hpp"
+#include <algorithm>
+#include <cassert>
+#include <cstdio>
+#include <map>
+#include <vector>
+
+int main() {
+    bebop::Guid g = bebop::Guid::fromString("81c6987b-48b7-495f-ad01-ec20cc5f5be1");
+
+    Song s;
+    s.title = "Donna Lee";
+    s.year = 1974;
+    Musician m = {"Charlie Parker", Instrument::Sax};
+    s.performers = {10, m};
+    Library l {{{g, s}}};
+
+    std::vector<uint8_t> buf;
+    Library::encodeInto(l, buf);
+
+    // Nothing is copied out of `buf`: the strings point straight into it.
+    LibraryView view = LibraryView::decode(buf);
+    assert(view.songs.size() == 1);
+    for (const auto& [guid, song] : view.songs) {
+        assert(guid == g);
+        assert(*song.title == "Donna Lee");
+        assert(song.title->data() >= reinterpret_cast<const char*>(buf.data()));
+        assert(song.title->data() < reinterpret_cast<const char*>(buf.data() + buf.size()));
+        assert(*song.year == 1974);
+        assert(song.performers->size() == 10);
+        for (const auto& performer : *song.performers) {
+            assert(performer.name == "Charlie Parker");
+            assert(performer.plays == Instrument::Sax);
+        }
+    }
+
+    // Views convert to the owning types on demand.
+    Library owned = view.toOwned();
+    std::vector<uint8_t> buf2;
+    Library::encodeInto(owned, buf2);
+    assert(buf == buf2);
+    printf("%s\n", owned.songs.at(g).performers.value()[9].name.c_str());
+
+    // Songs are skipped by their length prefix, so a broken performer inside one is only
+    // noticed once that song is read.
+    std::vector<uint8_t> broken = buf;
+    const char name[] = "Charlie Parker";
+    const auto performer = std::search(broken.begin(), broken.end(), name, name + sizeof(name) - 1) - 4;
+    std::fill(performer, performer + 4, 0xff);
+    LibraryView lazy = LibraryView::decode(broken);
+    assert(lazy.songs.size() == 1);
+    bool threw = false;
+    try {
+        lazy.songs.begin();
+    } catch (bebop::MalformedPacketException& e) {
+        threw = true;
+    }
+    assert(threw);
+
+    // Of two entries with the same key, the last one wins, as it does in owning decode.
+    Song first, second;
+    first.title = "Ornithology";
+    second.title = "Yardbird Suite";
+    const auto a = Library::encode(Library{{{g, first}}}), b = Library::encode(Library{{{g, second}}});
+    std::vector<uint8_t> duplicated = {2, 0, 0, 0};
+    duplicated.insert(duplicated.end(), a.begin() + 4, a.end());
+    duplicated.insert(duplicated.end(), b.begin() + 4, b.end());
+    assert(Library::decode(duplicated).songs.at(g).title == "Yardbird Suite");
+    assert(LibraryView::decode(duplicated).toOwned().songs.at(g).title == "Yardbird Suite");
+
+    AudioData audio {{0.5f, 1.5f, 2.5f}};
+    buf.clear();
+    AudioData::encodeInto(audio, buf);
+    AudioDataView audioView = AudioDataView::decode(buf);
+    assert(audioView.samples.size() == 3);
+    assert(audioView.samples[1] == 1.5f);
+    assert(audioView.samples.toOwned() == audio.samples);
+
+    buf = std::vector<uint8_t> { 123, 123, 123, 123, 123 };
+    try {
+        LibraryView::decode(buf);
+    } catch (bebop::MalformedPacketException& e) {
+        printf("Viewing a malformed packet correctly threw an exception\n");
+    }
+}
@@ -0,0 +1,40 @@
+#include "../gen/nested_message.hpp"
+#include <cassert>
+#include <cstdio>
+#include <vector>
+
+int main() {
+    {
+        OuterM o{InnerM{3}, InnerS{true}};
+        std::vector<uint8_t> buf;
+        OuterM::encodeInto(o, buf);
+
+        // The nested records are only skipped over until they are read.
+        OuterMView view = OuterMView::decode(buf);
+        assert(view.innerM.has_value() && view.innerS.has_value());
+        assert(view.innerM->bytes() > buf.data() && view.innerM->bytes() + view.innerM->byteLength() <= buf.data() + buf.size());
+        assert(view.innerM->get().x == 3);
+        assert(view.innerS->get().y == true);
+
+        std::vector<uint8_t> buf2;
+        OuterM::encodeInto(view.toOwned(), buf2);
+        assert(buf == buf2);
+    }
+
+    {
+        OuterS o{InnerM{4}, InnerS{false}};
+        std::vector<uint8_t> buf;
+        OuterS::encodeInto(o, buf);
+
+        OuterSView view = OuterSView::decode(buf);
+        assert(view.innerM.get().x == 4);
+        assert(view.innerS.get().y == false);
+        assert(view.innerS.byteLength() == 1);
+
+        std::vector<uint8_t> buf2;
+        OuterS::encodeInto(view.toOwned(), buf2);
+        assert(buf == buf2);
+    }
+
+    printf("nested records decoded on access\n");
+}
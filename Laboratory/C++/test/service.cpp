@@ -0,0 +1,115 @@
+#include "../gen/service.hpp"
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+class Notebook final : public BaseNotebookService {
+public:
+    Note echo(const Note& request, bebop::CallContext& context) override {
+        if (request.text == "fail") context.fail("asked to fail");
+        return request;
+    }
+
+    void repeat(const Note& request, bebop::StreamWriter<Note>& responses, bebop::CallContext&) override {
+        for (uint32_t i = 0; i < request.count.value_or(0); i++) {
+            if (!responses.write(request)) return;
+        }
+    }
+
+    Total tally(bebop::StreamReader<Note>& requests, bebop::CallContext&) override {
+        Total total{0, 0};
+        Note note;
+        while (requests.next(note)) add(total, note);
+        return total;
+    }
+
+    void running(bebop::StreamReader<Note>& requests, bebop::StreamWriter<Total>& responses, bebop::CallContext&) override {
+        Total total{0, 0};
+        Note note;
+        while (requests.next(note)) {
+            add(total, note);
+            responses.write(total);
+        }
+    }
+
+private:
+    static void add(Total& total, const Note& note) {
+        total.notes++;
+        total.count += note.count.value_or(0);
+    }
+};
+
+static Note makeNote(const char* text, uint32_t count) {
+    Note note;
+    note.text = text;
+    note.count = count;
+    return note;
+}
+
+int main() {
+    Notebook notebook;
+    bebop::InProcessTransport transport{notebook};
+    NotebookClient client{transport};
+
+    Note echoed;
+    if (!client.echo(makeNote("hello", 1), echoed) || echoed.text != "hello") return 1;
+    const auto failed = client.echo(makeNote("fail", 1), echoed);
+    if (failed.status != bebop::RpcStatus::Failed || failed.error != "asked to fail") return 1;
+
+    size_t repeated = 0;
+    if (!client.repeat(makeNote("again", 5), [&](const Note& note) { repeated += note.text == "again"; }) || repeated != 5) return 1;
+
+    uint32_t sent = 0;
+    Total total{0, 0};
+    const auto nextNote = [&](Note& note) {
+        if (sent == 4) return false;
+        note = makeNote("n", ++sent);
+        return true;
+    };
+    if (!client.tally(nextNote, total) || total.notes != 4 || total.count != 10) return 1;
+
+    // Duplex streams interleave: each response arrives before the next request is produced.
+    sent = 0;
+    std::vector<uint32_t> runningCounts;
+    const auto duplex = client.running(
+        [&](Note& note) {
+            if (runningCounts.size() != sent) return false;
+            return nextNote(note);
+        },
+        [&](const Total& t) { runningCounts.push_back(t.count); });
+    if (!duplex || runningCounts != std::vector<uint32_t>{1, 3, 6, 10}) return 1;
+
+    // Unknown methods and undecodable requests are reported, not thrown.
+    {
+        bebop::detail::SinglePayload requests;
+        requests.payload = {1, 2, 3};
+        bebop::detail::FirstPayload responses;
+        bebop::CallContext context;
+        transport.call(NotebookClient::echoId, bebop::MethodType::Unary, requests, responses, context);
+        if (context.status != bebop::RpcStatus::MalformedPacket || responses.received) return 1;
+        context = {};
+        transport.call(0, bebop::MethodType::Unary, requests, responses, context);
+        if (context.status != bebop::RpcStatus::UnknownMethod) return 1;
+    }
+
+    // What a call costs beyond the handler itself: encoding, decoding and dispatch.
+    const Note request = makeNote("The quick brown fox jumps over the lazy dog", 7);
+    const size_t calls = 200000;
+    bebop::CallContext context;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < calls; i++) {
+        echoed = notebook.echo(request, context);
+    }
+    const auto direct = std::chrono::steady_clock::now() - start;
+    start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < calls; i++) {
+        if (!client.echo(request, echoed)) return 1;
+    }
+    const auto inProcess = std::chrono::steady_clock::now() - start;
+    printf("echo: %.1f ns/call direct, %.1f ns/call in process\n",
+        std::chrono::duration<double, std::nano>(direct).count() / calls,
+        std::chrono::duration<double, std::nano>(inProcess).count() / calls);
+    printf("all method types round-tripped in process\n");
+    return 0;
+}
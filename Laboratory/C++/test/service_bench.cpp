@@ -0,0 +1,77 @@
+#include "../gen/service.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Load generator for the socket transport: `concurrency` callers share one connection, each making echo
+// calls back to back, so that many calls are in flight at once. Reports throughput and latency percentiles.
+
+class Notebook final : public BaseNotebookService {
+public:
+    Note echo(const Note& request, bebop::CallContext&) override { return request; }
+    void repeat(const Note&, bebop::StreamWriter<Note>&, bebop::CallContext&) override {}
+    Total tally(bebop::StreamReader<Note>&, bebop::CallContext&) override { return Total{0, 0}; }
+    void running(bebop::StreamReader<Note>&, bebop::StreamWriter<Total>&, bebop::CallContext&) override {}
+};
+
+using Clock = std::chrono::steady_clock;
+
+static void run(NotebookClient& client, size_t concurrency, size_t calls, bool report = true) {
+    Note request;
+    request.text = "The quick brown fox jumps over the lazy dog";
+    request.count = 7;
+
+    std::vector<std::vector<double>> latencies(concurrency);
+    std::vector<std::thread> callers;
+    const auto start = Clock::now();
+    for (size_t c = 0; c < concurrency; c++) {
+        callers.emplace_back([&, c] {
+            Note response;
+            auto& mine = latencies[c];
+            mine.reserve(calls / concurrency);
+            for (size_t i = 0; i < calls / concurrency; i++) {
+                const auto begin = Clock::now();
+                if (!client.echo(request, response)) abort();
+                mine.push_back(std::chrono::duration<double, std::micro>(Clock::now() - begin).count());
+            }
+        });
+    }
+    for (auto& caller : callers) caller.join();
+    const double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+    if (!report) return;
+    std::vector<double> all;
+    for (auto& mine : latencies) all.insert(all.end(), mine.begin(), mine.end());
+    std::sort(all.begin(), all.end());
+    const auto percentile = [&](double p) { return all[std::min(all.size() - 1, static_cast<size_t>(p * all.size()))]; };
+    printf("%11zu %12.0f %10.1f %10.1f %10.1f\n", concurrency, all.size() / seconds, percentile(0.5), percentile(0.99), all.back());
+}
+
+int main(int argc, char** argv) {
+    const size_t calls = argc > 1 ? std::stoul(argv[1]) : 64000;
+    const std::string path = "/tmp/bebop_service_bench_" + std::to_string(::getpid());
+    ::unlink(path.c_str());
+    const int listener = bebop::listenUnix(path.c_str());
+    if (listener < 0) return 1;
+    Notebook notebook;
+    bebop::SocketServer server{notebook};
+    std::thread serving([&] { server.run(listener); });
+
+    {
+        bebop::SocketTransport transport{bebop::connectUnix(path.c_str())};
+        NotebookClient client{transport};
+        printf("Unary echo over one Unix socket connection (%zu calls per row)\n", calls);
+        printf("concurrency    calls/s    p50 (us)   p99 (us)   max (us)\n");
+        run(client, 1, calls / 8, false);
+        for (size_t concurrency = 1; concurrency <= 64; concurrency *= 2) run(client, concurrency, calls);
+    }
+
+    server.stop();
+    serving.join();
+    ::close(listener);
+    ::unlink(path.c_str());
+    return 0;
+}
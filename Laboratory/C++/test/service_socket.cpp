@@ -0,0 +1,135 @@
+#include "../gen/service.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Echo holds each note for `count` milliseconds, so concurrent calls finish out of order.
+class Notebook final : public BaseNotebookService {
+public:
+    Note echo(const Note& request, bebop::CallContext& context) override {
+        std::this_thread::sleep_for(std::chrono::milliseconds(request.count.value_or(0)));
+        if (request.text == "fail") context.fail("asked to fail");
+        return request;
+    }
+
+    void repeat(const Note& request, bebop::StreamWriter<Note>& responses, bebop::CallContext&) override {
+        for (uint32_t i = 0; i < request.count.value_or(0); i++) {
+            if (!responses.write(request)) return;
+        }
+    }
+
+    Total tally(bebop::StreamReader<Note>& requests, bebop::CallContext&) override {
+        Total total{0, 0};
+        Note note;
+        while (requests.next(note)) add(total, note);
+        return total;
+    }
+
+    void running(bebop::StreamReader<Note>& requests, bebop::StreamWriter<Total>& responses, bebop::CallContext&) override {
+        Total total{0, 0};
+        Note note;
+        while (requests.next(note)) {
+            add(total, note);
+            responses.write(total);
+        }
+    }
+
+private:
+    static void add(Total& total, const Note& note) {
+        total.notes++;
+        total.count += note.count.value_or(0);
+    }
+};
+
+static Note makeNote(const std::string& text, uint32_t count) {
+    Note note;
+    note.text = text;
+    note.count = count;
+    return note;
+}
+
+int main() {
+    const std::string path = "/tmp/bebop_service_socket_" + std::to_string(::getpid());
+    ::unlink(path.c_str());
+    const int listener = bebop::listenUnix(path.c_str());
+    if (listener < 0) return 1;
+    Notebook notebook;
+    bebop::SocketServer server{notebook, 8};
+    std::thread serving([&] { server.run(listener); });
+
+    {
+        bebop::SocketTransport transport{bebop::connectUnix(path.c_str())};
+        NotebookClient client{transport};
+
+        Note echoed;
+        if (!client.echo(makeNote("hello", 0), echoed) || echoed.text != "hello") return 1;
+        const auto failed = client.echo(makeNote("fail", 0), echoed);
+        if (failed.status != bebop::RpcStatus::Failed || failed.error != "asked to fail") return 1;
+
+        size_t repeated = 0;
+        if (!client.repeat(makeNote("again", 1000), [&](const Note& note) { repeated += note.text == "again"; }) || repeated != 1000) return 1;
+
+        uint32_t sent = 0;
+        Total total{0, 0};
+        const auto nextNote = [&](Note& note) {
+            if (sent == 100) return false;
+            note = makeNote("n", ++sent);
+            return true;
+        };
+        if (!client.tally(nextNote, total) || total.notes != 100 || total.count != 5050) return 1;
+
+        sent = 0;
+        std::vector<uint32_t> runningCounts;
+        if (!client.running(nextNote, [&](const Total& t) { runningCounts.push_back(t.count); }) || runningCounts.size() != 100 ||
+            runningCounts.back() != 5050) {
+            return 1;
+        }
+
+        // Calls from many threads share the connection, and each returns as soon as its own handler does.
+        std::atomic<int> order{0};
+        std::vector<int> finished(8);
+        std::vector<std::thread> callers;
+        for (int i = 0; i < 8; i++) {
+            callers.emplace_back([&, i] {
+                Note response;
+                const auto note = makeNote("call " + std::to_string(i), static_cast<uint32_t>(20 * (8 - i)));
+                if (client.echo(note, response) && response.text == note.text) finished[i] = ++order;
+            });
+        }
+        for (auto& caller : callers) caller.join();
+        for (int i = 0; i < 8; i++) {
+            if (finished[i] == 0) return 1;
+        }
+        if (finished[0] < finished[7]) return 1;
+        printf("8 concurrent calls finished in order:");
+        for (int i = 0; i < 8; i++) printf(" %d", finished[i]);
+        printf("\n");
+
+        // A raw call to a method the service does not have.
+        bebop::detail::SinglePayload requests;
+        bebop::detail::FirstPayload responses;
+        bebop::CallContext context;
+        transport.call(0, bebop::MethodType::Unary, requests, responses, context);
+        if (context.status != bebop::RpcStatus::UnknownMethod) return 1;
+    }
+
+    server.stop();
+    serving.join();
+    ::close(listener);
+    ::unlink(path.c_str());
+
+    // Once the connection is gone, calls fail instead of hanging.
+    int pair[2];
+    if (::socketpair(AF_UNIX, SOCK_STREAM, 0, pair) != 0) return 1;
+    ::close(pair[1]);
+    bebop::SocketTransport orphan{pair[0]};
+    NotebookClient client{orphan};
+    Note echoed;
+    if (client.echo(makeNote("anyone?", 0), echoed).status != bebop::RpcStatus::Unavailable) return 1;
+
+    printf("all method types round-tripped over a Unix socket\n");
+    return 0;
+}
@@ -0,0 +1,53 @@
+// Build with: ./run_test.sh union_perf_a union_perf_a_reuse reuseStorage=true
+#include "../gen/union_perf_a.hpp"
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <string>
+#include <vector>
+#include "count_allocations.hpp"
+
+int main() {
+    // A steady stream of A14 records whose strings are too long for the small string optimization.
+    std::vector<std::vector<uint8_t>> stream;
+    for (int i = 0; i < 64; i++) {
+        A14 inner;
+        inner.i14 = i;
+        inner.u = 11111;
+        inner.f = 3.14;
+        inner.s = "a payload string that does not fit inline, #" + std::to_string(i);
+        inner.g = bebop::Guid::fromString("81c6987b-48b7-495f-ad01-ec20cc5f5be1");
+        inner.b = true;
+        UnionPerfA a;
+        a.containerOpcode = 123;
+        a.protocolVersion = 456;
+        a.u.variant.emplace<A14>(inner);
+        stream.push_back(UnionPerfA::encode(a));
+    }
+
+    // Once the target has grown to fit the stream, decoding into it again allocates nothing.
+    UnionPerfA target;
+    for (const auto& buf : stream) UnionPerfA::decodeInto(buf, target);
+    const size_t before = allocations;
+    int32_t sum = 0;
+    for (int pass = 0; pass < 100; pass++) {
+        for (const auto& buf : stream) {
+            UnionPerfA::decodeInto(buf, target);
+            sum += std::get<A14>(target.u.variant).i14;
+        }
+    }
+    if (allocations != before) {
+        printf("decoding %zu records made %zu allocations\n", 100 * stream.size(), allocations - before);
+        return 1;
+    }
+    if (sum != 100 * (63 * 64 / 2) || std::get<A14>(target.u.variant).s != "a payload string that does not fit inline, #63") return 1;
+
+    // Switching branches still decodes correctly.
+    UnionPerfA other;
+    other.u.variant.emplace<A2>().s = "two";
+    UnionPerfA::decodeInto(UnionPerfA::encode(other), target);
+    if (target.u.variant.index() != 1 || std::get<A2>(target.u.variant).s != "two") return 1;
+
+    printf("decoded %zu records without allocating\n", 100 * stream.size());
+    return 0;
+}
@@ -186,6 +186,24 @@ int main()
     printf("Instrument: %d (Sax=%d)\n", decoded_performers.data[0].plays,
            INSTRUMENT_SAX);
 
+    // Encode again through a segmented writer with tiny chunks
+    bebop_writer_t segmented;
+    assert(bebop_context_get_segmented_writer(context, 8, &segmented) == BEBOP_OK);
+    assert(library_encode_into(&l, &segmented) == BEBOP_OK);
+    assert(bebop_writer_length(&segmented) == buffer_length);
+
+    const bebop_segment_t *segments;
+    size_t segment_count;
+    assert(bebop_writer_get_segments(&segmented, &segments, &segment_count) == BEBOP_OK);
+    size_t offset = 0;
+    for (size_t i = 0; i < segment_count; i++)
+    {
+        assert(memcmp(buffer + offset, segments[i].data, segments[i].length) == 0);
+        offset += segments[i].length;
+    }
+    assert(offset == buffer_length);
+    printf("Segmented encoding matches across %zu segments\n", segment_count);
+
     // Test malformed packet handling
     printf("\nTesting malformed packet handling...\n");
     uint8_t malformed_buffer[] = {123, 123, 123, 123, 123};
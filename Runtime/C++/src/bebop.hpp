@@ -1,12 +1,27 @@
 #pragma once
 
+#include <algorithm>
+#include <atomic>
 #include <chrono>
 #include <cstddef>
 #include <cstdint>
+#include <cstdlib>
 #include <cstring>
 #include <exception>
+#include <functional>
+#include <iterator>
+#include <map>
 #include <memory>
+#include <mutex>
+#include <new>
+#include <optional>
+#include <stdexcept>
 #include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <variant>
 #include <vector>
 
 #ifndef BEBOPC_VER_MAJOR
@@ -34,6 +49,91 @@
 #define BEBOP_ASSUME_LITTLE_ENDIAN 1
 #endif
 
+#ifndef BEBOP_HAS_MEMORY_RESOURCE
+#if __has_include(<memory_resource>)
+#define BEBOP_HAS_MEMORY_RESOURCE 1
+#else
+#define BEBOP_HAS_MEMORY_RESOURCE 0
+#endif
+#endif
+
+#if BEBOP_HAS_MEMORY_RESOURCE
+#include <memory_resource>
+#endif
+
+#ifndef BEBOP_HAS_POSIX_IO
+#if defined(__unix__) || defined(__APPLE__)
+#define BEBOP_HAS_POSIX_IO 1
+#else
+#define BEBOP_HAS_POSIX_IO 0
+#endif
+#endif
+
+#if BEBOP_HAS_POSIX_IO
+#include <cerrno>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+/// Instrumentation is compiled in only on request: with BEBOP_INSTRUMENTATION off, every hook
+/// expands to nothing. BEBOP_INSTRUMENT_PRIMITIVES can turn off just the per-primitive counters,
+/// which fire on every read and write.
+#ifndef BEBOP_INSTRUMENTATION
+#define BEBOP_INSTRUMENTATION 0
+#endif
+#ifndef BEBOP_INSTRUMENT_PRIMITIVES
+#define BEBOP_INSTRUMENT_PRIMITIVES BEBOP_INSTRUMENTATION
+#endif
+#if BEBOP_INSTRUMENT_PRIMITIVES && !BEBOP_INSTRUMENTATION
+#error "BEBOP_INSTRUMENT_PRIMITIVES requires BEBOP_INSTRUMENTATION"
+#endif
+
+#if BEBOP_INSTRUMENTATION
+#include <atomic>
+#include <cstdio>
+#include <mutex>
+#include <unordered_map>
+#endif
+
+#ifndef BEBOP_EXCEPTIONS
+#if defined(__cpp_exceptions) || defined(__EXCEPTIONS) || defined(_CPPUNWIND)
+#define BEBOP_EXCEPTIONS 1
+#else
+#define BEBOP_EXCEPTIONS 0
+#endif
+#endif
+
+/// Without exceptions (-fno-exceptions), anything that would throw aborts instead.
+/// Use the `tryDecodeInto` API to handle malformed input in such builds.
+#if BEBOP_EXCEPTIONS
+#define BEBOP_THROW(exception) throw exception
+#else
+#define BEBOP_THROW(exception) std::abort()
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+#define BEBOP_COLD __attribute__((cold, noinline))
+#ifndef BEBOP_UNLIKELY
+#define BEBOP_UNLIKELY(x) __builtin_expect(!!(x), 0)
+#endif
+#elif defined(_MSC_VER)
+#define BEBOP_COLD __declspec(noinline)
+#endif
+#ifndef BEBOP_COLD
+#define BEBOP_COLD
+#endif
+#ifndef BEBOP_UNLIKELY
+#define BEBOP_UNLIKELY(x) (x)
+#endif
+
 namespace bebop {
 
 /// A "tick" is a ten-millionth of a second, or 100ns.
@@ -45,6 +145,16 @@ namespace {
     const int64_t ticksBetweenEpochs = 621355968000000000;
 }
 
+/// Convert a date to its wire form: ticks since 1/1/0001, with the top two (DateTimeKind) bits clear.
+inline uint64_t dateToTicks(TickDuration duration) {
+    return (duration.count() + ticksBetweenEpochs) & 0x3fffffffffffffff;
+}
+
+/// Convert the wire form of a date back to a duration since the Unix Epoch.
+inline TickDuration ticksToDate(uint64_t ticks) {
+    return TickDuration((ticks & 0x3fffffffffffffff) - ticksBetweenEpochs);
+}
+
 enum class GuidStyle {
     Dashes,
     NoDashes,
@@ -56,6 +166,28 @@ struct MalformedPacketException : public std::exception {
     }
 };
 
+/// What a Reader does when it finds the buffer is malformed.
+enum class ErrorMode {
+    /// Throw MalformedPacketException.
+    Throw,
+    /// Record the failure in the reader's status and carry on reading zeroes.
+    Status,
+};
+
+enum class DecodeStatus {
+    Ok,
+    MalformedPacket,
+};
+
+/// The outcome of an exception-free `tryDecodeInto`.
+struct DecodeResult {
+    DecodeStatus status;
+    size_t bytesRead;
+
+    bool ok() const { return status == DecodeStatus::Ok; }
+    explicit operator bool() const { return ok(); }
+};
+
 #pragma pack(push, 1)
 struct Guid {
     /// The GUID data is stored the way it is to match the memory layout
@@ -98,19 +230,7 @@ struct Guid {
         m_j = bytes[14];
         m_k = bytes[15];
     }
-    Guid(Guid const& other) {
-        m_a = other.m_a;
-        m_b = other.m_b;
-        m_c = other.m_c;
-        m_d = other.m_d;
-        m_e = other.m_e;
-        m_f = other.m_f;
-        m_g = other.m_g;
-        m_h = other.m_h;
-        m_i = other.m_i;
-        m_j = other.m_j;
-        m_k = other.m_k;
-    }
+    Guid(Guid const& other) = default;
 
     static Guid fromString(const std::string& string) {
         uint8_t bytes[16];
@@ -197,28 +317,629 @@ private:
 };
 #pragma pack(pop)
 
-class Reader {
+// Maps
+//
+// Generated maps are std::map by default. The generator's `mapContainer`
+// setting can make them `flat` (a bebop::FlatMap) or `unordered` (a
+// std::unordered_map) instead. A FlatMap keeps its entries in one sorted
+// vector: lookups are binary searches over contiguous memory and there is no
+// allocation per entry. Decoding appends every entry unsorted and sorts once
+// at the end. Whatever the container, a map encodes its entries in key order,
+// so equal records always encode to identical bytes. An unordered map is
+// sorted through per-thread scratch storage, which stops allocating once it
+// has grown to fit.
+
+/// A map kept as a vector of key-value pairs sorted by key, with the std::map operations that
+/// generated code and most callers need. Inserting into the middle is linear, so build a FlatMap
+/// in bulk (with `appendUnsorted` and `sortAppended`) or decode it, rather than one key at a time.
+template<typename K, typename V, typename Compare = std::less<K>> class FlatMap {
+public:
+    using key_type = K;
+    using mapped_type = V;
+    using value_type = std::pair<K, V>;
+    using container_type = std::vector<value_type>;
+    using iterator = typename container_type::iterator;
+    using const_iterator = typename container_type::const_iterator;
+    using size_type = size_t;
+
+    FlatMap() = default;
+    FlatMap(std::initializer_list<value_type> entries) : m_entries(entries) { sortAppended(); }
+
+    iterator begin() { return m_entries.begin(); }
+    iterator end() { return m_entries.end(); }
+    const_iterator begin() const { return m_entries.begin(); }
+    const_iterator end() const { return m_entries.end(); }
+    size_t size() const { return m_entries.size(); }
+    bool empty() const { return m_entries.empty(); }
+    void clear() { m_entries.clear(); }
+    void reserve(size_t capacity) { m_entries.reserve(capacity); }
+    /// The sorted entries themselves.
+    const container_type& entries() const { return m_entries; }
+
+    iterator lower_bound(const K& key) {
+        return std::lower_bound(m_entries.begin(), m_entries.end(), key, KeyLess{});
+    }
+    const_iterator lower_bound(const K& key) const {
+        return std::lower_bound(m_entries.begin(), m_entries.end(), key, KeyLess{});
+    }
+    iterator find(const K& key) {
+        const auto it = lower_bound(key);
+        return it != m_entries.end() && !Compare{}(key, it->first) ? it : m_entries.end();
+    }
+    const_iterator find(const K& key) const {
+        const auto it = lower_bound(key);
+        return it != m_entries.end() && !Compare{}(key, it->first) ? it : m_entries.end();
+    }
+    size_t count(const K& key) const { return find(key) != end() ? 1 : 0; }
+    bool contains(const K& key) const { return find(key) != end(); }
+
+    V& at(const K& key) {
+        const auto it = find(key);
+        if (it == end()) BEBOP_THROW(std::out_of_range("bebop::FlatMap::at"));
+        return it->second;
+    }
+    const V& at(const K& key) const {
+        const auto it = find(key);
+        if (it == end()) BEBOP_THROW(std::out_of_range("bebop::FlatMap::at"));
+        return it->second;
+    }
+
+    template<typename... Args> std::pair<iterator, bool> try_emplace(const K& key, Args&&... args) {
+        const auto it = lower_bound(key);
+        if (it != m_entries.end() && !Compare{}(key, it->first)) return {it, false};
+        return {m_entries.emplace(it, std::piecewise_construct, std::forward_as_tuple(key), std::forward_as_tuple(std::forward<Args>(args)...)), true};
+    }
+    template<typename T> std::pair<iterator, bool> insert_or_assign(const K& key, T&& value) {
+        auto result = try_emplace(key, std::forward<T>(value));
+        if (!result.second) result.first->second = std::forward<T>(value);
+        return result;
+    }
+    V& operator[](const K& key) { return try_emplace(key).first->second; }
+
+    size_t erase(const K& key) {
+        const auto it = find(key);
+        if (it == end()) return 0;
+        m_entries.erase(it);
+        return 1;
+    }
+    iterator erase(const_iterator position) { return m_entries.erase(position); }
+
+    /// Append an entry without keeping the map sorted, and return its value. Call `sortAppended`
+    /// before using the map in any other way.
+    V& appendUnsorted(K&& key) {
+        return m_entries.emplace_back(std::piecewise_construct, std::forward_as_tuple(std::move(key)), std::forward_as_tuple()).second;
+    }
+
+    /// Sort entries added by `appendUnsorted`. Of several entries with the same key, the last one
+    /// appended wins, as it would with std::map's operator[].
+    void sortAppended() {
+        if (std::is_sorted(m_entries.begin(), m_entries.end(), EntryLessOrEqual{})) return;
+        std::stable_sort(m_entries.begin(), m_entries.end(), EntryLess{});
+        // Keep the last of each run of equal keys.
+        auto out = m_entries.begin();
+        for (auto it = m_entries.begin(); it != m_entries.end(); ++it) {
+            const auto next = std::next(it);
+            if (next != m_entries.end() && !Compare{}(it->first, next->first)) continue;
+            if (out != it) *out = std::move(*it);
+            ++out;
+        }
+        m_entries.erase(out, m_entries.end());
+    }
+
+    bool operator==(const FlatMap& other) const { return m_entries == other.m_entries; }
+    bool operator!=(const FlatMap& other) const { return m_entries != other.m_entries; }
+
+private:
+    struct KeyLess {
+        bool operator()(const value_type& entry, const K& key) const { return Compare{}(entry.first, key); }
+    };
+    struct EntryLess {
+        bool operator()(const value_type& a, const value_type& b) const { return Compare{}(a.first, b.first); }
+    };
+    // Sorted by this means strictly increasing keys, with no duplicates, so there is nothing to do.
+    struct EntryLessOrEqual {
+        bool operator()(const value_type& a, const value_type& b) const { return !Compare{}(b.first, a.first); }
+    };
+
+    container_type m_entries;
+};
+
+namespace detail {
+    /// Per-thread vectors for sorting map entries, one per level of maps nested inside maps, kept
+    /// between encodes so that sorting allocates only until they have grown to fit.
+    struct EntryScratch {
+        std::vector<std::vector<const void*>> levels;
+        size_t depth = 0;
+    };
+
+    inline EntryScratch& entryScratch() {
+        thread_local EntryScratch scratch;
+        return scratch;
+    }
+} // namespace detail
+
+/// Pointers to the entries of an unordered map, sorted by key, for deterministic encoding. They
+/// live in this thread's scratch storage until the SortedEntries is destroyed.
+template<typename M> class SortedEntries {
+    using entry_type = typename M::value_type;
+    size_t m_level;
+public:
+    class const_iterator {
+        const void* const* m_entry;
+    public:
+        explicit const_iterator(const void* const* entry) : m_entry(entry) {}
+        const entry_type* operator*() const { return static_cast<const entry_type*>(*m_entry); }
+        const_iterator& operator++() { ++m_entry; return *this; }
+        bool operator!=(const const_iterator& other) const { return m_entry != other.m_entry; }
+    };
+
+    explicit SortedEntries(const M& map) {
+        auto& scratch = detail::entryScratch();
+        m_level = scratch.depth;
+        if (m_level == scratch.levels.size()) scratch.levels.emplace_back();
+        auto& entries = scratch.levels[m_level];
+        entries.clear();
+        for (const auto& entry : map) entries.push_back(&entry);
+        std::sort(entries.begin(), entries.end(), [](const void* a, const void* b) {
+            return static_cast<const entry_type*>(a)->first < static_cast<const entry_type*>(b)->first;
+        });
+        // Claim the level only once nothing can throw, since the destructor is what releases it.
+        scratch.depth++;
+    }
+    ~SortedEntries() { detail::entryScratch().depth--; }
+    SortedEntries(SortedEntries const&) = delete;
+    void operator=(SortedEntries const&) = delete;
+
+    // A nested SortedEntries may grow `levels`, which moves the vectors but not their elements.
+    const_iterator begin() const { return const_iterator(detail::entryScratch().levels[m_level].data()); }
+    const_iterator end() const {
+        const auto& entries = detail::entryScratch().levels[m_level];
+        return const_iterator(entries.data() + entries.size());
+    }
+};
+
+template<typename M> SortedEntries<M> sortedEntries(const M& map) { return SortedEntries<M>(map); }
+
+// Reusing storage
+//
+// With the generator's `reuseStorage` setting, `decodeInto` decodes into the
+// storage its target already has: vectors are resized rather than replaced,
+// so their capacity and the elements they keep survive, and optional fields
+// and union branches that are already engaged are decoded into directly.
+// Decoding a stream of similarly shaped records into one object then stops
+// allocating once the object has grown to fit them.
+
+/// The value of `target`, constructed from `args` only if `target` is empty.
+template<typename T, typename... Args> T& reuse(std::optional<T>& target, Args&&... args) {
+    if (!target) target.emplace(std::forward<Args>(args)...);
+    return *target;
+}
+
+/// Alternative `I` of `target`, constructed from `args` only if `target` holds another alternative.
+template<size_t I, typename... T, typename... Args> auto& reuse(std::variant<T...>& target, Args&&... args) {
+    if (target.index() != I) target.template emplace<I>(std::forward<Args>(args)...);
+    return std::get<I>(target);
+}
+
+/// Make `values` hold `length` elements, keeping the ones it has and constructing new ones from `args`.
+template<typename V, typename... Args> void resizeReusing(V& values, size_t length, const Args&... args) {
+    if (values.size() > length) values.erase(values.begin() + length, values.end());
+    values.reserve(length);
+    while (values.size() < length) values.emplace_back(args...);
+}
+
+// Instrumentation
+//
+// With BEBOP_INSTRUMENTATION defined to 1, every generated `encodeInto` and
+// `decodeInto` counts its calls, the bytes it wrote or read, the time it took
+// and the allocations made meanwhile, per record type and operation. Nested
+// records are counted in their own right and also inside their parent, so
+// times and bytes are inclusive. Reader and Writer primitives count their
+// calls and bytes per primitive kind; a string is a uint32 length plus a
+// string body, so every byte is counted exactly once.
+//
+// Counters live in per-thread tables that only their own thread writes, with
+// plain relaxed loads and stores, so counting never takes a lock or a locked
+// instruction. `snapshot()` sums every live thread, plus every thread that has
+// exited, into totals that only ever grow; export them with `toText()`, in the
+// Prometheus text format, or `toJson()`.
+//
+// The runtime cannot see the heap, so allocations are whatever the program
+// reports with `noteAllocation()`, typically from a replaced operator new.
+
+#if BEBOP_INSTRUMENTATION
+namespace instrumentation {
+
+enum class Operation : uint8_t { Encode, Decode };
+enum class Direction : uint8_t { Read, Write };
+enum class Primitive : uint8_t { Byte, Uint16, Uint32, Uint64, Guid, String, Bytes, Raw, Array };
+constexpr size_t primitiveKinds = 9;
+
+inline const char* name(Operation operation) { return operation == Operation::Encode ? "encode" : "decode"; }
+inline const char* name(Direction direction) { return direction == Direction::Read ? "read" : "write"; }
+inline const char* name(Primitive primitive) {
+    static const char* const names[primitiveKinds] = {"byte", "uint16", "uint32", "uint64", "guid", "string", "bytes", "raw", "array"};
+    return names[static_cast<size_t>(primitive)];
+}
+
+struct RecordCounters {
+    uint64_t calls = 0;
+    uint64_t bytes = 0;
+    uint64_t nanoseconds = 0;
+    uint64_t allocations = 0;
+};
+
+struct PrimitiveCounters {
+    uint64_t calls = 0;
+    uint64_t bytes = 0;
+};
+
+/// Totals across every thread at one moment.
+struct Snapshot {
+    struct Record {
+        std::string type;
+        Operation operation;
+        RecordCounters counters;
+    };
+    /// Every record type and operation that has been counted, by type name.
+    std::vector<Record> records;
+    /// Indexed by Direction, then Primitive.
+    PrimitiveCounters primitives[2][primitiveKinds];
+
+    std::string toText() const;
+    std::string toJson() const;
+};
+
+namespace detail {
+    /// A counter written by one thread and read by any: the owner's read-modify-write needs no atomicity.
+    struct Counter {
+        std::atomic<uint64_t> value{0};
+        void add(uint64_t n) { value.store(value.load(std::memory_order_relaxed) + n, std::memory_order_relaxed); }
+        uint64_t get() const { return value.load(std::memory_order_relaxed); }
+    };
+
+    struct RecordSlot {
+        Counter calls, bytes, nanoseconds, allocations;
+    };
+
+    // A thread's record slots, two per type (encode, decode), are allocated a block at a time so
+    // that a snapshot can walk them while the owner adds more.
+    constexpr size_t slotsPerBlock = 64;
+    constexpr size_t maxBlocks = 256;
+
+    struct ThreadCounters {
+        std::atomic<RecordSlot*> blocks[maxBlocks] = {};
+        Counter primitiveCalls[2][primitiveKinds];
+        Counter primitiveBytes[2][primitiveKinds];
+
+        ~ThreadCounters() {
+            for (auto& block : blocks) delete[] block.load(std::memory_order_relaxed);
+        }
+
+        RecordSlot* slot(size_t index) {
+            const size_t b = index / slotsPerBlock;
+            if (BEBOP_UNLIKELY(b >= maxBlocks)) return nullptr;
+            RecordSlot* block = blocks[b].load(std::memory_order_relaxed);
+            if (BEBOP_UNLIKELY(!block)) {
+                block = new RecordSlot[slotsPerBlock];
+                blocks[b].store(block, std::memory_order_release);
+            }
+            return &block[index % slotsPerBlock];
+        }
+    };
+
+    struct Registry {
+        std::mutex mutex;
+        std::vector<std::string> typeNames;
+        std::unordered_map<std::string, uint32_t> typeIds;
+        std::vector<ThreadCounters*> threads;
+        // The totals of threads that have exited, indexed by slot.
+        std::vector<RecordCounters> retiredRecords;
+        PrimitiveCounters retiredPrimitives[2][primitiveKinds];
+
+        void fold(const ThreadCounters& counters, std::vector<RecordCounters>& records, PrimitiveCounters (&primitives)[2][primitiveKinds]) {
+            records.resize(typeNames.size() * 2);
+            for (size_t i = 0; i < records.size(); i++) {
+                const RecordSlot* block = counters.blocks[i / slotsPerBlock].load(std::memory_order_acquire);
+                if (!block) {
+                    i += slotsPerBlock - 1 - i % slotsPerBlock;
+                    continue;
+                }
+                const RecordSlot& slot = block[i % slotsPerBlock];
+                records[i].calls += slot.calls.get();
+                records[i].bytes += slot.bytes.get();
+                records[i].nanoseconds += slot.nanoseconds.get();
+                records[i].allocations += slot.allocations.get();
+            }
+            for (size_t d = 0; d < 2; d++) {
+                for (size_t p = 0; p < primitiveKinds; p++) {
+                    primitives[d][p].calls += counters.primitiveCalls[d][p].get();
+                    primitives[d][p].bytes += counters.primitiveBytes[d][p].get();
+                }
+            }
+        }
+    };
+
+    /// Never destroyed, so that threads exiting after main returns can still retire their counters.
+    inline Registry& registry() {
+        static Registry* registry = new Registry;
+        return *registry;
+    }
+
+    struct ThreadHandle {
+        ThreadCounters* counters = new ThreadCounters;
+        ThreadHandle() {
+            auto& r = registry();
+            std::lock_guard<std::mutex> lock{r.mutex};
+            r.threads.push_back(counters);
+        }
+        ~ThreadHandle() {
+            auto& r = registry();
+            std::lock_guard<std::mutex> lock{r.mutex};
+            r.fold(*counters, r.retiredRecords, r.retiredPrimitives);
+            r.threads.erase(std::find(r.threads.begin(), r.threads.end(), counters));
+            delete counters;
+        }
+    };
+
+    inline ThreadCounters& local() {
+        thread_local ThreadHandle handle;
+        return *handle.counters;
+    }
+
+    /// Trivially constructed, so that an operator new may bump it even while this thread's counters are being set up.
+    inline thread_local uint64_t allocations = 0;
+
+    template<typename IO, typename = void> struct IsReader : std::false_type {};
+    template<typename IO> struct IsReader<IO, std::void_t<decltype(std::declval<IO&>().bytesRead())>> : std::true_type {};
+
+    template<typename IO> size_t position(IO& io) {
+        if constexpr (IsReader<IO>::value) return io.bytesRead();
+        else return io.length();
+    }
+} // namespace detail
+
+/// The id of a record type, by name; each distinct name gets its own id.
+inline uint32_t typeId(const char* typeName) {
+    auto& r = detail::registry();
+    std::lock_guard<std::mutex> lock{r.mutex};
+    const auto [it, added] = r.typeIds.emplace(typeName, static_cast<uint32_t>(r.typeNames.size()));
+    if (added) r.typeNames.emplace_back(typeName);
+    return it->second;
+}
+
+/// Report one heap allocation on this thread.
+inline void noteAllocation() { detail::allocations++; }
+
+inline void countPrimitive(Direction direction, Primitive primitive, size_t bytes) {
+    auto& counters = detail::local();
+    counters.primitiveCalls[static_cast<size_t>(direction)][static_cast<size_t>(primitive)].add(1);
+    counters.primitiveBytes[static_cast<size_t>(direction)][static_cast<size_t>(primitive)].add(bytes);
+}
+
+/// Counts one generated `encodeInto` or `decodeInto` call from construction to destruction.
+template<typename IO> class RecordScope {
+    IO& m_io;
+    detail::RecordSlot* m_slot;
+    size_t m_start;
+    uint64_t m_allocations;
+    std::chrono::steady_clock::time_point m_begin;
+public:
+    RecordScope(uint32_t type, Operation operation, IO& io)
+        : m_io(io), m_slot(detail::local().slot(type * 2 + static_cast<size_t>(operation))), m_start(detail::position(io)),
+          m_allocations(detail::allocations), m_begin(std::chrono::steady_clock::now()) {}
+    RecordScope(RecordScope const&) = delete;
+    void operator=(RecordScope const&) = delete;
+
+    ~RecordScope() {
+        const auto elapsed = std::chrono::steady_clock::now() - m_begin;
+        if (!m_slot) return;
+        m_slot->calls.add(1);
+        m_slot->bytes.add(detail::position(m_io) - m_start);
+        m_slot->nanoseconds.add(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+        m_slot->allocations.add(detail::allocations - m_allocations);
+    }
+};
+
+inline Snapshot snapshot() {
+    auto& r = detail::registry();
+    std::lock_guard<std::mutex> lock{r.mutex};
+    Snapshot result;
+    std::vector<RecordCounters> records = r.retiredRecords;
+    for (size_t d = 0; d < 2; d++) {
+        for (size_t p = 0; p < primitiveKinds; p++) result.primitives[d][p] = r.retiredPrimitives[d][p];
+    }
+    for (const auto* counters : r.threads) r.fold(*counters, records, result.primitives);
+    records.resize(r.typeNames.size() * 2);
+    for (size_t i = 0; i < records.size(); i++) {
+        if (records[i].calls) result.records.push_back({r.typeNames[i / 2], static_cast<Operation>(i % 2), records[i]});
+    }
+    std::sort(result.records.begin(), result.records.end(), [](const Snapshot::Record& a, const Snapshot::Record& b) {
+        return a.type != b.type ? a.type < b.type : a.operation < b.operation;
+    });
+    return result;
+}
+
+namespace detail {
+    /// Append `text` as a Prometheus label value, which escapes only backslashes, quotes and newlines.
+    inline void appendLabelValue(std::string& out, std::string_view text) {
+        for (const char c : text) {
+            if (c == '\\' || c == '"') {
+                out += '\\';
+                out += c;
+            } else if (c == '\n') {
+                out += "\\n";
+            } else {
+                out += c;
+            }
+        }
+    }
+
+    /// Append `text` as the contents of a JSON string.
+    inline void appendJsonString(std::string& out, std::string_view text) {
+        for (const char c : text) {
+            if (c == '\\' || c == '"') {
+                out += '\\';
+                out += c;
+            } else if (static_cast<unsigned char>(c) < 0x20) {
+                char escaped[8];
+                snprintf(escaped, sizeof(escaped), "\\u%04x", static_cast<unsigned>(c));
+                out += escaped;
+            } else {
+                out += c;
+            }
+        }
+    }
+} // namespace detail
+
+inline std::string Snapshot::toText() const {
+    std::string out;
+    char line[512];
+    const auto metric = [&](const char* metricName, auto value) {
+        snprintf(line, sizeof(line), "# TYPE %s counter\n", metricName);
+        out += line;
+        for (const auto& record : records) {
+            out += metricName;
+            out += "{type=\"";
+            detail::appendLabelValue(out, record.type);
+            snprintf(line, sizeof(line), "\",operation=\"%s\"} %llu\n", name(record.operation),
+                static_cast<unsigned long long>(value(record.counters)));
+            out += line;
+        }
+    };
+    metric("bebop_record_calls_total", [](const RecordCounters& c) { return c.calls; });
+    metric("bebop_record_bytes_total", [](const RecordCounters& c) { return c.bytes; });
+    metric("bebop_record_nanoseconds_total", [](const RecordCounters& c) { return c.nanoseconds; });
+    metric("bebop_record_allocations_total", [](const RecordCounters& c) { return c.allocations; });
+    for (const bool bytes : {false, true}) {
+        const char* metricName = bytes ? "bebop_primitive_bytes_total" : "bebop_primitive_calls_total";
+        snprintf(line, sizeof(line), "# TYPE %s counter\n", metricName);
+        out += line;
+        for (size_t d = 0; d < 2; d++) {
+            for (size_t p = 0; p < primitiveKinds; p++) {
+                const auto& c = primitives[d][p];
+                if (!c.calls) continue;
+                snprintf(line, sizeof(line), "%s{primitive=\"%s\",direction=\"%s\"} %llu\n", metricName,
+                    name(static_cast<Primitive>(p)), name(static_cast<Direction>(d)),
+                    static_cast<unsigned long long>(bytes ? c.bytes : c.calls));
+                out += line;
+            }
+        }
+    }
+    return out;
+}
+
+inline std::string Snapshot::toJson() const {
+    std::string out = "{\"records\":[";
+    char entry[512];
+    for (size_t i = 0; i < records.size(); i++) {
+        const auto& c = records[i].counters;
+        out += i ? ",{\"type\":\"" : "{\"type\":\"";
+        detail::appendJsonString(out, records[i].type);
+        snprintf(entry, sizeof(entry), "\",\"operation\":\"%s\",\"calls\":%llu,\"bytes\":%llu,\"nanoseconds\":%llu,\"allocations\":%llu}",
+            name(records[i].operation), static_cast<unsigned long long>(c.calls),
+            static_cast<unsigned long long>(c.bytes), static_cast<unsigned long long>(c.nanoseconds),
+            static_cast<unsigned long long>(c.allocations));
+        out += entry;
+    }
+    out += "],\"primitives\":[";
+    bool first = true;
+    for (size_t d = 0; d < 2; d++) {
+        for (size_t p = 0; p < primitiveKinds; p++) {
+            const auto& c = primitives[d][p];
+            if (!c.calls) continue;
+            snprintf(entry, sizeof(entry), "%s{\"primitive\":\"%s\",\"direction\":\"%s\",\"calls\":%llu,\"bytes\":%llu}",
+                first ? "" : ",", name(static_cast<Primitive>(p)), name(static_cast<Direction>(d)),
+                static_cast<unsigned long long>(c.calls), static_cast<unsigned long long>(c.bytes));
+            out += entry;
+            first = false;
+        }
+    }
+    out += "]}";
+    return out;
+}
+
+} // namespace instrumentation
+
+/// Opened at the top of a generated `encodeInto` or `decodeInto`.
+#define BEBOP_INSTRUMENT_RECORD(typeName, operation, io) \
+    static const uint32_t bebopInstrumentedType = ::bebop::instrumentation::typeId(typeName); \
+    ::bebop::instrumentation::RecordScope<std::remove_reference_t<decltype(io)>> bebopRecordScope{ \
+        bebopInstrumentedType, ::bebop::instrumentation::Operation::operation, io}
+#else
+#define BEBOP_INSTRUMENT_RECORD(typeName, operation, io) ((void)0)
+#endif
+#define BEBOP_INSTRUMENT_ENCODE(typeName, writer) BEBOP_INSTRUMENT_RECORD(typeName, Encode, writer)
+#define BEBOP_INSTRUMENT_DECODE(typeName, reader) BEBOP_INSTRUMENT_RECORD(typeName, Decode, reader)
+
+#if BEBOP_INSTRUMENT_PRIMITIVES
+#define BEBOP_INSTRUMENT_PRIMITIVE(direction, primitive, bytes) \
+    ::bebop::instrumentation::countPrimitive(::bebop::instrumentation::Direction::direction, \
+        ::bebop::instrumentation::Primitive::primitive, bytes)
+#else
+#define BEBOP_INSTRUMENT_PRIMITIVE(direction, primitive, bytes) ((void)0)
+#endif
+
+/// Reader policy: bounds-check every read.
+struct CheckedReads {
+    static constexpr bool checked = true;
+};
+
+/// Reader policy: trust the buffer and skip every bounds check. Only use this on a buffer that the
+/// generated `validate` has accepted for the same record type.
+struct UncheckedReads {
+    static constexpr bool checked = false;
+};
+
+/// Reads Bebop primitives from a buffer. Under CheckedReads every read is bounds-checked; when a check
+/// fails, the reader either throws or (in ErrorMode::Status) records the failure, skips to the end of the
+/// buffer and returns zero, so that every later read fails fast too. Either way the failure is handled
+/// out of line.
+template<typename Policy> class BasicReader {
     const uint8_t* m_start;
     const uint8_t* m_pointer;
     const uint8_t* m_end;
+    ErrorMode m_mode;
+    DecodeStatus m_status = DecodeStatus::Ok;
 public:
-    Reader(const uint8_t* buffer, size_t bufferLength) : m_start(buffer), m_pointer(buffer), m_end(buffer + bufferLength) {}
-    Reader(Reader const&) = delete;
-    void operator=(Reader const&) = delete;
+    BasicReader(const uint8_t* buffer, size_t bufferLength, ErrorMode mode = ErrorMode::Throw)
+        : m_start(buffer), m_pointer(buffer), m_end(buffer + bufferLength), m_mode(mode) {}
+    BasicReader(BasicReader const&) = delete;
+    void operator=(BasicReader const&) = delete;
 
     const uint8_t* pointer() const { return m_pointer; }
     size_t bytesRead() const { return m_pointer - m_start; }
-    void seek(const uint8_t* pointer) { m_pointer = pointer; }
+    size_t bytesRemaining() const { return m_end - m_pointer; }
+    void seek(const uint8_t* pointer) {
+        if (BEBOP_UNLIKELY(Policy::checked && (pointer > m_end || failed()))) return fail();
+        m_pointer = pointer;
+    }
 
-    void skip(size_t amount) { m_pointer += amount; }
+    bool failed() const { return m_status != DecodeStatus::Ok; }
+    DecodeStatus status() const { return m_status; }
+    DecodeResult result() const { return DecodeResult{m_status, bytesRead()}; }
+
+    /// Report that the buffer is malformed.
+    BEBOP_COLD void fail() {
+        m_status = DecodeStatus::MalformedPacket;
+        m_pointer = m_end;
+        if (m_mode == ErrorMode::Throw) BEBOP_THROW(MalformedPacketException());
+    }
+
+    void skip(size_t amount) {
+        if (BEBOP_UNLIKELY(Policy::checked && amount > bytesRemaining())) return fail();
+        m_pointer += amount;
+    }
 
     uint8_t readByte() {
-        if (m_pointer + sizeof(uint8_t) > m_end) throw MalformedPacketException();
+        if (BEBOP_UNLIKELY(Policy::checked && m_pointer + sizeof(uint8_t) > m_end)) { fail(); return 0; }
+        BEBOP_INSTRUMENT_PRIMITIVE(Read, Byte, sizeof(uint8_t));
         return *m_pointer++;
     }
 
     uint16_t readUint16() {
-        if (m_pointer + sizeof(uint16_t) > m_end) throw MalformedPacketException();
+        if (BEBOP_UNLIKELY(Policy::checked && m_pointer + sizeof(uint16_t) > m_end)) { fail(); return 0; }
+        BEBOP_INSTRUMENT_PRIMITIVE(Read, Uint16, sizeof(uint16_t));
 #if BEBOP_ASSUME_LITTLE_ENDIAN
         uint16_t v;
         memcpy(&v, m_pointer, sizeof(uint16_t));
@@ -232,7 +953,8 @@ public:
     }
 
     uint32_t readUint32() {
-        if (m_pointer + sizeof(uint32_t) > m_end) throw MalformedPacketException();
+        if (BEBOP_UNLIKELY(Policy::checked && m_pointer + sizeof(uint32_t) > m_end)) { fail(); return 0; }
+        BEBOP_INSTRUMENT_PRIMITIVE(Read, Uint32, sizeof(uint32_t));
 #if BEBOP_ASSUME_LITTLE_ENDIAN
         uint32_t v;
         memcpy(&v, m_pointer, sizeof(uint32_t));
@@ -248,7 +970,8 @@ public:
     }
 
     uint64_t readUint64() {
-        if (m_pointer + sizeof(uint64_t) > m_end) throw MalformedPacketException();
+        if (BEBOP_UNLIKELY(Policy::checked && m_pointer + sizeof(uint64_t) > m_end)) { fail(); return 0; }
+        BEBOP_INSTRUMENT_PRIMITIVE(Read, Uint64, sizeof(uint64_t));
 #if BEBOP_ASSUME_LITTLE_ENDIAN
         uint64_t v;
         memcpy(&v, m_pointer, sizeof(uint64_t));
@@ -272,7 +995,6 @@ public:
     int64_t readInt64() { return static_cast<uint64_t>(readUint64()); }
 
     float readFloat32() {
-        if (m_pointer + sizeof(float) > m_end) throw MalformedPacketException();
         float f;
         const uint32_t v = readUint32();
         memcpy(&f, &v, sizeof(float));
@@ -280,7 +1002,6 @@ public:
     }
 
     double readFloat64() {
-        if (m_pointer + sizeof(double) > m_end) throw MalformedPacketException();
         double f;
         const uint64_t v = readUint64();
         memcpy(&f, &v, sizeof(double));
@@ -293,14 +1014,21 @@ public:
 
     uint32_t readLengthPrefix() {
         const auto length = readUint32();
-        if (m_pointer + length > m_end) {
-            throw MalformedPacketException();
-        }
+        if (BEBOP_UNLIKELY(Policy::checked && length > bytesRemaining())) { fail(); return 0; }
+        return length;
+    }
+
+    /// Read the length prefix of an array or map whose elements each take at least `minimalElementSize` bytes,
+    /// failing if the rest of the buffer could not possibly hold that many.
+    uint32_t readArrayLength(size_t minimalElementSize) {
+        const auto length = readUint32();
+        if (BEBOP_UNLIKELY(Policy::checked && minimalElementSize != 0 && length > bytesRemaining() / minimalElementSize)) { fail(); return 0; }
         return length;
     }
 
     std::vector<uint8_t> readBytes() {
         const auto length = readLengthPrefix();
+        BEBOP_INSTRUMENT_PRIMITIVE(Read, Bytes, length);
         std::vector<uint8_t> v(m_pointer, m_pointer + length);
         m_pointer += length;
         return v;
@@ -308,13 +1036,24 @@ public:
 
     std::string readString() {
         const auto length = readLengthPrefix();
+        BEBOP_INSTRUMENT_PRIMITIVE(Read, String, length);
         std::string v(m_pointer, m_pointer + length);
         m_pointer += length;
         return v;
     }
 
+    /// Read a string without copying it: the view points into the source buffer.
+    std::string_view readStringView() {
+        const auto length = readLengthPrefix();
+        BEBOP_INSTRUMENT_PRIMITIVE(Read, String, length);
+        std::string_view v(reinterpret_cast<const char*>(m_pointer), length);
+        m_pointer += length;
+        return v;
+    }
+
     Guid readGuid() {
-        if (m_pointer + sizeof(Guid) > m_end) throw MalformedPacketException();
+        if (BEBOP_UNLIKELY(Policy::checked && m_pointer + sizeof(Guid) > m_end)) { fail(); return Guid(); }
+        BEBOP_INSTRUMENT_PRIMITIVE(Read, Guid, sizeof(Guid));
         Guid guid { m_pointer };
         m_pointer += sizeof(Guid);
         return guid;
@@ -322,156 +1061,2503 @@ public:
 
     // Read a date (as ticks since the Unix Epoch).
     TickDuration readDate() {
-        const uint64_t ticks = readUint64() & 0x3fffffffffffffff;
-        return TickDuration(ticks - ticksBetweenEpochs);
+        return ticksToDate(readUint64());
     }
-};
-
-class Writer {
-    std::vector<uint8_t>& m_buffer;
-public:
-    Writer(std::vector<uint8_t>& buffer) : m_buffer(buffer) {}
-    Writer(Writer const&) = delete;
-    void operator=(Writer const&) = delete;
 
-    std::vector<uint8_t>& buffer() {
-        return m_buffer;
+    /// Copy `length` raw bytes out of the buffer.
+    void readRaw(uint8_t* target, size_t length) {
+        if (BEBOP_UNLIKELY(Policy::checked && length > bytesRemaining())) {
+            fail();
+            memset(target, 0, length);
+            return;
+        }
+        BEBOP_INSTRUMENT_PRIMITIVE(Read, Raw, length);
+        memcpy(target, m_pointer, length);
+        m_pointer += length;
     }
 
-    size_t length() { return m_buffer.size(); }
-
-    void writeByte(uint8_t value) { m_buffer.push_back(value); }
-    void writeUint16(uint16_t value) {
+    /// Read an array of a fixed-size struct `T` that has a generated `T::Packed` wire layout.
+    /// On little-endian hosts this is a single bounds check plus one bulk copy (or one copy per element
+    /// when `T` is not itself laid out like its encoding).
+    template<typename T, typename A> void readPackedArray(std::vector<T, A>& values) {
+        const size_t length = readUint32();
+        constexpr size_t size = sizeof(typename T::Packed);
+        if (BEBOP_UNLIKELY(Policy::checked && length > bytesRemaining() / size)) return fail();
+        values.resize(length);
 #if BEBOP_ASSUME_LITTLE_ENDIAN
-        const auto position = m_buffer.size();
-        m_buffer.resize(position + sizeof(value));
-        memcpy(m_buffer.data() + position, &value, sizeof(value));
+        BEBOP_INSTRUMENT_PRIMITIVE(Read, Array, length * size);
+        if constexpr (T::hasWireLayout()) {
+            if (length) memcpy(values.data(), m_pointer, length * size);
+        } else {
+            for (size_t i = 0; i < length; i++) {
+                typename T::Packed packed;
+                memcpy(&packed, m_pointer + i * size, size);
+                T::unpack(packed, values[i]);
+            }
+        }
+        m_pointer += length * size;
 #else
-        m_buffer.push_back(value);
-        m_buffer.push_back(value >> 8);
+        for (auto& value : values) T::decodeInto(*this, value);
 #endif
     }
-    void writeUint32(uint32_t value) {
-#if BEBOP_ASSUME_LITTLE_ENDIAN
-        const auto position = m_buffer.size();
-        m_buffer.resize(position + sizeof(value));
-        memcpy(m_buffer.data() + position, &value, sizeof(value));
-#else
-        m_buffer.push_back(value);
-        m_buffer.push_back(value >> 8);
-        m_buffer.push_back(value >> 16);
-        m_buffer.push_back(value >> 24);
-#endif
+
+    /// Read a single fixed-size scalar or enum of type `T`.
+    template<typename T> T readScalar() {
+        if constexpr (std::is_enum<T>::value) return static_cast<T>(readScalar<typename std::underlying_type<T>::type>());
+        else if constexpr (std::is_same<T, bool>::value) return readBool();
+        else if constexpr (std::is_same<T, uint8_t>::value) return readByte();
+        else if constexpr (std::is_same<T, uint16_t>::value) return readUint16();
+        else if constexpr (std::is_same<T, int16_t>::value) return readInt16();
+        else if constexpr (std::is_same<T, uint32_t>::value) return readUint32();
+        else if constexpr (std::is_same<T, int32_t>::value) return readInt32();
+        else if constexpr (std::is_same<T, uint64_t>::value) return readUint64();
+        else if constexpr (std::is_same<T, int64_t>::value) return readInt64();
+        else if constexpr (std::is_same<T, float>::value) return readFloat32();
+        else if constexpr (std::is_same<T, double>::value) return readFloat64();
+        else if constexpr (std::is_same<T, Guid>::value) return readGuid();
+        else if constexpr (std::is_same<T, TickDuration>::value) return readDate();
+        else static_assert(sizeof(T) == 0, "not a Bebop scalar type");
     }
-    void writeUint64(uint64_t value) {
+
+    /// Read an array of a fixed-size scalar or enum `T`. The length is checked against the rest of the
+    /// buffer once, and on little-endian hosts the elements are copied in bulk.
+    template<typename T, typename A> void readScalarArray(std::vector<T, A>& values) {
+        const size_t length = readUint32();
+        if (BEBOP_UNLIKELY(Policy::checked && length > bytesRemaining() / sizeof(T))) return fail();
+        values.resize(length);
 #if BEBOP_ASSUME_LITTLE_ENDIAN
-        const auto position = m_buffer.size();
-        m_buffer.resize(position + sizeof(value));
-        memcpy(m_buffer.data() + position, &value, sizeof(value));
-#else
-        m_buffer.push_back(value);
-        m_buffer.push_back(value >> 0x08);
-        m_buffer.push_back(value >> 0x10);
-        m_buffer.push_back(value >> 0x18);
-        m_buffer.push_back(value >> 0x20);
-        m_buffer.push_back(value >> 0x28);
-        m_buffer.push_back(value >> 0x30);
-        m_buffer.push_back(value >> 0x38);
+        if constexpr (!std::is_same<T, TickDuration>::value) {
+            BEBOP_INSTRUMENT_PRIMITIVE(Read, Array, length * sizeof(T));
+            if (length) memcpy(values.data(), m_pointer, length * sizeof(T));
+            m_pointer += length * sizeof(T);
+            return;
+        }
 #endif
+        for (auto& value : values) value = readScalar<T>();
     }
 
-    void writeInt16(int16_t value) { writeUint16(static_cast<uint16_t>(value)); }
-    void writeInt32(int32_t value) { writeUint32(static_cast<uint32_t>(value)); }
-    void writeInt64(int64_t value) { writeUint64(static_cast<uint64_t>(value)); }
-    void writeFloat32(float value) {
-        uint32_t temp;
-        memcpy(&temp, &value, sizeof(float));
-        writeUint32(temp);
-    }
-    void writeFloat64(double value) {
-        uint64_t temp;
-        memcpy(&temp, &value, sizeof(double));
-        writeUint64(temp);
+    template<typename A> void readScalarArray(std::vector<bool, A>& values) {
+        const size_t length = readUint32();
+        if (BEBOP_UNLIKELY(Policy::checked && length > bytesRemaining())) return fail();
+        values.resize(length);
+        BEBOP_INSTRUMENT_PRIMITIVE(Read, Array, length);
+        for (size_t i = 0; i < length; i++) values[i] = m_pointer[i] != 0;
+        m_pointer += length;
     }
-    void writeBool(bool value) { writeByte(value); }
+};
 
-    void writeBytes(std::vector<uint8_t> value) {
-        const auto byteCount = value.size();
-        writeUint32(byteCount);
-        m_buffer.insert(m_buffer.end(), value.begin(), value.end());
-    }
+using Reader = BasicReader<CheckedReads>;
+using UncheckedReader = BasicReader<UncheckedReads>;
 
-    void writeString(std::string value) {
-        const auto byteCount = value.size();
-        writeUint32(byteCount);
-        m_buffer.insert(m_buffer.end(), value.begin(), value.end());
-    }
+// Incremental decoding
+//
+// An IncrementalDecoder decodes one message or union from bytes that arrive in
+// arbitrary chunks, such as non-blocking socket reads, without waiting for the
+// whole record. It is an explicit state machine over the wire format:
+//
+//     Length  the 4-byte length prefix, which bounds everything after it
+//     Tag     (messages) a field tag; 0 ends the message
+//     Field   (messages) one field value, decoded by the generated `decodeFieldInto`
+//     Union   (unions) the whole record, decoded by the generated `decodeInto`
+//     Skip    (messages) the rest of the body after the terminator or an unknown tag
+//
+// A step whose bytes all lie within one chunk decodes straight from it. When a
+// step runs off the end of a chunk, its bytes are staged and the step is retried
+// once the staging buffer has doubled (or reached the end of the record), so a
+// field split across many small reads is still decoded in linear time. Only one
+// top-level message field, or one union, is ever staged at a time.
 
-    void writeGuid(Guid value) {
-        writeUint32(value.m_a);
-        writeUint16(value.m_b);
-        writeUint16(value.m_c);
-        writeByte(value.m_d);
-        writeByte(value.m_e);
-        writeByte(value.m_f);
-        writeByte(value.m_g);
-        writeByte(value.m_h);
-        writeByte(value.m_i);
-        writeByte(value.m_j);
-        writeByte(value.m_k);
-    }
+/// Which wire shape a generated record has.
+enum class RecordKind {
+    /// Fields in order, with no length prefix.
+    Struct,
+    /// A length prefix, then tagged fields up to a 0 terminator.
+    Message,
+    /// A length prefix, a discriminator, then one branch.
+    Union,
+};
 
-    void writeDate(TickDuration duration) {
-        writeUint64((duration.count() + ticksBetweenEpochs) & 0x3fffffffffffffff);
-    }
+enum class FeedStatus {
+    /// Every byte so far has been consumed; feed the next chunk.
+    NeedMore,
+    /// The record is complete. Bytes after it were not consumed.
+    Done,
+    /// The record is malformed.
+    MalformedPacket,
+};
 
-    /// Reserve some space to write a message's length prefix, and return its index.
-    /// The length is stored as a little-endian fixed-width unsigned 32-bit integer, so 4 bytes are reserved.
-    size_t reserveMessageLength() {
-        const auto n = m_buffer.size();
-        m_buffer.resize(n + 4);
-        return n;
-    }
+/// The outcome of `IncrementalDecoder::feed`.
+struct FeedResult {
+    FeedStatus status;
+    /// How many bytes of the chunk belong to the record.
+    size_t bytesConsumed;
 
-    /// Fill in a message's length prefix.
-    void fillMessageLength(size_t position, uint32_t messageLength) {
-#if BEBOP_ASSUME_LITTLE_ENDIAN
-        memcpy(m_buffer.data() + position, &messageLength, sizeof(uint32_t));
-#else
-        m_buffer[position++] = messageLength;
-        m_buffer[position++] = messageLength >> 8;
-        m_buffer[position++] = messageLength >> 16;
-        m_buffer[position++] = messageLength >> 24;
-#endif
-    }
+    bool done() const { return status == FeedStatus::Done; }
 };
 
-class ByteCounter {
-    size_t m_bytes;
-public:
-    ByteCounter() : m_bytes(0) {}
-    ByteCounter(ByteCounter const&) = delete;
-    void operator=(ByteCounter const&) = delete;
+/// Decodes a generated message or union `T` from a sequence of byte chunks. Fields are decoded into
+/// `target` as `decodeInto` would; call `reset` to decode the next record of a stream.
+template<typename T> class IncrementalDecoder {
+    static_assert(T::recordKind != RecordKind::Struct, "structs carry no length prefix: decode them as a field of a message or union");
+
+    enum class State { Length, Tag, Field, Union, Skip, Done, Failed };
+
+    T* m_target;
+    size_t m_maxLength;
+#if BEBOP_HAS_MEMORY_RESOURCE
+    std::pmr::memory_resource* m_resource = std::pmr::get_default_resource();
+#endif
+    State m_state = State::Length;
+    uint8_t m_tag = 0;
+    /// Bytes of the record not yet consumed, once the length prefix is known.
+    size_t m_remaining = 0;
+    /// The bytes of an unfinished step, and how many must be staged before it is retried.
+    std::vector<uint8_t> m_staged;
+    size_t m_retryAt = 0;
+    std::vector<uint8_t> m_leftover;
+
+public:
+    /// Decode into `target`, rejecting any record whose length prefix exceeds `maxLength`.
+    explicit IncrementalDecoder(T& target, size_t maxLength = SIZE_MAX) : m_target(&target), m_maxLength(maxLength) {}
+#if BEBOP_HAS_MEMORY_RESOURCE
+    /// Decode into a `usePmr` record, allocating its contents from `resource`.
+    IncrementalDecoder(T& target, std::pmr::memory_resource* resource, size_t maxLength = SIZE_MAX)
+        : m_target(&target), m_maxLength(maxLength), m_resource(resource) {}
+#endif
+    IncrementalDecoder(IncrementalDecoder const&) = delete;
+    void operator=(IncrementalDecoder const&) = delete;
+
+    /// Consume the next chunk of the stream.
+    FeedResult feed(const uint8_t* data, size_t size) {
+        size_t offset = 0;
+        while (!finished() && !m_staged.empty() && offset < size) {
+            offset += feedStaged(data + offset, size - offset);
+        }
+        if (!finished() && m_staged.empty()) {
+            offset += feedDirect(data + offset, size - offset);
+        }
+        return FeedResult{status(), offset};
+    }
+
+    FeedResult feed(const std::vector<uint8_t>& chunk) { return feed(chunk.data(), chunk.size()); }
+
+    FeedStatus status() const {
+        switch (m_state) {
+            case State::Done: return FeedStatus::Done;
+            case State::Failed: return FeedStatus::MalformedPacket;
+            default: return FeedStatus::NeedMore;
+        }
+    }
+
+    /// How many bytes are held back for a step that ran off the end of a chunk.
+    size_t bytesStaged() const { return m_staged.size(); }
+
+    /// Start over on the next record, keeping the staging buffer's capacity.
+    void reset() {
+        m_state = State::Length;
+        m_remaining = 0;
+        m_staged.clear();
+        m_retryAt = 0;
+    }
+
+    void reset(T& target) {
+        m_target = &target;
+        reset();
+    }
+
+private:
+    bool finished() const { return m_state == State::Done || m_state == State::Failed; }
+
+    /// The most bytes the current step can span.
+    size_t stepLimit() const { return m_state == State::Length ? sizeof(uint32_t) : m_remaining; }
+
+    /// Try the current step on the bytes available. Returns false if they are too few.
+    bool step(const uint8_t* data, size_t size, size_t& used) {
+        Reader reader{data, size, ErrorMode::Status};
+        used = 0;
+        switch (m_state) {
+            case State::Length: {
+                const size_t length = reader.readUint32();
+                if (reader.failed()) return false;
+                if (length > m_maxLength) {
+                    m_state = State::Failed;
+                } else if (T::recordKind == RecordKind::Union) {
+                    // The generated union decoder reads the prefix itself, so leave it in place.
+                    m_remaining = sizeof(uint32_t) + 1 + length;
+                    m_state = State::Union;
+                } else {
+                    used = sizeof(uint32_t);
+                    m_remaining = length;
+                    m_state = State::Tag;
+                }
+                return true;
+            }
+            case State::Tag:
+                m_tag = reader.readByte();
+                if (reader.failed()) return false;
+                used = 1;
+                m_remaining -= used;
+                m_state = m_tag == 0 ? State::Skip : State::Field;
+                return true;
+            case State::Field:
+                if (!decodeField(reader)) {
+                    m_state = State::Skip;
+                    return true;
+                }
+                if (reader.failed()) return false;
+                used = reader.bytesRead();
+                m_remaining -= used;
+                m_state = State::Tag;
+                return true;
+            case State::Union:
+                decodeRecord(reader);
+                if (reader.failed()) return false;
+                used = m_remaining;
+                m_remaining = 0;
+                m_state = State::Done;
+                return true;
+            default:
+                return true;
+        }
+    }
+
+    template<typename R> bool decodeField(R& reader) {
+        if constexpr (T::recordKind == RecordKind::Message) {
+#if BEBOP_HAS_MEMORY_RESOURCE
+            if constexpr (std::is_constructible<T, std::pmr::memory_resource*>::value) {
+                return T::decodeFieldInto(reader, m_tag, *m_target, m_resource);
+            }
+#endif
+            return T::decodeFieldInto(reader, m_tag, *m_target);
+        }
+        return false;
+    }
+
+    template<typename R> void decodeRecord(R& reader) {
+#if BEBOP_HAS_MEMORY_RESOURCE
+        if constexpr (std::is_constructible<T, std::pmr::memory_resource*>::value) {
+            T::decodeInto(reader, *m_target, m_resource);
+            return;
+        }
+#endif
+        T::decodeInto(reader, *m_target);
+    }
+
+    /// Retry a failed step once the staged bytes double, but never wait past the end of the record.
+    static size_t nextRetry(size_t staged, size_t limit) {
+        return std::min(limit, std::max<size_t>(2 * staged, 64));
+    }
+
+    /// Run steps straight out of `data`, staging the start of a step that runs off its end.
+    size_t feedDirect(const uint8_t* data, size_t size) {
+        size_t offset = 0;
+        while (!finished()) {
+            if (m_state == State::Skip) {
+                const size_t skipped = std::min(size - offset, m_remaining);
+                offset += skipped;
+                m_remaining -= skipped;
+                if (m_remaining == 0) m_state = State::Done;
+                break;
+            }
+            const size_t limit = stepLimit();
+            const size_t available = std::min(size - offset, limit);
+            if (available == 0 && limit != 0) break;
+            size_t used;
+            if (step(data + offset, available, used)) {
+                offset += used;
+                continue;
+            }
+            if (available == limit) {
+                m_state = State::Failed;
+                break;
+            }
+            m_staged.assign(data + offset, data + offset + available);
+            m_retryAt = nextRetry(available, limit);
+            offset += available;
+            break;
+        }
+        return offset;
+    }
+
+    /// Add to the staged step until it is due for a retry. Once it succeeds, whatever was staged after it
+    /// is run through the state machine as if it had just arrived.
+    size_t feedStaged(const uint8_t* data, size_t size) {
+        const size_t taken = std::min(size, m_retryAt - m_staged.size());
+        m_staged.insert(m_staged.end(), data, data + taken);
+        if (m_staged.size() < m_retryAt) return taken;
+
+        const size_t limit = stepLimit();
+        size_t used;
+        if (!step(m_staged.data(), m_staged.size(), used)) {
+            if (m_staged.size() == limit) {
+                m_state = State::Failed;
+            } else {
+                m_retryAt = nextRetry(m_staged.size(), limit);
+            }
+            return taken;
+        }
+        m_leftover.assign(m_staged.begin() + used, m_staged.end());
+        m_staged.clear();
+        feedDirect(m_leftover.data(), m_leftover.size());
+        return taken;
+    }
+};
+
+// Views
+//
+// A view is a non-owning, read-only window onto a record encoded in a Bebop
+// buffer. Views never allocate: strings are exposed as std::string_view, and
+// the elements of arrays and maps and the records nested in fields are decoded
+// lazily as they are accessed. Decoding a view only skips over its arrays, maps
+// and nested records; a message or union is skipped by its length prefix
+// without looking inside, so a malformed one is only reported when it is
+// accessed.
+// The source buffer must outlive every view created from it.
+//
+// Every view-able type is described by a "codec" with this shape:
+//
+//     using value_type = ...;                   // what decode() returns
+//     using owned_type = ...;                   // the matching owning type
+//     static constexpr size_t fixedSize = ...;  // wire size, or 0 if variable
+//     static value_type decode(Reader& reader);
+//     static void skip(Reader& reader);         // advance past one value without decoding it
+//     static owned_type own(const value_type& value);
+//
+// ArrayView, MapView, LazyView and generated `FooView` records are their own codecs.
+
+template<typename T> struct ScalarCodec;
+
+#define BEBOP_SCALAR_CODEC(TYPE, WIRE_SIZE, READ) \
+    template<> struct ScalarCodec<TYPE> { \
+        using value_type = TYPE; \
+        using owned_type = TYPE; \
+        static constexpr size_t fixedSize = WIRE_SIZE; \
+        static value_type decode(Reader& reader) { return reader.READ(); } \
+        static void skip(Reader& reader) { reader.skip(WIRE_SIZE); } \
+        static owned_type own(const value_type& value) { return value; } \
+    };
+
+BEBOP_SCALAR_CODEC(bool, 1, readBool)
+BEBOP_SCALAR_CODEC(uint8_t, 1, readByte)
+BEBOP_SCALAR_CODEC(uint16_t, 2, readUint16)
+BEBOP_SCALAR_CODEC(int16_t, 2, readInt16)
+BEBOP_SCALAR_CODEC(uint32_t, 4, readUint32)
+BEBOP_SCALAR_CODEC(int32_t, 4, readInt32)
+BEBOP_SCALAR_CODEC(uint64_t, 8, readUint64)
+BEBOP_SCALAR_CODEC(int64_t, 8, readInt64)
+BEBOP_SCALAR_CODEC(float, 4, readFloat32)
+BEBOP_SCALAR_CODEC(double, 8, readFloat64)
+BEBOP_SCALAR_CODEC(Guid, 16, readGuid)
+BEBOP_SCALAR_CODEC(TickDuration, 8, readDate)
+
+#undef BEBOP_SCALAR_CODEC
+
+template<typename E> struct EnumCodec {
+    using underlying_codec = ScalarCodec<std::underlying_type_t<E>>;
+    using value_type = E;
+    using owned_type = E;
+    static constexpr size_t fixedSize = underlying_codec::fixedSize;
+    static value_type decode(Reader& reader) { return static_cast<E>(underlying_codec::decode(reader)); }
+    static void skip(Reader& reader) { underlying_codec::skip(reader); }
+    static owned_type own(const value_type& value) { return value; }
+};
+
+struct StringViewCodec {
+    using value_type = std::string_view;
+    using owned_type = std::string;
+    static constexpr size_t fixedSize = 0;
+    static value_type decode(Reader& reader) { return reader.readStringView(); }
+    static void skip(Reader& reader) { reader.skip(reader.readLengthPrefix()); }
+    static owned_type own(const value_type& value) { return std::string(value); }
+};
+
+/// A lazily decoded view of a Bebop array whose elements are described by codec `C`.
+template<typename C> class ArrayView {
+    const uint8_t* m_begin = nullptr;
+    const uint8_t* m_end = nullptr;
+    size_t m_size = 0;
+public:
+    using element_type = typename C::value_type;
+    using value_type = ArrayView;
+    using owned_type = std::vector<typename C::owned_type>;
+    static constexpr size_t fixedSize = 0;
+
+    class const_iterator {
+        const uint8_t* m_next;
+        const uint8_t* m_end;
+        size_t m_remaining;
+        element_type m_value{};
+        void load() {
+            if (m_remaining == 0) return;
+            Reader reader{m_next, static_cast<size_t>(m_end - m_next)};
+            m_value = C::decode(reader);
+            m_next = reader.pointer();
+        }
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = element_type;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const element_type*;
+        using reference = const element_type&;
+
+        const_iterator(const uint8_t* next, const uint8_t* end, size_t remaining)
+            : m_next(next), m_end(end), m_remaining(remaining) { load(); }
+        reference operator*() const { return m_value; }
+        pointer operator->() const { return &m_value; }
+        const_iterator& operator++() { --m_remaining; load(); return *this; }
+        const_iterator operator++(int) { auto old = *this; ++*this; return old; }
+        bool operator==(const const_iterator& other) const { return m_remaining == other.m_remaining; }
+        bool operator!=(const const_iterator& other) const { return m_remaining != other.m_remaining; }
+    };
+
+    ArrayView() = default;
+    ArrayView(const uint8_t* begin, const uint8_t* end, size_t size) : m_begin(begin), m_end(end), m_size(size) {}
+
+    size_t size() const { return m_size; }
+    bool empty() const { return m_size == 0; }
+    /// The encoded elements, excluding the length prefix.
+    const uint8_t* bytes() const { return m_begin; }
+    size_t byteLength() const { return m_end - m_begin; }
+
+    const_iterator begin() const { return const_iterator(m_begin, m_end, m_size); }
+    const_iterator end() const { return const_iterator(m_end, m_end, 0); }
+
+    /// Random access, only available when elements have a fixed wire size.
+    element_type operator[](size_t index) const {
+        static_assert(C::fixedSize != 0, "random access requires fixed-size elements");
+        Reader reader{m_begin + index * C::fixedSize, C::fixedSize};
+        return C::decode(reader);
+    }
+
+    element_type at(size_t index) const {
+        if (index >= m_size) BEBOP_THROW(std::out_of_range("bebop::ArrayView::at"));
+        return (*this)[index];
+    }
+
+    owned_type toOwned() const {
+        owned_type result;
+        result.reserve(m_size);
+        for (const auto& element : *this) result.push_back(C::own(element));
+        return result;
+    }
+
+    static ArrayView decode(Reader& reader) {
+        const size_t length = reader.readUint32();
+        const uint8_t* begin = reader.pointer();
+        if constexpr (C::fixedSize != 0) {
+            if (BEBOP_UNLIKELY(length > reader.bytesRemaining() / C::fixedSize)) {
+                reader.fail();
+                return ArrayView();
+            }
+            reader.skip(length * C::fixedSize);
+        } else {
+            for (size_t i = 0; i < length && !reader.failed(); i++) C::skip(reader);
+        }
+        if (reader.failed()) return ArrayView();
+        return ArrayView(begin, reader.pointer(), length);
+    }
+
+    static void skip(Reader& reader) { decode(reader); }
+
+    static owned_type own(const ArrayView& value) { return value.toOwned(); }
+};
+
+using BytesView = ArrayView<ScalarCodec<uint8_t>>;
+
+/// A lazily decoded view of a Bebop map whose keys and values are described by codecs `K` and `V`.
+// `Map` is the owned container toOwned() builds: std::map by default, or any
+// map template with insert_or_assign, such as FlatMap or std::unordered_map.
+// As in owning decode, the last of several entries with the same key wins.
+template<typename K, typename V, template<typename...> class Map = std::map> class MapView {
+    const uint8_t* m_begin = nullptr;
+    const uint8_t* m_end = nullptr;
+    size_t m_size = 0;
+public:
+    using element_type = std::pair<typename K::value_type, typename V::value_type>;
+    using value_type = MapView;
+    using owned_type = Map<typename K::owned_type, typename V::owned_type>;
+    static constexpr size_t fixedSize = 0;
+
+    class const_iterator {
+        const uint8_t* m_next;
+        const uint8_t* m_end;
+        size_t m_remaining;
+        element_type m_value{};
+        void load() {
+            if (m_remaining == 0) return;
+            Reader reader{m_next, static_cast<size_t>(m_end - m_next)};
+            m_value.first = K::decode(reader);
+            m_value.second = V::decode(reader);
+            m_next = reader.pointer();
+        }
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = element_type;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const element_type*;
+        using reference = const element_type&;
+
+        const_iterator(const uint8_t* next, const uint8_t* end, size_t remaining)
+            : m_next(next), m_end(end), m_remaining(remaining) { load(); }
+        reference operator*() const { return m_value; }
+        pointer operator->() const { return &m_value; }
+        const_iterator& operator++() { --m_remaining; load(); return *this; }
+        const_iterator operator++(int) { auto old = *this; ++*this; return old; }
+        bool operator==(const const_iterator& other) const { return m_remaining == other.m_remaining; }
+        bool operator!=(const const_iterator& other) const { return m_remaining != other.m_remaining; }
+    };
+
+    MapView() = default;
+    MapView(const uint8_t* begin, const uint8_t* end, size_t size) : m_begin(begin), m_end(end), m_size(size) {}
+
+    size_t size() const { return m_size; }
+    bool empty() const { return m_size == 0; }
+
+    const_iterator begin() const { return const_iterator(m_begin, m_end, m_size); }
+    const_iterator end() const { return const_iterator(m_end, m_end, 0); }
+
+    owned_type toOwned() const {
+        owned_type result;
+        for (const auto& entry : *this) result.insert_or_assign(K::own(entry.first), V::own(entry.second));
+        return result;
+    }
+
+    static MapView decode(Reader& reader) {
+        const size_t length = reader.readUint32();
+        const uint8_t* begin = reader.pointer();
+        for (size_t i = 0; i < length && !reader.failed(); i++) {
+            K::skip(reader);
+            V::skip(reader);
+        }
+        if (reader.failed()) return MapView();
+        return MapView(begin, reader.pointer(), length);
+    }
+
+    static void skip(Reader& reader) { decode(reader); }
+
+    static owned_type own(const MapView& value) { return value.toOwned(); }
+};
+
+/// A lazily decoded view of a nested record described by codec `C`, such as a generated `FooView`.
+// Decoding it only skips over the record; get() decodes it from the bytes it
+// was skipped over each time it is called.
+template<typename C> class LazyView {
+    const uint8_t* m_begin = nullptr;
+    const uint8_t* m_end = nullptr;
+public:
+    using element_type = typename C::value_type;
+    using value_type = LazyView;
+    using owned_type = typename C::owned_type;
+    static constexpr size_t fixedSize = C::fixedSize;
+
+    LazyView() = default;
+    LazyView(const uint8_t* begin, const uint8_t* end) : m_begin(begin), m_end(end) {}
+
+    /// The encoded record, including its length prefix if it has one.
+    const uint8_t* bytes() const { return m_begin; }
+    size_t byteLength() const { return m_end - m_begin; }
+
+    element_type get() const {
+        Reader reader{m_begin, byteLength()};
+        return C::decode(reader);
+    }
+
+    owned_type toOwned() const { return C::own(get()); }
+
+    static LazyView decode(Reader& reader) {
+        const uint8_t* begin = reader.pointer();
+        C::skip(reader);
+        if (reader.failed()) return LazyView();
+        return LazyView(begin, reader.pointer());
+    }
+
+    static void skip(Reader& reader) { C::skip(reader); }
+
+    static owned_type own(const LazyView& value) { return value.toOwned(); }
+};
+
+// Sinks
+//
+// A sink is the byte destination behind a BasicWriter. Any type with these
+// members is a sink; conformance is checked at compile time with `isSink`:
+//
+//     size_t size() const;            // the number of bytes written so far
+//     uint8_t* extend(size_t count);  // append `count` bytes, return a pointer to them
+//     uint8_t* at(size_t position);   // a pointer to a byte already written
+//
+// The bytes returned by extend() may be uninitialized: the writer always
+// overwrites them. Growing a sink may invalidate earlier pointers, so the
+// writer only holds on to positions. Sinks are held by value, so they should
+// be cheap handles onto storage that lives elsewhere.
+
+template<typename S, typename = void> struct IsSink : std::false_type {};
+template<typename S> struct IsSink<S, std::void_t<
+    decltype(static_cast<size_t>(std::declval<const S&>().size())),
+    decltype(static_cast<uint8_t*>(std::declval<S&>().extend(size_t{}))),
+    decltype(static_cast<uint8_t*>(std::declval<S&>().at(size_t{})))>> : std::true_type {};
+
+template<typename S> constexpr bool isSink = IsSink<S>::value;
+
+/// Sinks may optionally provide `void reserve(size_t additional)` to pre-size their storage.
+template<typename S, typename = void> struct HasReserve : std::false_type {};
+template<typename S> struct HasReserve<S, std::void_t<decltype(std::declval<S&>().reserve(size_t{}))>> : std::true_type {};
+
+struct BufferOverflowException : public std::exception {
+    const char* what () const throw () {
+        return "Bebop output buffer is full";
+    }
+};
+
+/// A growable byte buffer for writers to encode into. Unlike std::vector<uint8_t>,
+/// growing it leaves the new bytes uninitialized, since a writer overwrites them
+/// anyway. Its storage comes from malloc, so it can be handed off with `release`.
+class ByteBuffer {
+    uint8_t* m_data = nullptr;
+    size_t m_size = 0;
+    size_t m_capacity = 0;
+
+    BEBOP_COLD void grow(size_t needed) {
+        const size_t capacity = std::max({needed, 2 * m_capacity, size_t{64}});
+        auto* data = static_cast<uint8_t*>(std::realloc(m_data, capacity));
+        if (!data) BEBOP_THROW(std::bad_alloc());
+        m_data = data;
+        m_capacity = capacity;
+    }
+public:
+    using value_type = uint8_t;
+
+    ByteBuffer() = default;
+    explicit ByteBuffer(size_t capacity) { reserve(capacity); }
+    ByteBuffer(ByteBuffer&& other) noexcept
+        : m_data(std::exchange(other.m_data, nullptr)), m_size(std::exchange(other.m_size, 0)), m_capacity(std::exchange(other.m_capacity, 0)) {}
+    ByteBuffer& operator=(ByteBuffer&& other) noexcept {
+        std::swap(m_data, other.m_data);
+        std::swap(m_size, other.m_size);
+        std::swap(m_capacity, other.m_capacity);
+        return *this;
+    }
+    ByteBuffer(ByteBuffer const&) = delete;
+    void operator=(ByteBuffer const&) = delete;
+    ~ByteBuffer() { std::free(m_data); }
+
+    uint8_t* data() { return m_data; }
+    const uint8_t* data() const { return m_data; }
+    size_t size() const { return m_size; }
+    size_t capacity() const { return m_capacity; }
+    bool empty() const { return m_size == 0; }
+    const uint8_t* begin() const { return m_data; }
+    const uint8_t* end() const { return m_data + m_size; }
+
+    /// Empty the buffer, keeping its storage.
+    void clear() { m_size = 0; }
+    /// Make room for at least `capacity` bytes in all.
+    void reserve(size_t capacity) {
+        if (capacity > m_capacity) grow(capacity);
+    }
+    /// Set the size to `size` bytes. Bytes past the old size are uninitialized.
+    void resize(size_t size) {
+        if (size > m_capacity) grow(size);
+        m_size = size;
+    }
+    /// Append `count` uninitialized bytes, and return a pointer to them.
+    uint8_t* extend(size_t count) {
+        if (count > m_capacity - m_size) grow(m_size + count);
+        uint8_t* p = m_data + m_size;
+        m_size += count;
+        return p;
+    }
+
+    /// Copy the bytes into a std::vector.
+    std::vector<uint8_t> toVector() const { return std::vector<uint8_t>(begin(), end()); }
+
+    /// Give up the storage, leaving the buffer empty. Returns the bytes and
+    /// their count; the caller frees the bytes with std::free.
+    std::pair<uint8_t*, size_t> release() {
+        const std::pair<uint8_t*, size_t> bytes{m_data, m_size};
+        m_data = nullptr;
+        m_size = m_capacity = 0;
+        return bytes;
+    }
+};
+
+/// Appends to a growable, contiguous byte container such as std::vector<uint8_t>, std::string or bebop::ByteBuffer.
+template<typename C> class ContainerSink {
+    static_assert(sizeof(typename C::value_type) == 1, "ContainerSink needs a container of bytes");
+    C& m_container;
+public:
+    ContainerSink(C& container) : m_container(container) {}
+
+    C& container() { return m_container; }
+    size_t size() const { return m_container.size(); }
+    void reserve(size_t additional) {
+        const auto needed = m_container.size() + additional;
+        if (needed > m_container.capacity()) {
+            m_container.reserve(std::max(needed, 2 * m_container.capacity()));
+        }
+    }
+    uint8_t* extend(size_t count) {
+        const auto n = m_container.size();
+        m_container.resize(n + count);
+        return reinterpret_cast<uint8_t*>(m_container.data()) + n;
+    }
+    uint8_t* at(size_t position) { return reinterpret_cast<uint8_t*>(m_container.data()) + position; }
+};
+
+using VectorSink = ContainerSink<std::vector<uint8_t>>;
+using StringSink = ContainerSink<std::string>;
+using ByteBufferSink = ContainerSink<ByteBuffer>;
+#if BEBOP_HAS_MEMORY_RESOURCE
+using PmrVectorSink = ContainerSink<std::pmr::vector<uint8_t>>;
+using PmrStringSink = ContainerSink<std::pmr::string>;
+#endif
+
+/// Writes into a caller-owned region of fixed capacity, such as a socket send
+/// ring or a memory-mapped file. Throws BufferOverflowException when full.
+class FixedBufferSink {
+    uint8_t* m_data;
+    size_t m_capacity;
+    size_t m_size;
+public:
+    FixedBufferSink(uint8_t* data, size_t capacity) : m_data(data), m_capacity(capacity), m_size(0) {}
+
+    uint8_t* data() const { return m_data; }
+    size_t capacity() const { return m_capacity; }
+    size_t size() const { return m_size; }
+    uint8_t* extend(size_t count) {
+        if (count > m_capacity - m_size) BEBOP_THROW(BufferOverflowException());
+        uint8_t* p = m_data + m_size;
+        m_size += count;
+        return p;
+    }
+    uint8_t* at(size_t position) { return m_data + position; }
+};
+
+/// Writes into a caller-owned region of fixed capacity without checking it:
+/// whoever writes must already know the region has room. SpanWriter checks
+/// once per record against the record's generated `maxEncodedSize`.
+class SpanSink {
+    uint8_t* m_data;
+    size_t m_capacity;
+    size_t m_size;
+public:
+    SpanSink(uint8_t* data, size_t capacity) : m_data(data), m_capacity(capacity), m_size(0) {}
+
+    uint8_t* data() const { return m_data; }
+    size_t capacity() const { return m_capacity; }
+    size_t remaining() const { return m_capacity - m_size; }
+    size_t size() const { return m_size; }
+    uint8_t* extend(size_t count) {
+        uint8_t* p = m_data + m_size;
+        m_size += count;
+        return p;
+    }
+    uint8_t* at(size_t position) { return m_data + position; }
+};
+
+static_assert(isSink<VectorSink>, "VectorSink should be a sink");
+static_assert(isSink<StringSink>, "StringSink should be a sink");
+static_assert(isSink<ByteBufferSink>, "ByteBufferSink should be a sink");
+static_assert(isSink<FixedBufferSink>, "FixedBufferSink should be a sink");
+static_assert(isSink<SpanSink>, "SpanSink should be a sink");
+
+/// Encodes Bebop primitives into a sink. Generated `encodeInto` functions are
+/// templates over the writer type, so any BasicWriter works with no virtual dispatch.
+template<typename Sink> class BasicWriter {
+    static_assert(isSink<Sink>, "BasicWriter requires a type that satisfies the Sink requirements");
+    Sink m_sink;
+public:
+    BasicWriter(Sink sink) : m_sink(std::move(sink)) {}
+    BasicWriter(BasicWriter const&) = delete;
+    void operator=(BasicWriter const&) = delete;
+
+    Sink& sink() { return m_sink; }
+
+    /// The underlying container, for sinks that wrap one.
+    auto& buffer() {
+        return m_sink.container();
+    }
+
+    size_t length() { return m_sink.size(); }
+
+    /// Make room for at least `additional` more bytes, if the sink supports it.
+    void reserve(size_t additional) {
+        if constexpr (HasReserve<Sink>::value) m_sink.reserve(additional);
+    }
+
+    void writeByte(uint8_t value) {
+        BEBOP_INSTRUMENT_PRIMITIVE(Write, Byte, sizeof(value));
+        *m_sink.extend(1) = value;
+    }
+    void writeUint16(uint16_t value) {
+        BEBOP_INSTRUMENT_PRIMITIVE(Write, Uint16, sizeof(value));
+        uint8_t* p = m_sink.extend(sizeof(value));
+#if BEBOP_ASSUME_LITTLE_ENDIAN
+        memcpy(p, &value, sizeof(value));
+#else
+        p[0] = value;
+        p[1] = value >> 8;
+#endif
+    }
+    void writeUint32(uint32_t value) {
+        BEBOP_INSTRUMENT_PRIMITIVE(Write, Uint32, sizeof(value));
+        uint8_t* p = m_sink.extend(sizeof(value));
+#if BEBOP_ASSUME_LITTLE_ENDIAN
+        memcpy(p, &value, sizeof(value));
+#else
+        p[0] = value;
+        p[1] = value >> 8;
+        p[2] = value >> 16;
+        p[3] = value >> 24;
+#endif
+    }
+    void writeUint64(uint64_t value) {
+        BEBOP_INSTRUMENT_PRIMITIVE(Write, Uint64, sizeof(value));
+        uint8_t* p = m_sink.extend(sizeof(value));
+#if BEBOP_ASSUME_LITTLE_ENDIAN
+        memcpy(p, &value, sizeof(value));
+#else
+        p[0] = value;
+        p[1] = value >> 0x08;
+        p[2] = value >> 0x10;
+        p[3] = value >> 0x18;
+        p[4] = value >> 0x20;
+        p[5] = value >> 0x28;
+        p[6] = value >> 0x30;
+        p[7] = value >> 0x38;
+#endif
+    }
+
+    void writeInt16(int16_t value) { writeUint16(static_cast<uint16_t>(value)); }
+    void writeInt32(int32_t value) { writeUint32(static_cast<uint32_t>(value)); }
+    void writeInt64(int64_t value) { writeUint64(static_cast<uint64_t>(value)); }
+    void writeFloat32(float value) {
+        uint32_t temp;
+        memcpy(&temp, &value, sizeof(float));
+        writeUint32(temp);
+    }
+    void writeFloat64(double value) {
+        uint64_t temp;
+        memcpy(&temp, &value, sizeof(double));
+        writeUint64(temp);
+    }
+    void writeBool(bool value) { writeByte(value); }
+
+    /// Write a byte array from `length` bytes at `data`, which the writer does not keep.
+    void writeBytes(const uint8_t* data, size_t length) {
+        writeUint32(length);
+        BEBOP_INSTRUMENT_PRIMITIVE(Write, Bytes, length);
+        if (length) memcpy(m_sink.extend(length), data, length);
+    }
+    template<typename A> void writeBytes(const std::vector<uint8_t, A>& value) { writeBytes(value.data(), value.size()); }
+
+    /// Write a string from `length` bytes of UTF-8 at `data`, which the writer does not keep.
+    void writeString(const char* data, size_t length) {
+        writeUint32(length);
+        BEBOP_INSTRUMENT_PRIMITIVE(Write, String, length);
+        if (length) memcpy(m_sink.extend(length), data, length);
+    }
+    void writeString(std::string_view value) { writeString(value.data(), value.size()); }
+
+    void writeGuid(Guid value) {
+        BEBOP_INSTRUMENT_PRIMITIVE(Write, Guid, sizeof(Guid));
+        uint8_t* p = m_sink.extend(sizeof(Guid));
+#if BEBOP_ASSUME_LITTLE_ENDIAN
+        // Guid is packed, and its fields are little-endian like its encoding.
+        memcpy(p, &value, sizeof(Guid));
+#else
+        p[0] = value.m_a;
+        p[1] = value.m_a >> 8;
+        p[2] = value.m_a >> 16;
+        p[3] = value.m_a >> 24;
+        p[4] = value.m_b;
+        p[5] = value.m_b >> 8;
+        p[6] = value.m_c;
+        p[7] = value.m_c >> 8;
+        p[8] = value.m_d;
+        p[9] = value.m_e;
+        p[10] = value.m_f;
+        p[11] = value.m_g;
+        p[12] = value.m_h;
+        p[13] = value.m_i;
+        p[14] = value.m_j;
+        p[15] = value.m_k;
+#endif
+    }
+
+    void writeDate(TickDuration duration) {
+        writeUint64(dateToTicks(duration));
+    }
+
+    /// Append `length` raw bytes.
+    void writeRaw(const uint8_t* data, size_t length) {
+        BEBOP_INSTRUMENT_PRIMITIVE(Write, Raw, length);
+        if (length) memcpy(m_sink.extend(length), data, length);
+    }
+
+    /// Write a single fixed-size scalar or enum of type `T`.
+    template<typename T> void writeScalar(T value) {
+        if constexpr (std::is_enum<T>::value) writeScalar(static_cast<typename std::underlying_type<T>::type>(value));
+        else if constexpr (std::is_same<T, bool>::value) writeBool(value);
+        else if constexpr (std::is_same<T, uint8_t>::value) writeByte(value);
+        else if constexpr (std::is_same<T, uint16_t>::value) writeUint16(value);
+        else if constexpr (std::is_same<T, int16_t>::value) writeInt16(value);
+        else if constexpr (std::is_same<T, uint32_t>::value) writeUint32(value);
+        else if constexpr (std::is_same<T, int32_t>::value) writeInt32(value);
+        else if constexpr (std::is_same<T, uint64_t>::value) writeUint64(value);
+        else if constexpr (std::is_same<T, int64_t>::value) writeInt64(value);
+        else if constexpr (std::is_same<T, float>::value) writeFloat32(value);
+        else if constexpr (std::is_same<T, double>::value) writeFloat64(value);
+        else if constexpr (std::is_same<T, Guid>::value) writeGuid(value);
+        else if constexpr (std::is_same<T, TickDuration>::value) writeDate(value);
+        else static_assert(sizeof(T) == 0, "not a Bebop scalar type");
+    }
+
+    /// Write an array of `count` fixed-size scalars or enums at `values`. On little-endian hosts the
+    /// elements are copied in bulk, with one call into the sink.
+    template<typename T> void writeScalarArray(const T* values, size_t count) {
+        writeUint32(count);
+#if BEBOP_ASSUME_LITTLE_ENDIAN
+        if constexpr (!std::is_same<T, TickDuration>::value && !std::is_same<T, bool>::value) {
+            BEBOP_INSTRUMENT_PRIMITIVE(Write, Array, count * sizeof(T));
+            if (count) memcpy(m_sink.extend(count * sizeof(T)), values, count * sizeof(T));
+            return;
+        }
+#endif
+        for (size_t i = 0; i < count; i++) writeScalar(values[i]);
+    }
+    template<typename T, typename A> void writeScalarArray(const std::vector<T, A>& values) { writeScalarArray(values.data(), values.size()); }
+    template<typename A> void writeScalarArray(const std::vector<bool, A>& values) {
+        writeUint32(values.size());
+        BEBOP_INSTRUMENT_PRIMITIVE(Write, Array, values.size());
+        if (values.empty()) return;
+        uint8_t* p = m_sink.extend(values.size());
+        for (const bool value : values) *p++ = value;
+    }
+
+    /// Write an array of a fixed-size struct `T` that has a generated `T::Packed` wire layout.
+    template<typename T, typename A> void writePackedArray(const std::vector<T, A>& values) {
+        writeUint32(values.size());
+#if BEBOP_ASSUME_LITTLE_ENDIAN
+        constexpr size_t size = sizeof(typename T::Packed);
+        if (values.empty()) return;
+        BEBOP_INSTRUMENT_PRIMITIVE(Write, Array, values.size() * size);
+        uint8_t* p = m_sink.extend(values.size() * size);
+        if constexpr (T::hasWireLayout()) {
+            memcpy(p, values.data(), values.size() * size);
+        } else {
+            for (const auto& value : values) {
+                const auto packed = T::pack(value);
+                memcpy(p, &packed, size);
+                p += size;
+            }
+        }
+#else
+        for (const auto& value : values) T::encodeInto(value, *this);
+#endif
+    }
+
+    /// Reserve some space to write a message's length prefix, and return its index.
+    /// The length is stored as a little-endian fixed-width unsigned 32-bit integer, so 4 bytes are reserved.
+    size_t reserveMessageLength() {
+        BEBOP_INSTRUMENT_PRIMITIVE(Write, Uint32, sizeof(uint32_t));
+        const auto n = m_sink.size();
+        m_sink.extend(4);
+        return n;
+    }
+
+    /// Fill in a message's length prefix.
+    void fillMessageLength(size_t position, uint32_t messageLength) {
+        uint8_t* p = m_sink.at(position);
+#if BEBOP_ASSUME_LITTLE_ENDIAN
+        memcpy(p, &messageLength, sizeof(uint32_t));
+#else
+        p[0] = messageLength;
+        p[1] = messageLength >> 8;
+        p[2] = messageLength >> 16;
+        p[3] = messageLength >> 24;
+#endif
+    }
+};
+
+/// The default writer, which appends to a std::vector<uint8_t>.
+using Writer = BasicWriter<VectorSink>;
+using StringWriter = BasicWriter<StringSink>;
+using FixedBufferWriter = BasicWriter<FixedBufferSink>;
+using ByteBufferWriter = BasicWriter<ByteBufferSink>;
+#if BEBOP_HAS_MEMORY_RESOURCE
+using PmrVectorWriter = BasicWriter<PmrVectorSink>;
+#endif
+
+/// Encodes whole records into a caller-owned region, such as a pre-registered
+/// network buffer, with a single capacity check per record: `encode` compares
+/// the record's generated `maxEncodedSize` with the room left, and the
+/// primitives it then writes are not checked again. Use the write methods
+/// directly only for bytes you have already made room for.
+class SpanWriter : public BasicWriter<SpanSink> {
+public:
+    SpanWriter(uint8_t* data, size_t capacity) : BasicWriter(SpanSink{data, capacity}) {}
+
+    uint8_t* data() { return sink().data(); }
+    size_t remaining() { return sink().remaining(); }
+
+    /// Encode `record` and return its size. Throws BufferOverflowException,
+    /// writing nothing, if the region might not have room for it.
+    template<typename T> size_t encode(const T& record) {
+        if (T::maxEncodedSize(record) > remaining()) BEBOP_THROW(BufferOverflowException());
+        return T::encodeInto(record, *this);
+    }
+
+    /// Encode `record` if the region is sure to have room for it; returns false, writing nothing, otherwise.
+    template<typename T> bool tryEncode(const T& record) {
+        if (T::maxEncodedSize(record) > remaining()) return false;
+        T::encodeInto(record, *this);
+        return true;
+    }
+};
+
+class ByteCounter {
+    size_t m_bytes;
+public:
+    ByteCounter() : m_bytes(0) {}
+    ByteCounter(ByteCounter const&) = delete;
+    void operator=(ByteCounter const&) = delete;
 
     size_t length() { return m_bytes; }
 
-    void writeByte(uint8_t value) { m_bytes += sizeof(value); }
-    void writeUint16(uint16_t value) { m_bytes += sizeof(value); }
-    void writeUint32(uint32_t value) { m_bytes += sizeof(value); }
-    void writeUint64(uint64_t value) { m_bytes += sizeof(value); }
-    void writeInt16(int16_t value) { m_bytes += sizeof(value); }
-    void writeInt32(int32_t value) { m_bytes += sizeof(value); }
-    void writeInt64(int64_t value) { m_bytes += sizeof(value); }
-    void writeFloat32(float value) { m_bytes += sizeof(value); }
-    void writeFloat64(double value) { m_bytes += sizeof(value); }
-    void writeBool(bool value) { writeByte(value); }
-    void writeBytes(std::vector<uint8_t> value) { m_bytes += sizeof(uint32_t) + value.size(); }
-    void writeString(std::string value) { m_bytes += sizeof(uint32_t) + value.size(); }
-    void writeGuid(Guid value) { m_bytes += sizeof(value); }
-    void writeDate(TickDuration duration) { m_bytes += sizeof(uint64_t); }
-    size_t reserveMessageLength() { m_bytes += sizeof(uint32_t); return 0; }
-    void fillMessageLength(size_t position, uint32_t messageLength) { }
+    void writeByte(uint8_t value) { m_bytes += sizeof(value); }
+    void writeUint16(uint16_t value) { m_bytes += sizeof(value); }
+    void writeUint32(uint32_t value) { m_bytes += sizeof(value); }
+    void writeUint64(uint64_t value) { m_bytes += sizeof(value); }
+    void writeInt16(int16_t value) { m_bytes += sizeof(value); }
+    void writeInt32(int32_t value) { m_bytes += sizeof(value); }
+    void writeInt64(int64_t value) { m_bytes += sizeof(value); }
+    void writeFloat32(float value) { m_bytes += sizeof(value); }
+    void writeFloat64(double value) { m_bytes += sizeof(value); }
+    void writeBool(bool value) { writeByte(value); }
+    void writeBytes(const uint8_t*, size_t length) { m_bytes += sizeof(uint32_t) + length; }
+    template<typename A> void writeBytes(const std::vector<uint8_t, A>& value) { m_bytes += sizeof(uint32_t) + value.size(); }
+    void writeString(const char*, size_t length) { m_bytes += sizeof(uint32_t) + length; }
+    void writeString(std::string_view value) { m_bytes += sizeof(uint32_t) + value.size(); }
+    void writeGuid(Guid value) { m_bytes += sizeof(value); }
+    void writeDate(TickDuration) { m_bytes += sizeof(uint64_t); }
+    void writeRaw(const uint8_t*, size_t length) { m_bytes += length; }
+    // Every Bebop scalar, including TickDuration and Guid, is as big in memory as on the wire.
+    template<typename T> void writeScalar(T) { m_bytes += sizeof(T); }
+    template<typename T> void writeScalarArray(const T*, size_t count) { m_bytes += sizeof(uint32_t) + count * sizeof(T); }
+    template<typename T, typename A> void writeScalarArray(const std::vector<T, A>& values) { m_bytes += sizeof(uint32_t) + values.size() * sizeof(T); }
+    template<typename T, typename A> void writePackedArray(const std::vector<T, A>& values) { m_bytes += sizeof(uint32_t) + values.size() * sizeof(typename T::Packed); }
+    size_t reserveMessageLength() { m_bytes += sizeof(uint32_t); return 0; }
+    void fillMessageLength(size_t, uint32_t) { }
+};
+
+// Buffer pool
+//
+// A BufferPool lends out std::vector<uint8_t> encode buffers and takes them
+// back, so that a service encoding every outbound message into its own
+// buffer stops allocating once the pool has warmed up. Buffers are kept in
+// size classes by capacity, doubling from `minBufferSize`. A lease is served
+// from the calling thread's cache without locking, else from the pool's
+// overflow list under a lock, else newly allocated. A buffer goes back to the
+// cache of whichever thread ends its lease, such as the thread that sent it.
+// A full cache moves half its buffers to the overflow list, and an empty one
+// takes back up to half as many, so that threads which only lease and threads
+// which only return take the lock once per batch. What the list has no room
+// for is freed.
+
+struct BufferPoolOptions {
+    /// The capacity of the smallest size class, which must not be zero. Each class is twice the one before.
+    size_t minBufferSize = 256;
+    /// Buffers that grow past this are freed when they come back instead of being kept.
+    size_t maxBufferSize = size_t{1} << 20;
+    /// How many buffers of each class a thread keeps for itself.
+    size_t buffersPerThread = 8;
+    /// How many buffers of each class the overflow list shared by all threads keeps. Size it
+    /// to the buffers in flight between threads, or the leasing threads keep allocating.
+    size_t overflowBuffers = 64;
+};
+
+struct BufferPoolStats {
+    uint64_t leases = 0;
+    /// Leases served from the leasing thread's own cache.
+    uint64_t threadHits = 0;
+    /// Leases that refilled the thread's cache from the overflow list.
+    uint64_t overflowHits = 0;
+    /// Leases that allocated a new buffer.
+    uint64_t misses = 0;
+    /// Returned buffers that were freed, because they were too big or every cache was full.
+    uint64_t dropped = 0;
+    /// The buffers held for reuse, and their total capacity.
+    size_t buffersCached = 0;
+    size_t bytesCached = 0;
+
+    double hitRate() const { return leases ? static_cast<double>(threadHits + overflowHits) / leases : 0; }
+};
+
+namespace detail {
+    constexpr size_t bufferPoolClasses = 48;
+
+    /// Bumped only by the thread that owns it, and read by any: no read-modify-write needs to be atomic.
+    template<typename T> inline void bump(std::atomic<T>& counter, T delta) {
+        counter.store(counter.load(std::memory_order_relaxed) + delta, std::memory_order_relaxed);
+    }
+
+    /// One thread's buffers for one pool.
+    struct BufferCache {
+        std::vector<std::vector<uint8_t>> classes[bufferPoolClasses];
+        std::atomic<uint64_t> leases{0}, threadHits{0}, overflowHits{0}, misses{0}, dropped{0};
+        std::atomic<size_t> buffersCached{0}, bytesCached{0};
+
+        void push(size_t c, std::vector<uint8_t>&& buffer) {
+            bump(buffersCached, size_t{1});
+            bump(bytesCached, buffer.capacity());
+            classes[c].push_back(std::move(buffer));
+        }
+        std::vector<uint8_t> pop(size_t c) {
+            std::vector<uint8_t> buffer = std::move(classes[c].back());
+            classes[c].pop_back();
+            bump(buffersCached, size_t(-1));
+            bump(bytesCached, size_t{0} - buffer.capacity());
+            return buffer;
+        }
+
+        void fold(BufferPoolStats& stats) const {
+            stats.leases += leases.load(std::memory_order_relaxed);
+            stats.threadHits += threadHits.load(std::memory_order_relaxed);
+            stats.overflowHits += overflowHits.load(std::memory_order_relaxed);
+            stats.misses += misses.load(std::memory_order_relaxed);
+            stats.dropped += dropped.load(std::memory_order_relaxed);
+        }
+    };
+
+    struct BufferPoolState {
+        BufferPoolOptions options;
+        size_t classCount = 0;
+        std::atomic<bool> closed{false};
+        std::mutex mutex;
+        std::vector<std::vector<uint8_t>> overflow[bufferPoolClasses];
+        size_t overflowBytes = 0;
+        std::vector<BufferCache*> caches;
+        // The counters of caches whose threads have exited.
+        BufferPoolStats retired;
+
+        /// Move `buffer` of class `c` to the overflow list if it has room. Call with `mutex` held.
+        bool overflowInto(size_t c, std::vector<uint8_t>& buffer) {
+            if (overflow[c].size() >= options.overflowBuffers) return false;
+            overflowBytes += buffer.capacity();
+            overflow[c].push_back(std::move(buffer));
+            return true;
+        }
+    };
+
+    /// This thread's caches, one per pool it has used. When the thread exits, its buffers
+    /// move to their pools' overflow lists.
+    struct ThreadBufferCaches {
+        std::vector<std::pair<std::shared_ptr<BufferPoolState>, std::unique_ptr<BufferCache>>> entries;
+
+        ~ThreadBufferCaches() {
+            for (auto& entry : entries) retire(*entry.first, *entry.second);
+        }
+
+        static void retire(BufferPoolState& state, BufferCache& cache) {
+            std::lock_guard<std::mutex> lock{state.mutex};
+            for (size_t c = 0; c < state.classCount && !state.closed.load(std::memory_order_relaxed); c++) {
+                for (auto& buffer : cache.classes[c]) {
+                    if (!state.overflowInto(c, buffer)) bump(cache.dropped, uint64_t{1});
+                }
+            }
+            cache.fold(state.retired);
+            state.caches.erase(std::find(state.caches.begin(), state.caches.end(), &cache));
+        }
+
+        BufferCache& find(const std::shared_ptr<BufferPoolState>& state) {
+            for (auto& entry : entries) {
+                if (entry.first == state) return *entry.second;
+            }
+            // Forget pools that have been destroyed since this thread last looked.
+            entries.erase(std::remove_if(entries.begin(), entries.end(), [](auto& entry) {
+                if (!entry.first->closed.load(std::memory_order_relaxed)) return false;
+                retire(*entry.first, *entry.second);
+                return true;
+            }), entries.end());
+            auto cache = std::make_unique<BufferCache>();
+            {
+                std::lock_guard<std::mutex> lock{state->mutex};
+                state->caches.push_back(cache.get());
+            }
+            entries.emplace_back(state, std::move(cache));
+            return *entries.back().second;
+        }
+    };
+
+    inline ThreadBufferCaches& threadBufferCaches() {
+        thread_local ThreadBufferCaches caches;
+        return caches;
+    }
+} // namespace detail
+
+class BufferPool {
+    std::shared_ptr<detail::BufferPoolState> m_state;
+
+    /// The smallest class whose buffers hold `size` bytes, or classCount if none does.
+    size_t leaseClass(size_t size) const {
+        size_t c = 0;
+        while (c < m_state->classCount && (m_state->options.minBufferSize << c) < size) c++;
+        return c;
+    }
+
+    /// The largest class whose buffers a buffer of `capacity` can stand in for, or classCount if it is not kept.
+    size_t returnClass(size_t capacity) const {
+        if (capacity < m_state->options.minBufferSize || capacity > m_state->options.maxBufferSize) return m_state->classCount;
+        size_t c = 0;
+        while (c + 1 < m_state->classCount && (m_state->options.minBufferSize << (c + 1)) <= capacity) c++;
+        return c;
+    }
+
+    /// Half a full cache, the batch moved to or from the overflow list at once.
+    size_t batchSize() const { return std::max<size_t>(m_state->options.buffersPerThread / 2, 1); }
+
+    void giveBack(std::vector<uint8_t>&& returned) {
+        std::vector<uint8_t> buffer = std::move(returned);
+        auto& cache = detail::threadBufferCaches().find(m_state);
+        const size_t c = returnClass(buffer.capacity());
+        if (c < m_state->classCount) {
+            buffer.clear();
+            if (cache.classes[c].size() >= m_state->options.buffersPerThread) {
+                std::lock_guard<std::mutex> lock{m_state->mutex};
+                for (size_t i = batchSize(); i > 0 && !cache.classes[c].empty(); i--) {
+                    auto moved = cache.pop(c);
+                    if (!m_state->overflowInto(c, moved)) {
+                        cache.push(c, std::move(moved));
+                        break;
+                    }
+                }
+            }
+            if (cache.classes[c].size() < m_state->options.buffersPerThread) {
+                cache.push(c, std::move(buffer));
+                return;
+            }
+        }
+        detail::bump(cache.dropped, uint64_t{1});
+    }
+
+public:
+    /// A buffer on loan from a pool, which goes back to the pool when the lease ends.
+    /// Encode into it like any std::vector<uint8_t>, e.g. `T::encodeInto(record, *lease)`.
+    class Lease {
+        friend class BufferPool;
+        BufferPool* m_pool = nullptr;
+        std::vector<uint8_t> m_buffer;
+
+        Lease(BufferPool* pool, std::vector<uint8_t>&& buffer) : m_pool(pool), m_buffer(std::move(buffer)) {}
+        void giveBack() {
+            if (m_pool) std::exchange(m_pool, nullptr)->giveBack(std::move(m_buffer));
+        }
+    public:
+        Lease() = default;
+        Lease(Lease&& other) noexcept : m_pool(std::exchange(other.m_pool, nullptr)), m_buffer(std::move(other.m_buffer)) {}
+        Lease& operator=(Lease&& other) noexcept {
+            if (this != &other) {
+                giveBack();
+                m_pool = std::exchange(other.m_pool, nullptr);
+                m_buffer = std::move(other.m_buffer);
+            }
+            return *this;
+        }
+        ~Lease() { giveBack(); }
+
+        std::vector<uint8_t>& buffer() { return m_buffer; }
+        std::vector<uint8_t>& operator*() { return m_buffer; }
+        std::vector<uint8_t>* operator->() { return &m_buffer; }
+        uint8_t* data() { return m_buffer.data(); }
+        size_t size() const { return m_buffer.size(); }
+
+        /// Keep the buffer instead of returning it to the pool.
+        std::vector<uint8_t> release() {
+            m_pool = nullptr;
+            return std::move(m_buffer);
+        }
+    };
+
+    /// The pool must outlive every lease taken from it.
+    explicit BufferPool(BufferPoolOptions options = {}) : m_state(std::make_shared<detail::BufferPoolState>()) {
+        m_state->options = options;
+        while (m_state->classCount < detail::bufferPoolClasses && options.minBufferSize <= (options.maxBufferSize >> m_state->classCount)) {
+            m_state->classCount++;
+        }
+    }
+    ~BufferPool() {
+        // Threads drop their caches of a closed pool the next time they look one up, or when they exit.
+        std::lock_guard<std::mutex> lock{m_state->mutex};
+        m_state->closed.store(true, std::memory_order_relaxed);
+        for (auto& cached : m_state->overflow) cached.clear();
+    }
+    BufferPool(BufferPool const&) = delete;
+    void operator=(BufferPool const&) = delete;
+
+    /// A pool for the whole process. It is never destroyed, so threads may return leases during exit.
+    static BufferPool& defaultPool() {
+        static BufferPool* pool = new BufferPool;
+        return *pool;
+    }
+
+    /// Borrow an empty buffer with room for at least `sizeHint` bytes.
+    Lease lease(size_t sizeHint = 0) {
+        auto& cache = detail::threadBufferCaches().find(m_state);
+        detail::bump(cache.leases, uint64_t{1});
+        std::vector<uint8_t> buffer;
+        const size_t c = leaseClass(sizeHint);
+        if (c < m_state->classCount) {
+            if (!cache.classes[c].empty()) {
+                detail::bump(cache.threadHits, uint64_t{1});
+                return Lease{this, cache.pop(c)};
+            }
+            {
+                std::lock_guard<std::mutex> lock{m_state->mutex};
+                auto& overflow = m_state->overflow[c];
+                for (size_t i = batchSize(); i > 0 && !overflow.empty(); i--) {
+                    m_state->overflowBytes -= overflow.back().capacity();
+                    cache.push(c, std::move(overflow.back()));
+                    overflow.pop_back();
+                }
+            }
+            if (!cache.classes[c].empty()) {
+                detail::bump(cache.overflowHits, uint64_t{1});
+                return Lease{this, cache.pop(c)};
+            }
+            sizeHint = m_state->options.minBufferSize << c;
+        }
+        detail::bump(cache.misses, uint64_t{1});
+        buffer.reserve(sizeHint);
+        return Lease{this, std::move(buffer)};
+    }
+
+    /// Totals across every thread, including threads that have exited.
+    BufferPoolStats stats() const {
+        std::lock_guard<std::mutex> lock{m_state->mutex};
+        BufferPoolStats stats = m_state->retired;
+        for (const auto* cache : m_state->caches) {
+            cache->fold(stats);
+            stats.buffersCached += cache->buffersCached.load(std::memory_order_relaxed);
+            stats.bytesCached += cache->bytesCached.load(std::memory_order_relaxed);
+        }
+        for (size_t c = 0; c < m_state->classCount; c++) stats.buffersCached += m_state->overflow[c].size();
+        stats.bytesCached += m_state->overflowBytes;
+        return stats;
+    }
+};
+
+// Frames
+//
+// A frame stream carries one encoded record per frame:
+//
+//     uint32 length   the size of the payload
+//     uint32 opcode   the record's @opcode fourcc, only with FrameOptions::opcodes
+//     payload         `length` bytes
+//
+// FrameWriter and FrameReader work over a caller's buffer or, on POSIX systems,
+// over a file descriptor such as a pipe or a socket. A FrameWriter on a
+// descriptor batches frames and hands the batch to the kernel in one writev
+// once it is big enough or its oldest frame has waited `flushDelay`. Nothing
+// runs in the background: an event loop that holds frames back should call
+// `flushIfDue` by `deadline()`. A FrameReader reads as much as its buffer
+// holds at once and returns frames that point into that buffer.
+
+struct FrameOptions {
+    /// Whether every frame carries an opcode after its length. Both ends must agree.
+    bool opcodes = false;
+    /// The largest payload a FrameReader accepts.
+    size_t maxFrameSize = 16 * 1024 * 1024;
+    /// How long a FrameWriter may hold a frame back to share a write with later ones. Zero writes every frame at once.
+    std::chrono::microseconds flushDelay{0};
+    /// A FrameWriter writes as soon as this many bytes are waiting, whatever the delay.
+    size_t flushBytes = 64 * 1024;
+    /// The initial size of a FrameReader's receive buffer, and so the most it reads at once.
+    size_t receiveBufferSize = 64 * 1024;
+
+    size_t headerSize() const { return opcodes ? 2 * sizeof(uint32_t) : sizeof(uint32_t); }
+};
+
+/// A frame split out of a FrameReader's buffer. `data` points into that buffer.
+struct Frame {
+    uint32_t opcode = 0;
+    const uint8_t* data = nullptr;
+    size_t size = 0;
+
+    template<typename T> DecodeResult decodeInto(T& target) const { return T::tryDecodeInto(data, size, target); }
+};
+
+enum class FrameStatus {
+    /// A frame was returned.
+    Ok,
+    /// No whole frame is available yet: the buffer ends mid-frame, or a non-blocking descriptor has nothing to read.
+    NeedMore,
+    /// The stream ended cleanly between frames.
+    End,
+    /// A frame is larger than `maxFrameSize`, or the stream ended mid-frame.
+    MalformedPacket,
+    /// The descriptor failed; see `error()`.
+    IoError,
+};
+
+template<typename T, typename = void> struct HasOpcode : std::false_type {};
+template<typename T> struct HasOpcode<T, std::void_t<decltype(T::opcode)>> : std::true_type {};
+
+class FrameWriter {
+    FrameOptions m_options;
+    int m_fd = -1;
+    std::vector<uint8_t> m_batch;
+    std::vector<uint8_t>* m_out;
+    std::chrono::steady_clock::time_point m_oldest;
+    int m_error = 0;
+public:
+    /// Append frames to `buffer`.
+    explicit FrameWriter(std::vector<uint8_t>& buffer, FrameOptions options = {}) : m_options(options), m_out(&buffer) {}
+#if BEBOP_HAS_POSIX_IO
+    /// Write frames to a descriptor. Writing blocks until the descriptor has taken the whole batch.
+    explicit FrameWriter(int fd, FrameOptions options = {}) : m_options(options), m_fd(fd), m_out(&m_batch) {}
+#endif
+    FrameWriter(FrameWriter const&) = delete;
+    void operator=(FrameWriter const&) = delete;
+    ~FrameWriter() { flush(); }
+
+    /// Frame a record, tagged with its opcode if it has one.
+    template<typename T> bool write(const T& record) {
+        if constexpr (HasOpcode<T>::value) {
+            return write(record, T::opcode);
+        } else {
+            return write(record, 0);
+        }
+    }
+
+    template<typename T> bool write(const T& record, uint32_t opcode) {
+        if (m_error) return false;
+        Writer writer{*m_out};
+        const size_t position = writer.reserveMessageLength();
+        if (m_options.opcodes) writer.writeUint32(opcode);
+        const size_t length = T::encodeInto(record, writer);
+        writer.fillMessageLength(position, static_cast<uint32_t>(length));
+        return framed(position);
+    }
+
+    /// Frame a payload that is already encoded. On a descriptor, a payload of at least `flushBytes` is written
+    /// straight from `payload` rather than copied into the batch.
+    bool writeFrame(uint32_t opcode, const uint8_t* payload, size_t size) {
+        if (m_error) return false;
+        Writer writer{*m_out};
+        const size_t position = writer.reserveMessageLength();
+        writer.fillMessageLength(position, static_cast<uint32_t>(size));
+        if (m_options.opcodes) writer.writeUint32(opcode);
+#if BEBOP_HAS_POSIX_IO
+        if (m_fd >= 0 && size >= m_options.flushBytes) return writeOut(payload, size);
+#endif
+        writer.writeRaw(payload, size);
+        return framed(position);
+    }
+
+    /// Write out every frame held back.
+    bool flush() {
+#if BEBOP_HAS_POSIX_IO
+        if (m_fd >= 0 && !m_batch.empty()) return writeOut(nullptr, 0);
+#endif
+        return m_error == 0;
+    }
+
+    /// Write out the frames held back if the oldest has waited `flushDelay`.
+    bool flushIfDue() {
+        if (m_batch.empty() || std::chrono::steady_clock::now() < deadline()) return m_error == 0;
+        return flush();
+    }
+
+    /// When the frames held back are due to be written.
+    std::chrono::steady_clock::time_point deadline() const {
+        if (m_batch.empty()) return std::chrono::steady_clock::time_point::max();
+        return m_oldest + m_options.flushDelay;
+    }
+
+    size_t bytesBuffered() const { return m_batch.size(); }
+
+    /// The errno of the write that failed, or 0.
+    int error() const { return m_error; }
+
+private:
+    bool framed(size_t position) {
+        if (m_fd < 0) return true;
+        if (m_batch.size() >= m_options.flushBytes || m_options.flushDelay.count() == 0) return flush();
+        const auto now = std::chrono::steady_clock::now();
+        if (position == 0) m_oldest = now;
+        return now - m_oldest < m_options.flushDelay || flush();
+    }
+
+#if BEBOP_HAS_POSIX_IO
+    /// Write the batch, then `payload`, in as few system calls as the descriptor allows.
+    bool writeOut(const uint8_t* payload, size_t size) {
+        iovec parts[2] = {{m_batch.data(), m_batch.size()}, {const_cast<uint8_t*>(payload), size}};
+        iovec* next = parts;
+        int count = size ? 2 : 1;
+        while (count > 0) {
+            const ssize_t n = ::writev(m_fd, next, count);
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                    pollfd writable{m_fd, POLLOUT, 0};
+                    ::poll(&writable, 1, -1);
+                    continue;
+                }
+                m_error = errno;
+                m_batch.clear();
+                return false;
+            }
+            size_t written = static_cast<size_t>(n);
+            while (count > 0 && written >= next->iov_len) {
+                written -= next->iov_len;
+                next++;
+                count--;
+            }
+            if (count > 0) {
+                next->iov_base = static_cast<uint8_t*>(next->iov_base) + written;
+                next->iov_len -= written;
+            }
+        }
+        m_batch.clear();
+        return true;
+    }
+#endif
+};
+
+class FrameReader {
+    FrameOptions m_options;
+    int m_fd = -1;
+    std::vector<uint8_t> m_buffer;
+    const uint8_t* m_data;
+    size_t m_begin = 0;
+    size_t m_end;
+    int m_error = 0;
+public:
+    /// Split the frames out of `data`, which must outlive them.
+    FrameReader(const uint8_t* data, size_t size, FrameOptions options = {}) : m_options(options), m_data(data), m_end(size) {}
+#if BEBOP_HAS_POSIX_IO
+    /// Read frames from a descriptor. On a non-blocking descriptor, `next` returns NeedMore instead of waiting.
+    explicit FrameReader(int fd, FrameOptions options = {})
+        : m_options(options), m_fd(fd), m_buffer(options.receiveBufferSize), m_data(m_buffer.data()), m_end(0) {}
+#endif
+    FrameReader(FrameReader const&) = delete;
+    void operator=(FrameReader const&) = delete;
+
+    /// Get the next frame. Its data stays valid until the next call.
+    FrameStatus next(Frame& frame) {
+        while (true) {
+            const size_t header = m_options.headerSize();
+            const size_t available = m_end - m_begin;
+            size_t needed = header;
+            if (available >= header) {
+                Reader reader{m_data + m_begin, header};
+                const size_t length = reader.readUint32();
+                const uint32_t opcode = m_options.opcodes ? reader.readUint32() : 0;
+                if (length > m_options.maxFrameSize) return FrameStatus::MalformedPacket;
+                needed += length;
+                if (available >= needed) {
+                    frame = Frame{opcode, m_data + m_begin + header, length};
+                    m_begin += needed;
+                    return FrameStatus::Ok;
+                }
+            }
+            if (m_fd < 0) return available == 0 ? FrameStatus::End : FrameStatus::NeedMore;
+#if BEBOP_HAS_POSIX_IO
+            const auto status = receive(needed);
+            if (status != FrameStatus::Ok) return status;
+#endif
+        }
+    }
+
+    /// How many bytes have been split into frames. Over a caller's buffer, the rest begins a frame still to come.
+    size_t bytesConsumed() const { return m_begin; }
+
+    /// The errno of the read that failed, or 0.
+    int error() const { return m_error; }
+
+private:
+#if BEBOP_HAS_POSIX_IO
+    /// Read once into the buffer, first making room for a frame of `needed` bytes.
+    FrameStatus receive(size_t needed) {
+        if (m_begin == m_end) m_begin = m_end = 0;
+        if (needed > m_buffer.size() - m_begin) {
+            memmove(m_buffer.data(), m_buffer.data() + m_begin, m_end - m_begin);
+            m_end -= m_begin;
+            m_begin = 0;
+            if (needed > m_buffer.size()) m_buffer.resize(std::max(needed, 2 * m_buffer.size()));
+            m_data = m_buffer.data();
+        }
+        while (true) {
+            const ssize_t n = ::read(m_fd, m_buffer.data() + m_end, m_buffer.size() - m_end);
+            if (n > 0) {
+                m_end += static_cast<size_t>(n);
+                return FrameStatus::Ok;
+            }
+            if (n == 0) return m_begin == m_end ? FrameStatus::End : FrameStatus::MalformedPacket;
+            if (errno == EINTR) continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK) return FrameStatus::NeedMore;
+            m_error = errno;
+            return FrameStatus::IoError;
+        }
+    }
+#endif
+};
+
+// Opcode dispatch
+//
+// A schema whose records have @opcode gets a generated `dispatchOpcode`,
+// which decodes a payload as the record with the given opcode and hands it
+// to a handler: any callable that takes each of those records, such as a
+// struct with one operator() per record or a generic lambda.
+
+enum class DispatchStatus {
+    Ok,
+    /// No record in the schema has the opcode.
+    UnknownOpcode,
+    MalformedPacket,
+};
+
+/// The hash that generated dispatchers map sparse opcodes with (murmur3's 32-bit finalizer).
+constexpr uint32_t opcodeHash(uint32_t opcode, uint32_t seed) {
+    uint32_t h = opcode ^ seed;
+    h ^= h >> 16;
+    h *= 0x85ebca6bu;
+    h ^= h >> 13;
+    h *= 0xc2b2ae35u;
+    h ^= h >> 16;
+    return h;
+}
+
+/// Decode a `T` and pass it to `handler`.
+template<typename T, typename Handler> DispatchStatus decodeAndDispatch(const uint8_t* data, size_t size, Handler& handler) {
+    T record;
+    if (!T::tryDecodeInto(data, size, record)) return DispatchStatus::MalformedPacket;
+    handler(record);
+    return DispatchStatus::Ok;
+}
+
+// Services
+//
+// A Tempo service gets a generated `BaseFooService` to implement on the server
+// and a `FooClient` to call it with. Neither knows how calls travel: a client
+// hands each call to a ClientTransport, which eventually runs the service's
+// `dispatch`. Every method type has the same shape on the wire side: the
+// service pulls encoded requests from a PayloadSource and pushes encoded
+// responses into a PayloadSink, so a unary method is a stream of one record
+// in each direction. Payloads are moved from hand to hand, never copied.
+
+enum class MethodType {
+    Unary,
+    ServerStream,
+    ClientStream,
+    DuplexStream,
+};
+
+enum class RpcStatus {
+    Ok,
+    /// The service has no method with the id.
+    UnknownMethod,
+    /// A request or response did not decode.
+    MalformedPacket,
+    /// The handler failed the call through its CallContext.
+    Failed,
+    /// The transport could not carry the call.
+    Unavailable,
+};
+
+/// The outcome of a call, as seen by a handler (which may `fail` it) and by the client.
+struct CallContext {
+    uint32_t methodId = 0;
+    RpcStatus status = RpcStatus::Ok;
+    std::string error;
+
+    void fail(std::string message) {
+        status = RpcStatus::Failed;
+        error = std::move(message);
+    }
+    bool ok() const { return status == RpcStatus::Ok; }
+    explicit operator bool() const { return ok(); }
+};
+
+/// One encoded record.
+using Payload = std::vector<uint8_t>;
+
+/// Yields the encoded records of one direction of a call.
+class PayloadSource {
+public:
+    virtual ~PayloadSource() = default;
+    /// Move the next record into `payload`; false at the end of the stream.
+    virtual bool next(Payload& payload) = 0;
+};
+
+/// Takes the encoded records of one direction of a call.
+class PayloadSink {
+public:
+    virtual ~PayloadSink() = default;
+    /// Take the next record; false if the other side no longer wants any.
+    virtual bool write(Payload&& payload) = 0;
+};
+
+/// Decodes the records of a stream as a handler asks for them.
+template<typename T> class StreamReader {
+public:
+    explicit StreamReader(PayloadSource& source) : m_source(source) {}
+
+    /// Decode the next record into `record`; false at the end of the stream or if it is malformed.
+    bool next(T& record) {
+        if (m_malformed || !m_source.next(m_payload)) return false;
+        if (!T::tryDecodeInto(m_payload, record)) {
+            m_malformed = true;
+            return false;
+        }
+        return true;
+    }
+    bool malformed() const { return m_malformed; }
+
+private:
+    PayloadSource& m_source;
+    Payload m_payload;
+    bool m_malformed = false;
+};
+
+/// Encodes the records of a stream as a handler produces them.
+template<typename T> class StreamWriter {
+public:
+    explicit StreamWriter(PayloadSink& sink) : m_sink(sink) {}
+
+    /// Send `record`; false if the other side no longer wants any.
+    bool write(const T& record) {
+        Payload payload;
+        T::encodeInto(record, payload);
+        return m_sink.write(std::move(payload));
+    }
+
+private:
+    PayloadSink& m_sink;
+};
+
+/// Implemented by the generated `BaseFooService` of each service.
+class Service {
+public:
+    virtual ~Service() = default;
+    virtual const char* serviceName() const = 0;
+    /// Run the method `methodId`, reading its requests from `requests` and writing its responses to `responses`.
+    virtual void dispatch(uint32_t methodId, PayloadSource& requests, PayloadSink& responses, CallContext& context) = 0;
+};
+
+/// Carries a client's calls to a service.
+class ClientTransport {
+public:
+    virtual ~ClientTransport() = default;
+    /// Make a call, reading its requests from `requests` and writing its responses to `responses`.
+    /// Reports the outcome in `context`.
+    virtual void call(uint32_t methodId, MethodType type, PayloadSource& requests, PayloadSink& responses, CallContext& context) = 0;
+};
+
+namespace detail {
+    /// A source of exactly one payload.
+    struct SinglePayload final : PayloadSource {
+        Payload payload;
+        bool taken = false;
+        bool next(Payload& out) override {
+            if (taken) return false;
+            out = std::move(payload);
+            taken = true;
+            return true;
+        }
+    };
+
+    /// Keeps the first payload written to it.
+    struct FirstPayload final : PayloadSink {
+        Payload payload;
+        bool received = false;
+        bool write(Payload&& in) override {
+            if (received) return false;
+            payload = std::move(in);
+            received = true;
+            return true;
+        }
+    };
+
+    /// Encodes the records a `bool(T&)` callable produces until it returns false.
+    template<typename T, typename F> struct CallableSource final : PayloadSource {
+        F& produce;
+        explicit CallableSource(F& f) : produce(f) {}
+        bool next(Payload& out) override {
+            T record;
+            if (!produce(record)) return false;
+            out.clear();
+            T::encodeInto(record, out);
+            return true;
+        }
+    };
+
+    /// Decodes each payload and hands the record to a callable.
+    template<typename T, typename F> struct CallableSink final : PayloadSink {
+        F& consume;
+        bool malformed = false;
+        explicit CallableSink(F& f) : consume(f) {}
+        bool write(Payload&& in) override {
+            T record;
+            if (!T::tryDecodeInto(in, record)) {
+                malformed = true;
+                return false;
+            }
+            consume(static_cast<const T&>(record));
+            return true;
+        }
+    };
+
+    inline void finish(CallContext& context, bool malformed) {
+        if (context.ok() && malformed) context.status = RpcStatus::MalformedPacket;
+    }
+} // namespace detail
+
+// Server side: run a handler against a method's requests and responses.
+
+template<typename Req, typename Resp, typename F>
+void serveUnary(PayloadSource& requests, PayloadSink& responses, CallContext& context, F&& handler) {
+    Req request;
+    StreamReader<Req> reader{requests};
+    if (!reader.next(request)) {
+        context.status = RpcStatus::MalformedPacket;
+        return;
+    }
+    const Resp response = handler(static_cast<const Req&>(request), context);
+    if (context.ok()) StreamWriter<Resp>{responses}.write(response);
+}
+
+template<typename Req, typename Resp, typename F>
+void serveServerStream(PayloadSource& requests, PayloadSink& responses, CallContext& context, F&& handler) {
+    Req request;
+    StreamReader<Req> reader{requests};
+    if (!reader.next(request)) {
+        context.status = RpcStatus::MalformedPacket;
+        return;
+    }
+    StreamWriter<Resp> writer{responses};
+    handler(static_cast<const Req&>(request), writer, context);
+}
+
+template<typename Req, typename Resp, typename F>
+void serveClientStream(PayloadSource& requests, PayloadSink& responses, CallContext& context, F&& handler) {
+    StreamReader<Req> reader{requests};
+    const Resp response = handler(reader, context);
+    detail::finish(context, reader.malformed());
+    if (context.ok()) StreamWriter<Resp>{responses}.write(response);
+}
+
+template<typename Req, typename Resp, typename F>
+void serveDuplexStream(PayloadSource& requests, PayloadSink& responses, CallContext& context, F&& handler) {
+    StreamReader<Req> reader{requests};
+    StreamWriter<Resp> writer{responses};
+    handler(reader, writer, context);
+    detail::finish(context, reader.malformed());
+}
+
+// Client side: encode requests and decode responses around a transport call.
+
+template<typename Req, typename Resp>
+CallContext callUnary(ClientTransport& transport, uint32_t methodId, const Req& request, Resp& response) {
+    CallContext context;
+    context.methodId = methodId;
+    detail::SinglePayload requests;
+    Req::encodeInto(request, requests.payload);
+    detail::FirstPayload responses;
+    transport.call(methodId, MethodType::Unary, requests, responses, context);
+    if (context.ok() && (!responses.received || !Resp::tryDecodeInto(responses.payload, response))) {
+        context.status = RpcStatus::MalformedPacket;
+    }
+    return context;
+}
+
+template<typename Req, typename Resp, typename G>
+CallContext callServerStream(ClientTransport& transport, uint32_t methodId, const Req& request, G&& onResponse) {
+    CallContext context;
+    context.methodId = methodId;
+    detail::SinglePayload requests;
+    Req::encodeInto(request, requests.payload);
+    detail::CallableSink<Resp, G> responses{onResponse};
+    transport.call(methodId, MethodType::ServerStream, requests, responses, context);
+    detail::finish(context, responses.malformed);
+    return context;
+}
+
+template<typename Req, typename Resp, typename F>
+CallContext callClientStream(ClientTransport& transport, uint32_t methodId, F&& nextRequest, Resp& response) {
+    CallContext context;
+    context.methodId = methodId;
+    detail::CallableSource<Req, F> requests{nextRequest};
+    detail::FirstPayload responses;
+    transport.call(methodId, MethodType::ClientStream, requests, responses, context);
+    if (context.ok() && (!responses.received || !Resp::tryDecodeInto(responses.payload, response))) {
+        context.status = RpcStatus::MalformedPacket;
+    }
+    return context;
+}
+
+template<typename Req, typename Resp, typename F, typename G>
+CallContext callDuplexStream(ClientTransport& transport, uint32_t methodId, F&& nextRequest, G&& onResponse) {
+    CallContext context;
+    context.methodId = methodId;
+    detail::CallableSource<Req, F> requests{nextRequest};
+    detail::CallableSink<Resp, G> responses{onResponse};
+    transport.call(methodId, MethodType::DuplexStream, requests, responses, context);
+    detail::finish(context, responses.malformed);
+    return context;
+}
+
+/// Calls a service in the same process, on the calling thread. The service reads the client's
+/// request payloads and writes its response payloads straight back, so each buffer is moved from
+/// encoder to decoder without a copy or a syscall; what remains is the cost of the handler and of
+/// encoding and decoding. Streams interleave: a duplex handler sees each request as soon as the
+/// client produces it.
+class InProcessTransport final : public ClientTransport {
+public:
+    explicit InProcessTransport(Service& service) : m_service(service) {}
+
+    void call(uint32_t methodId, MethodType, PayloadSource& requests, PayloadSink& responses, CallContext& context) override {
+        m_service.dispatch(methodId, requests, responses, context);
+    }
+
+private:
+    Service& m_service;
+};
+
+#if BEBOP_HAS_POSIX_IO
+// Socket transport
+//
+// SocketTransport and SocketServer carry calls over one stream socket, such as
+// a Unix domain socket, with any number of calls in flight at once. Every
+// frame belongs to a call; its opcode slot carries the call id and its
+// payload starts with a 5-byte header:
+//
+//     uint8  flags    the MethodType in bits 0-1, HasRecord (4), End (8)
+//     uint32 word     requests: the method id; the last response: its RpcStatus
+//     ...             the encoded record, or the error text of a failed call
+//
+// A call's requests travel as frames of that call id, the last one flagged
+// End, and its responses come back the same way, so frames of different calls
+// interleave freely and calls complete in whatever order their handlers do.
+// Frames are batched without waiting: a thread that finds another thread
+// already writing leaves its frame for that thread's next write, so under load
+// many small frames share each system call.
+//
+// The server runs unary and server-streaming handlers, whose requests have
+// all arrived, on a fixed pool of workers. Client- and duplex-streaming
+// handlers wait on their requests, so each gets a thread of its own.
+
+namespace detail {
+    namespace rpc {
+        constexpr uint8_t MethodTypeMask = 3;
+        constexpr uint8_t HasRecord = 4;
+        constexpr uint8_t End = 8;
+        constexpr size_t headerSize = 5;
+
+        inline FrameOptions frameOptions() {
+            FrameOptions options;
+            options.opcodes = true;
+            return options;
+        }
+    } // namespace rpc
+
+    /// Send all of `data` on a socket, polling while it is full. Returns 0, or the errno that stopped it.
+    inline int sendAll(int fd, const uint8_t* data, size_t size) {
+#ifdef MSG_NOSIGNAL
+        const int flags = MSG_NOSIGNAL;
+#else
+        const int flags = 0;
+#endif
+        while (size > 0) {
+            const ssize_t n = ::send(fd, data, size, flags);
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                    pollfd writable{fd, POLLOUT, 0};
+                    ::poll(&writable, 1, -1);
+                    continue;
+                }
+                return errno;
+            }
+            data += n;
+            size -= static_cast<size_t>(n);
+        }
+        return 0;
+    }
+
+    inline void ignoreSigpipe(int fd) {
+#ifdef SO_NOSIGPIPE
+        const int on = 1;
+        ::setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &on, sizeof(on));
+#else
+        (void)fd;
+#endif
+    }
+
+    /// Writes call frames to a socket from any number of threads, batching frames that are sent while a write is
+    /// already under way into the next write.
+    class FrameSender {
+        int m_fd;
+        std::mutex m_mutex;
+        std::vector<uint8_t> m_pending;
+        std::vector<uint8_t> m_writing;
+        bool m_flushing = false;
+        int m_error = 0;
+    public:
+        explicit FrameSender(int fd) : m_fd(fd) { ignoreSigpipe(fd); }
+
+        bool send(uint32_t callId, uint8_t flags, uint32_t word, const uint8_t* data, size_t size) {
+            std::unique_lock<std::mutex> lock{m_mutex};
+            if (m_error) return false;
+            Writer writer{m_pending};
+            writer.writeUint32(static_cast<uint32_t>(rpc::headerSize + size));
+            writer.writeUint32(callId);
+            writer.writeByte(flags);
+            writer.writeUint32(word);
+            if (size) writer.writeRaw(data, size);
+            if (m_flushing) return true;
+            m_flushing = true;
+            while (!m_pending.empty() && !m_error) {
+                m_writing.swap(m_pending);
+                lock.unlock();
+                const int error = sendAll(m_fd, m_writing.data(), m_writing.size());
+                m_writing.clear();
+                lock.lock();
+                m_error = error;
+            }
+            m_flushing = false;
+            return m_error == 0;
+        }
+    };
+
+    /// A stream of payloads handed from one thread to another.
+    class PayloadQueue final : public PayloadSource {
+        std::mutex m_mutex;
+        std::condition_variable m_ready;
+        std::deque<Payload> m_payloads;
+        bool m_closed = false;
+    public:
+        /// Queue a payload; dropped once the queue is closed.
+        void push(Payload&& payload) {
+            std::lock_guard<std::mutex> lock{m_mutex};
+            if (m_closed) return;
+            m_payloads.push_back(std::move(payload));
+            m_ready.notify_one();
+        }
+
+        /// End the stream after the payloads already queued.
+        void close() {
+            std::lock_guard<std::mutex> lock{m_mutex};
+            m_closed = true;
+            m_ready.notify_all();
+        }
+
+        /// Wait for the next payload; false once the stream is closed and drained.
+        bool next(Payload& payload) override {
+            std::unique_lock<std::mutex> lock{m_mutex};
+            m_ready.wait(lock, [this] { return !m_payloads.empty() || m_closed; });
+            return take(payload);
+        }
+
+        /// Take the next payload if one has already arrived.
+        bool tryNext(Payload& payload) {
+            std::lock_guard<std::mutex> lock{m_mutex};
+            return take(payload);
+        }
+
+    private:
+        bool take(Payload& payload) {
+            if (m_payloads.empty()) return false;
+            payload = std::move(m_payloads.front());
+            m_payloads.pop_front();
+            return true;
+        }
+    };
+
+    /// Sends a handler's responses. A method with a single response holds it back to travel in the End frame.
+    class ResponseSender final : public PayloadSink {
+        FrameSender& m_sender;
+        uint32_t m_callId;
+        bool m_single;
+        Payload m_last;
+        bool m_held = false;
+    public:
+        ResponseSender(FrameSender& sender, uint32_t callId, MethodType type)
+            : m_sender(sender), m_callId(callId), m_single(type == MethodType::Unary || type == MethodType::ClientStream) {}
+
+        bool write(Payload&& payload) override {
+            if (!m_single) return m_sender.send(m_callId, rpc::HasRecord, 0, payload.data(), payload.size());
+            if (m_held) return false;
+            m_last = std::move(payload);
+            m_held = true;
+            return true;
+        }
+
+        void finish(const CallContext& context) {
+            const auto status = static_cast<uint32_t>(context.status);
+            if (!context.ok()) {
+                m_sender.send(m_callId, rpc::End, status, reinterpret_cast<const uint8_t*>(context.error.data()), context.error.size());
+            } else if (m_held) {
+                m_sender.send(m_callId, rpc::HasRecord | rpc::End, status, m_last.data(), m_last.size());
+            } else {
+                m_sender.send(m_callId, rpc::End, status, nullptr, 0);
+            }
+        }
+    };
+
+    /// A fixed set of threads running queued tasks in order.
+    class WorkerPool {
+        std::mutex m_mutex;
+        std::condition_variable m_ready;
+        std::deque<std::function<void()>> m_tasks;
+        std::vector<std::thread> m_threads;
+        bool m_stopping = false;
+    public:
+        explicit WorkerPool(size_t threads) {
+            for (size_t i = 0; i < threads; i++) m_threads.emplace_back([this] { work(); });
+        }
+        ~WorkerPool() {
+            {
+                std::lock_guard<std::mutex> lock{m_mutex};
+                m_stopping = true;
+                m_ready.notify_all();
+            }
+            for (auto& thread : m_threads) thread.join();
+        }
+
+        void submit(std::function<void()> task) {
+            std::lock_guard<std::mutex> lock{m_mutex};
+            m_tasks.push_back(std::move(task));
+            m_ready.notify_one();
+        }
+
+    private:
+        void work() {
+            std::unique_lock<std::mutex> lock{m_mutex};
+            while (true) {
+                m_ready.wait(lock, [this] { return !m_tasks.empty() || m_stopping; });
+                if (m_tasks.empty()) return;
+                auto task = std::move(m_tasks.front());
+                m_tasks.pop_front();
+                lock.unlock();
+                task();
+                lock.lock();
+            }
+        }
+    };
+
+    /// Threads started one per task, each joined as soon as a later `spawn` finds it finished, so that
+    /// a long-lived owner holds only the threads still running rather than one per task ever started.
+    class ThreadSet {
+        struct Entry {
+            std::thread thread;
+            std::shared_ptr<std::atomic<bool>> done;
+        };
+        std::vector<Entry> m_threads;
+    public:
+        ThreadSet() = default;
+        ThreadSet(ThreadSet const&) = delete;
+        void operator=(ThreadSet const&) = delete;
+        ~ThreadSet() { join(); }
+
+        template<typename Task>
+        void spawn(Task task) {
+            reap();
+            auto done = std::make_shared<std::atomic<bool>>(false);
+            std::thread thread{[task = std::move(task), done]() mutable {
+                task();
+                done->store(true, std::memory_order_release);
+            }};
+            m_threads.push_back(Entry{std::move(thread), std::move(done)});
+        }
+
+        /// Wait for every thread still running.
+        void join() {
+            for (auto& entry : m_threads) entry.thread.join();
+            m_threads.clear();
+        }
+
+    private:
+        void reap() {
+            const auto finished = std::partition(m_threads.begin(), m_threads.end(), [](const Entry& entry) {
+                return !entry.done->load(std::memory_order_acquire);
+            });
+            for (auto it = finished; it != m_threads.end(); ++it) it->thread.join();
+            m_threads.erase(finished, m_threads.end());
+        }
+    };
+} // namespace detail
+
+/// Listen on a Unix domain socket at `path`. Returns the listening descriptor, or -1 with errno set.
+inline int listenUnix(const char* path, int backlog = 128) {
+    sockaddr_un address{};
+    if (strlen(path) >= sizeof(address.sun_path)) {
+        errno = ENAMETOOLONG;
+        return -1;
+    }
+    address.sun_family = AF_UNIX;
+    strcpy(address.sun_path, path);
+    const int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) return -1;
+    if (::bind(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 || ::listen(fd, backlog) != 0) {
+        const int error = errno;
+        ::close(fd);
+        errno = error;
+        return -1;
+    }
+    return fd;
+}
+
+/// Connect to a Unix domain socket at `path`. Returns the connected descriptor, or -1 with errno set.
+inline int connectUnix(const char* path) {
+    sockaddr_un address{};
+    if (strlen(path) >= sizeof(address.sun_path)) {
+        errno = ENAMETOOLONG;
+        return -1;
+    }
+    address.sun_family = AF_UNIX;
+    strcpy(address.sun_path, path);
+    const int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) return -1;
+    if (::connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) {
+        const int error = errno;
+        ::close(fd);
+        errno = error;
+        return -1;
+    }
+    return fd;
+}
+
+/// Makes calls over a connected socket, which it owns. Any number of threads may call at once; their calls are
+/// multiplexed over the socket and each returns as soon as its own responses are in.
+class SocketTransport final : public ClientTransport {
+    struct PendingCall {
+        detail::PayloadQueue responses;
+        RpcStatus status = RpcStatus::Unavailable;
+        std::string error;
+    };
+
+    int m_fd;
+    detail::FrameSender m_sender;
+    std::mutex m_mutex;
+    std::unordered_map<uint32_t, std::shared_ptr<PendingCall>> m_calls;
+    uint32_t m_nextId = 1;
+    bool m_closed = false;
+    std::thread m_receiver;
+public:
+    explicit SocketTransport(int fd) : m_fd(fd), m_sender(fd), m_receiver([this] { receive(); }) {}
+    SocketTransport(SocketTransport const&) = delete;
+    void operator=(SocketTransport const&) = delete;
+    ~SocketTransport() {
+        ::shutdown(m_fd, SHUT_RDWR);
+        m_receiver.join();
+        ::close(m_fd);
+    }
+
+    void call(uint32_t methodId, MethodType type, PayloadSource& requests, PayloadSink& responses, CallContext& context) override {
+        context.methodId = methodId;
+        auto pending = std::make_shared<PendingCall>();
+        uint32_t id;
+        {
+            std::lock_guard<std::mutex> lock{m_mutex};
+            if (m_closed) {
+                context.status = RpcStatus::Unavailable;
+                return;
+            }
+            id = m_nextId++;
+            m_calls.emplace(id, pending);
+        }
+
+        const auto kind = static_cast<uint8_t>(type);
+        Payload payload;
+        bool wanted = true;
+        bool sent;
+        if (type == MethodType::Unary || type == MethodType::ServerStream) {
+            sent = requests.next(payload)
+                ? m_sender.send(id, kind | detail::rpc::HasRecord | detail::rpc::End, methodId, payload.data(), payload.size())
+                : m_sender.send(id, kind | detail::rpc::End, methodId, nullptr, 0);
+        } else {
+            sent = true;
+            while (sent && requests.next(payload)) {
+                sent = m_sender.send(id, kind | detail::rpc::HasRecord, methodId, payload.data(), payload.size());
+                // Hand over what has arrived so far, so a duplex caller can react to it.
+                while (pending->responses.tryNext(payload)) wanted = wanted && responses.write(std::move(payload));
+            }
+            sent = sent && m_sender.send(id, kind | detail::rpc::End, methodId, nullptr, 0);
+        }
+        if (!sent) {
+            std::lock_guard<std::mutex> lock{m_mutex};
+            m_calls.erase(id);
+            pending->responses.close();
+        }
+
+        while (pending->responses.next(payload)) wanted = wanted && responses.write(std::move(payload));
+        context.status = sent ? pending->status : RpcStatus::Unavailable;
+        context.error = std::move(pending->error);
+    }
+
+private:
+    void receive() {
+        FrameReader reader{m_fd, detail::rpc::frameOptions()};
+        Frame frame;
+        while (reader.next(frame) == FrameStatus::Ok && frame.size >= detail::rpc::headerSize) {
+            Reader header{frame.data, detail::rpc::headerSize};
+            const uint8_t flags = header.readByte();
+            const uint32_t word = header.readUint32();
+            const uint8_t* record = frame.data + detail::rpc::headerSize;
+            const size_t size = frame.size - detail::rpc::headerSize;
+
+            std::shared_ptr<PendingCall> pending;
+            {
+                std::lock_guard<std::mutex> lock{m_mutex};
+                const auto it = m_calls.find(frame.opcode);
+                if (it == m_calls.end()) continue;
+                pending = it->second;
+                if (flags & detail::rpc::End) m_calls.erase(it);
+            }
+            if (flags & detail::rpc::End) {
+                pending->status = static_cast<RpcStatus>(word);
+                if (!(flags & detail::rpc::HasRecord)) pending->error.assign(reinterpret_cast<const char*>(record), size);
+            }
+            if (flags & detail::rpc::HasRecord) pending->responses.push(Payload(record, record + size));
+            if (flags & detail::rpc::End) pending->responses.close();
+        }
+
+        std::lock_guard<std::mutex> lock{m_mutex};
+        m_closed = true;
+        for (auto& call : m_calls) call.second->responses.close();
+        m_calls.clear();
+    }
+};
+
+/// Serves a Service's calls over stream sockets, many calls per connection at once.
+class SocketServer {
+    Service& m_service;
+    detail::WorkerPool m_workers;
+    std::mutex m_mutex;
+    std::vector<int> m_connections;
+    bool m_stopping = false;
+    int m_listener = -1;
+public:
+    /// Run unary and server-streaming handlers on `workers` threads (by default, one per core).
+    explicit SocketServer(Service& service, size_t workers = 0)
+        : m_service(service), m_workers(workers ? workers : std::max(1u, std::thread::hardware_concurrency())) {}
+    SocketServer(SocketServer const&) = delete;
+    void operator=(SocketServer const&) = delete;
+
+    /// Accept connections on a listening socket and serve each on a thread of its own, until `stop`.
+    void run(int listener) {
+        {
+            std::lock_guard<std::mutex> lock{m_mutex};
+            if (m_stopping) return;
+            m_listener = listener;
+        }
+        detail::ThreadSet connections;
+        while (true) {
+            const int fd = ::accept(listener, nullptr, nullptr);
+            if (fd < 0) {
+                if (errno == EINTR || errno == ECONNABORTED) continue;
+                break;
+            }
+            connections.spawn([this, fd] { serve(fd); });
+        }
+        connections.join();
+    }
+
+    /// Serve calls on a connected socket until the peer closes it, then close it.
+    void serve(int fd) {
+        {
+            std::lock_guard<std::mutex> lock{m_mutex};
+            if (m_stopping) {
+                ::close(fd);
+                return;
+            }
+            m_connections.push_back(fd);
+        }
+
+        struct Call {
+            uint32_t id;
+            uint32_t methodId;
+            MethodType type;
+            detail::PayloadQueue requests;
+        };
+        detail::FrameSender sender{fd};
+        std::mutex mutex;
+        std::condition_variable idle;
+        size_t running = 0;
+        const auto start = [&](const std::shared_ptr<Call>& call) {
+            CallContext context;
+            detail::ResponseSender responses{sender, call->id, call->type};
+            m_service.dispatch(call->methodId, call->requests, responses, context);
+            call->requests.close();
+            responses.finish(context);
+            std::lock_guard<std::mutex> lock{mutex};
+            running--;
+            idle.notify_all();
+        };
+
+        // Client-streaming and duplex calls block on their requests, so each gets a thread of its own
+        // instead of holding a worker; all of them are joined before this connection is closed.
+        detail::ThreadSet streams;
+        std::unordered_map<uint32_t, std::shared_ptr<Call>> open;
+        FrameReader reader{fd, detail::rpc::frameOptions()};
+        Frame frame;
+        while (reader.next(frame) == FrameStatus::Ok && frame.size >= detail::rpc::headerSize) {
+            Reader header{frame.data, detail::rpc::headerSize};
+            const uint8_t flags = header.readByte();
+            const uint32_t methodId = header.readUint32();
+            const uint8_t* record = frame.data + detail::rpc::headerSize;
+
+            auto it = open.find(frame.opcode);
+            const bool isNew = it == open.end();
+            if (isNew) {
+                auto call = std::make_shared<Call>();
+                call->id = frame.opcode;
+                call->methodId = methodId;
+                call->type = static_cast<MethodType>(flags & detail::rpc::MethodTypeMask);
+                it = open.emplace(frame.opcode, std::move(call)).first;
+            }
+            const auto call = it->second;
+            if (flags & detail::rpc::HasRecord) call->requests.push(Payload(record, frame.data + frame.size));
+            if (flags & detail::rpc::End) {
+                call->requests.close();
+                open.erase(it);
+            }
+            if (isNew) {
+                {
+                    std::lock_guard<std::mutex> lock{mutex};
+                    running++;
+                }
+                if (flags & detail::rpc::End) {
+                    m_workers.submit([start, call] { start(call); });
+                } else {
+                    streams.spawn([start, call] { start(call); });
+                }
+            }
+        }
+
+        for (auto& call : open) call.second->requests.close();
+        {
+            std::unique_lock<std::mutex> lock{mutex};
+            idle.wait(lock, [&] { return running == 0; });
+        }
+        streams.join();
+        {
+            std::lock_guard<std::mutex> lock{m_mutex};
+            m_connections.erase(std::find(m_connections.begin(), m_connections.end(), fd));
+        }
+        ::close(fd);
+    }
+
+    /// Stop accepting connections and end every connection being served. Calls already running still finish.
+    void stop() {
+        std::lock_guard<std::mutex> lock{m_mutex};
+        m_stopping = true;
+        if (m_listener >= 0) ::shutdown(m_listener, SHUT_RDWR);
+        for (int fd : m_connections) ::shutdown(fd, SHUT_RDWR);
+    }
 };
+#endif
 
 static_assert(sizeof(uint8_t) == 1, "sizeof(uint8_t) should be 1");
 static_assert(sizeof(uint16_t) == 2, "sizeof(uint16_t) should be 2");
@@ -482,3 +3568,21 @@ static_assert(sizeof(double) == 8, "sizeof(double) should be 8");
 static_assert(sizeof(Guid) == 16, "sizeof(Guid) should be 16");
 
 } // namespace bebop
+
+/// Guids hash by mixing all 16 bytes, so that unordered maps keyed by sequential or random
+/// Guids spread evenly either way.
+namespace std {
+template<> struct hash<bebop::Guid> {
+    size_t operator()(const bebop::Guid& guid) const noexcept {
+        uint64_t halves[2];
+        memcpy(halves, &guid, sizeof(halves));
+        uint64_t h = halves[0] ^ (halves[1] * 0x9e3779b97f4a7c15ull);
+        h ^= h >> 33;
+        h *= 0xff51afd7ed558ccdull;
+        h ^= h >> 33;
+        h *= 0xc4ceb9fe1a85ec53ull;
+        h ^= h >> 33;
+        return static_cast<size_t>(h);
+    }
+};
+} // namespace std
@@ -1,10 +1,15 @@
 #include <iostream>
+#include <string>
 #include "../src/bebop.hpp"
 #include <cmath>
 #include <chrono>
 #include <cstddef>
 #include <cstdint>
 #include <cstdio>
+#if BEBOP_HAS_POSIX_IO
+#include <fcntl.h>
+#include <sys/socket.h>
+#endif
 
 int main() {
     std::vector<uint8_t> buffer;
@@ -25,6 +30,157 @@ int main() {
     std::cout << "byte roundtrip: " << (r.readByte() == 255 ? "ok" : "fail") << std::endl;
     std::cout << "date roundtrip: " << (r.readDate().count() == 123456789 ? "ok" : "fail") << std::endl;
 
+    std::string text;
+    bebop::StringWriter sw { text };
+    sw.writeString("hello");
+    size_t q = sw.reserveMessageLength();
+    sw.fillMessageLength(q, 0x1234);
+    bebop::Reader sr { reinterpret_cast<const uint8_t*>(text.data()), text.size() };
+    std::cout << "string sink roundtrip: " << (sr.readString() == "hello" && sr.readUint32() == 0x1234 ? "ok" : "fail") << std::endl;
+
+    std::vector<uint8_t> spans;
+    bebop::Writer spw { spans };
+    const char chars[] = "span string";
+    const uint8_t bytes[] = { 1, 2, 3 };
+    const std::vector<float> floats = { 1.5f, -2.25f };
+    const std::vector<bool> bools = { true, false, true };
+    const bebop::TickDuration dates[] = { bebop::TickDuration(1), bebop::TickDuration(-2) };
+    spw.writeString(chars, 4);
+    spw.writeBytes(bytes, sizeof(bytes));
+    spw.writeScalarArray(floats);
+    spw.writeScalarArray(bools);
+    spw.writeScalarArray(dates, 2);
+    bebop::ByteCounter spc;
+    spc.writeString(chars, 4);
+    spc.writeBytes(bytes, sizeof(bytes));
+    spc.writeScalarArray(floats);
+    spc.writeScalarArray(bools);
+    spc.writeScalarArray(dates, 2);
+    bebop::Reader spr { spans.data(), spans.size() };
+    std::vector<float> floatsBack;
+    std::vector<bool> boolsBack;
+    std::vector<bebop::TickDuration> datesBack;
+    const bool spanStrings = spr.readString() == "span" && spr.readBytes() == std::vector<uint8_t>(bytes, bytes + 3);
+    spr.readScalarArray(floatsBack);
+    spr.readScalarArray(boolsBack);
+    spr.readScalarArray(datesBack);
+    std::cout << "span writes: " << (spanStrings && floatsBack == floats && boolsBack == bools && datesBack.size() == 2 && datesBack[1] == dates[1] && spc.length() == spans.size() ? "ok" : "fail") << std::endl;
+
+    uint8_t region[16];
+    bebop::FixedBufferWriter fw { bebop::FixedBufferSink { region, sizeof(region) } };
+    fw.writeUint64(0x0102030405060708);
+    fw.writeInt32(-7);
+    bebop::Reader fr { region, fw.length() };
+    std::cout << "fixed sink roundtrip: " << (fr.readUint64() == 0x0102030405060708 && fr.readInt32() == -7 ? "ok" : "fail") << std::endl;
+    bool overflowed = false;
+    try {
+        fw.writeUint64(0);
+    } catch (bebop::BufferOverflowException& e) {
+        overflowed = true;
+    }
+    std::cout << "fixed sink overflow: " << (overflowed && fw.length() == 12 ? "ok" : "fail") << std::endl;
+
+    bebop::ByteBuffer byteBuffer;
+    bebop::ByteBufferWriter bw { byteBuffer };
+    for (uint32_t i = 0; i < 100; i++) {
+        bw.writeUint32(i);
+        bw.writeString("grow");
+    }
+    bebop::Reader br { byteBuffer.data(), byteBuffer.size() };
+    bool byteBufferOk = byteBuffer.size() == 100 * 12 && byteBuffer.toVector() == std::vector<uint8_t>(byteBuffer.begin(), byteBuffer.end());
+    for (uint32_t i = 0; i < 100; i++) byteBufferOk = byteBufferOk && br.readUint32() == i && br.readString() == "grow";
+    const auto released = byteBuffer.release();
+    byteBufferOk = byteBufferOk && released.second == 100 * 12 && byteBuffer.empty() && byteBuffer.capacity() == 0;
+    std::free(released.first);
+    std::cout << "byte buffer sink roundtrip: " << (byteBufferOk ? "ok" : "fail") << std::endl;
+
+    bebop::BufferPoolOptions poolOptions;
+    poolOptions.buffersPerThread = 1;
+    poolOptions.overflowBuffers = 1;
+    bebop::BufferPool pool { poolOptions };
+    const uint8_t* pooled;
+    {
+        auto lease = pool.lease(100);
+        bebop::Writer lw { *lease };
+        lw.writeString("pooled");
+        pooled = lease.data();
+        bebop::Reader lr { lease.data(), lease.size() };
+        if (lr.readString() != "pooled") return 1;
+    }
+    bool poolOk = pool.stats().bytesCached >= 256;
+    {
+        auto a = pool.lease(10), b = pool.lease(10), c = pool.lease(10);
+        poolOk = poolOk && a.data() == pooled && a.size() == 0 && b->capacity() >= 256;
+    }
+    // Of the three, one stays with this thread, one goes to the overflow list and one is freed.
+    const auto poolStats = pool.stats();
+    poolOk = poolOk && poolStats.leases == 4 && poolStats.threadHits == 1 && poolStats.misses == 3 && poolStats.dropped == 1 && poolStats.buffersCached == 2;
+    std::cout << "buffer pool reuse: " << (poolOk ? "ok" : "fail") << std::endl;
+
+#if BEBOP_HAS_MEMORY_RESOURCE
+    uint8_t arena[256];
+    std::pmr::monotonic_buffer_resource resource { arena, sizeof(arena) };
+    std::pmr::vector<uint8_t> pmrBuffer { &resource };
+    bebop::PmrVectorWriter pw { pmrBuffer };
+    pw.writeGuid(bebop::Guid::fromString(myGuid));
+    bebop::Reader pr { pmrBuffer.data(), pmrBuffer.size() };
+    std::cout << "pmr sink roundtrip: " << (pr.readGuid().toString() == myGuid ? "ok" : "fail") << std::endl;
+#endif
+
+    const uint8_t truncated[] = { 0x05, 0x00, 0x00, 0x00, 'h', 'i' };
+    bebop::Reader tr { truncated, sizeof(truncated), bebop::ErrorMode::Status };
+    const bool readZero = tr.readString().empty();
+    std::cout << "status reader: " << (readZero && tr.failed() && tr.readByte() == 0 && tr.bytesRemaining() == 0 ? "ok" : "fail") << std::endl;
+
+    std::vector<uint8_t> framed;
+    {
+        bebop::FrameOptions withOpcodes;
+        withOpcodes.opcodes = true;
+        bebop::FrameWriter fwr { framed, withOpcodes };
+        fwr.writeFrame(0x5a5a4a41, reinterpret_cast<const uint8_t*>("hello"), 5);
+        fwr.writeFrame(7, nullptr, 0);
+        framed.push_back(9);
+        bebop::FrameReader frd { framed.data(), framed.size(), withOpcodes };
+        bebop::Frame a, b, c;
+        const bool split = frd.next(a) == bebop::FrameStatus::Ok && frd.next(b) == bebop::FrameStatus::Ok && frd.next(c) == bebop::FrameStatus::NeedMore;
+        std::cout << "buffer frames: " << (split && a.opcode == 0x5a5a4a41 && a.size == 5 && a.data == framed.data() + 8 && b.opcode == 7 && b.size == 0 && frd.bytesConsumed() == framed.size() - 1 ? "ok" : "fail") << std::endl;
+    }
+
+#if BEBOP_HAS_POSIX_IO
+    int fds[2];
+    for (const bool useSocket : { false, true }) {
+        if (useSocket ? socketpair(AF_UNIX, SOCK_STREAM, 0, fds) != 0 : pipe(fds) != 0) return 1;
+        fcntl(fds[0], F_SETFL, O_NONBLOCK);
+        bebop::FrameOptions coalesce;
+        coalesce.flushDelay = std::chrono::seconds(60);
+        coalesce.flushBytes = 1024;
+        coalesce.receiveBufferSize = 16;
+        bebop::FrameReader frd { fds[0], coalesce };
+        bebop::Frame frame;
+        bool ok = true;
+        {
+            bebop::FrameWriter fwr { fds[1], coalesce };
+            const std::string payload(100, 'x');
+            for (int i = 0; i < 5; i++) fwr.writeFrame(0, reinterpret_cast<const uint8_t*>(payload.data()), payload.size());
+            // Frames wait for the deadline, or for a full batch.
+            ok = ok && frd.next(frame) == bebop::FrameStatus::NeedMore && fwr.bytesBuffered() == 520 && fwr.flushIfDue();
+            for (int i = 0; i < 5; i++) fwr.writeFrame(0, reinterpret_cast<const uint8_t*>(payload.data()), payload.size());
+            ok = ok && fwr.bytesBuffered() == 0;
+            for (int i = 0; i < 10; i++) ok = ok && frd.next(frame) == bebop::FrameStatus::Ok && frame.size == 100 && frame.data[99] == 'x';
+            ok = ok && frd.next(frame) == bebop::FrameStatus::NeedMore;
+            // A large payload bypasses the batch.
+            const std::string large(4096, 'y');
+            fwr.writeFrame(0, reinterpret_cast<const uint8_t*>(large.data()), large.size());
+            ok = ok && frd.next(frame) == bebop::FrameStatus::Ok && frame.size == large.size() && frame.data[4095] == 'y';
+            fwr.writeFrame(0, reinterpret_cast<const uint8_t*>("bye"), 3);
+        }
+        close(fds[1]);
+        ok = ok && frd.next(frame) == bebop::FrameStatus::Ok && frame.size == 3 && frd.next(frame) == bebop::FrameStatus::End;
+        close(fds[0]);
+        std::cout << (useSocket ? "socket frames: " : "pipe frames: ") << (ok ? "ok" : "fail") << std::endl;
+    }
+#endif
+
     std::cout << "packet dump:";
     for (const auto x : buffer) {
         printf(" %02x", x);
@@ -10,12 +10,13 @@ static bebop_arena_block_t *arena_allocate_block(const bebop_arena_t *arena,
   size_t capacity = arena->options.initial_block_size;
   size_t required = align_size(min_size, BEBOP_ARENA_DEFAULT_ALIGNMENT);
 
-  if (required > arena->options.max_block_size) 
-    return NULL;
   if (capacity < required) 
     capacity = required;
-  if (capacity > arena->options.max_block_size) 
-    capacity = arena->options.max_block_size;
+  // Oversized requests get a block of exactly their size
+  if (capacity > arena->options.max_block_size)
+    capacity = required > arena->options.max_block_size
+                   ? required
+                   : arena->options.max_block_size;
 
   size_t total_size = sizeof(bebop_arena_block_t) + capacity;
 
@@ -31,6 +32,31 @@ static bebop_arena_block_t *arena_allocate_block(const bebop_arena_t *arena,
   return block;
 }
 
+// Pops the next retained block if it can hold `size` bytes. Retained blocks
+// are only pushed by bebop_arena_reset, which never runs concurrently with
+// allocation, so popping cannot suffer from ABA.
+static bebop_arena_block_t *arena_take_retained(bebop_arena_shard_t *shard,
+                                                size_t size) {
+  bebop_arena_block_t *head = bebop_atomic_load(&shard->retained_blocks);
+  while (head && head->capacity >= size) {
+    if (bebop_atomic_compare_exchange_weak(&shard->retained_blocks, &head,
+                                           head->next)) {
+      head->next = NULL;
+      return head;
+    }
+  }
+  return NULL;
+}
+
+static void arena_free_blocks(bebop_arena_t *arena,
+                              bebop_arena_block_t *block) {
+  while (block) {
+    bebop_arena_block_t *next = block->next;
+    arena->free_func(block);
+    block = next;
+  }
+}
+
 static bebop_arena_t *bebop_arena_create_with_options(
     const bebop_arena_options_t *options) {
   if (!options) return NULL;
@@ -44,9 +70,32 @@ static bebop_arena_t *bebop_arena_create_with_options(
   arena->malloc_func = malloc_func;
   arena->free_func =
       options->allocator.free_func ? options->allocator.free_func : free;
-  bebop_atomic_init(&arena->current_block, NULL);
-  bebop_atomic_init(&arena->total_allocated, 0);
-  bebop_atomic_init(&arena->total_used, 0);
+
+  arena->shard_count = 1;
+  if (options->mode == BEBOP_ARENA_SHARDED) {
+    arena->shard_count = options->shard_count ? options->shard_count
+                                              : BEBOP_ARENA_DEFAULT_SHARDS;
+  }
+  // Shards are cache-line aligned so threads never share a line
+  arena->shard_storage = malloc_func(
+      arena->shard_count * sizeof(bebop_arena_shard_t) + BEBOP_CACHE_LINE_SIZE);
+  if (!arena->shard_storage) {
+    arena->free_func(arena);
+    return NULL;
+  }
+  arena->shards = (bebop_arena_shard_t *)align_size(
+      (size_t)arena->shard_storage, BEBOP_CACHE_LINE_SIZE);
+  for (uint32_t i = 0; i < arena->shard_count; i++) {
+    bebop_arena_shard_t *shard = &arena->shards[i];
+    bebop_atomic_init(&shard->current_block, NULL);
+    bebop_atomic_init(&shard->retained_blocks, NULL);
+    bebop_atomic_init(&shard->spare_block, NULL);
+    bebop_atomic_init(&shard->released_buffer, NULL);
+    bebop_atomic_init(&shard->total_allocated, 0);
+    bebop_atomic_init(&shard->total_used, 0);
+  }
+  memset(arena->cycle_bytes, 0, sizeof(arena->cycle_bytes));
+  arena->reset_count = 0;
 
   return arena;
 }
@@ -54,65 +103,212 @@ static bebop_arena_t *bebop_arena_create_with_options(
 static void bebop_arena_destroy(bebop_arena_t *arena) {
   if (!arena) return;
 
-  bebop_arena_block_t *block = bebop_atomic_load(&arena->current_block);
-  while (block) {
-    bebop_arena_block_t *next = block->next;
-    arena->free_func(block);
-    block = next;
+  for (uint32_t i = 0; i < arena->shard_count; i++) {
+    bebop_arena_shard_t *shard = &arena->shards[i];
+    arena_free_blocks(arena, bebop_atomic_load(&shard->current_block));
+    arena_free_blocks(arena, bebop_atomic_load(&shard->retained_blocks));
+    arena_free_blocks(arena, bebop_atomic_load(&shard->spare_block));
   }
 
+  arena->free_func(arena->shard_storage);
   arena->free_func(arena);
 }
 
+// Largest number of bytes the trim policy allows to survive this reset
+static size_t arena_retain_budget(bebop_arena_t *arena, size_t cycle_bytes) {
+  arena->cycle_bytes[arena->reset_count % BEBOP_ARENA_RETAIN_HISTORY] =
+      cycle_bytes;
+  arena->reset_count++;
+
+  size_t budget = arena->options.retain_max_bytes;
+  uint32_t window = arena->options.retain_resets;
+  if (window == 0) return budget;
+  if (window > BEBOP_ARENA_RETAIN_HISTORY) window = BEBOP_ARENA_RETAIN_HISTORY;
+  if (window > arena->reset_count) window = arena->reset_count;
+
+  size_t high_water = 0;
+  for (uint32_t i = 1; i <= window; i++) {
+    size_t bytes = arena->cycle_bytes[(arena->reset_count - i) %
+                                      BEBOP_ARENA_RETAIN_HISTORY];
+    if (bytes > high_water) high_water = bytes;
+  }
+  return high_water < budget ? high_water : budget;
+}
+
 static void bebop_arena_reset(bebop_arena_t *arena) {
   if (!arena) return;
 
-  bebop_arena_block_t *block = bebop_atomic_load(&arena->current_block);
-  while (block) {
-    bebop_arena_block_t *next = block->next;
-    arena->free_func(block);
-    block = next;
+  size_t cycle_bytes = 0;
+  for (uint32_t i = 0; i < arena->shard_count; i++) {
+    bebop_arena_block_t *block =
+        bebop_atomic_load(&arena->shards[i].current_block);
+    for (; block; block = block->next) {
+      cycle_bytes += sizeof(bebop_arena_block_t) + block->capacity;
+    }
   }
+  size_t budget = arena_retain_budget(arena, cycle_bytes);
+  size_t retained = 0;
+
+  for (uint32_t i = 0; i < arena->shard_count; i++) {
+    bebop_arena_shard_t *shard = &arena->shards[i];
+
+    // The block chain is newest-first; reverse it so the next cycle gets its
+    // blocks back in the order it asked for them. Blocks retained earlier but
+    // not needed this cycle go after those.
+    bebop_arena_block_t *ordered = bebop_atomic_load(&shard->retained_blocks);
+    bebop_arena_block_t *block = bebop_atomic_load(&shard->spare_block);
+    if (block) {
+      block->next = ordered;
+      ordered = block;
+    }
+    block = bebop_atomic_load(&shard->current_block);
+    while (block) {
+      bebop_arena_block_t *next = block->next;
+      block->next = ordered;
+      ordered = block;
+      block = next;
+    }
 
-  bebop_atomic_store(&arena->current_block, NULL);
-  bebop_atomic_store(&arena->total_allocated, 0);
-  bebop_atomic_store(&arena->total_used, 0);
+    size_t shard_retained = 0;
+    bebop_arena_block_t *head = NULL;
+    bebop_arena_block_t **tail = &head;
+    for (block = ordered; block;) {
+      bebop_arena_block_t *next = block->next;
+      size_t block_bytes = sizeof(bebop_arena_block_t) + block->capacity;
+      if (retained + block_bytes <= budget) {
+        bebop_atomic_store(&block->used, 0);
+        retained += block_bytes;
+        shard_retained += block_bytes;
+        *tail = block;
+        tail = &block->next;
+      } else {
+        arena->free_func(block);
+      }
+      block = next;
+    }
+    *tail = NULL;
+
+    bebop_atomic_store(&shard->retained_blocks, head);
+    bebop_atomic_store(&shard->current_block, NULL);
+    bebop_atomic_store(&shard->spare_block, NULL);
+    bebop_atomic_store(&shard->released_buffer, NULL);
+    bebop_atomic_store(&shard->total_allocated, shard_retained);
+    bebop_atomic_store(&shard->total_used, 0);
+  }
 }
 
-// Arena allocation functions
-void *bebop_arena_alloc(bebop_arena_t *arena, size_t size) {
-  if (!arena || size == 0) return NULL;
+// Shard for the calling thread. Threads get consecutive slots on first use,
+// so up to shard_count threads each own a shard outright.
+static bebop_arena_shard_t *arena_thread_shard(bebop_arena_t *arena) {
+#ifdef BEBOP_SINGLE_THREADED
+  return &arena->shards[0];
+#else
+  static _Atomic uint32_t next_slot = 0;
+  static _Thread_local uint32_t slot = 0;
+  if (BEBOP_UNLIKELY(slot == 0)) slot = atomic_fetch_add(&next_slot, 1) + 1;
+  return &arena->shards[(slot - 1) % arena->shard_count];
+#endif
+}
 
-  size_t aligned_size = align_size(size, BEBOP_ARENA_DEFAULT_ALIGNMENT);
+static void *arena_alloc_unsynchronized(bebop_arena_t *arena,
+                                        bebop_arena_shard_t *shard,
+                                        size_t size) {
+  bebop_arena_block_t *current =
+      bebop_atomic_load_relaxed(&shard->current_block);
+
+  if (!current ||
+      bebop_atomic_load_relaxed(&current->used) + size > current->capacity) {
+    bebop_arena_block_t *head =
+        bebop_atomic_load_relaxed(&shard->retained_blocks);
+    bebop_arena_block_t *new_block = NULL;
+    if (head && head->capacity >= size) {
+      bebop_atomic_store_relaxed(&shard->retained_blocks, head->next);
+      new_block = head;
+    } else {
+      new_block = arena_allocate_block(arena, size);
+      if (!new_block) return NULL;
+      bebop_atomic_store_relaxed(
+          &shard->total_allocated,
+          bebop_atomic_load_relaxed(&shard->total_allocated) +
+              sizeof(bebop_arena_block_t) + new_block->capacity);
+    }
+    new_block->next = current;
+    bebop_atomic_store_relaxed(&shard->current_block, new_block);
+    current = new_block;
+  }
 
+  size_t used = bebop_atomic_load_relaxed(&current->used);
+  bebop_atomic_store_relaxed(&current->used, used + size);
+  bebop_atomic_store_relaxed(
+      &shard->total_used, bebop_atomic_load_relaxed(&shard->total_used) + size);
+  return (uint8_t *)(current + 1) + used;
+}
+
+static void *arena_alloc_lock_free(bebop_arena_t *arena,
+                                   bebop_arena_shard_t *shard, size_t size) {
   while (true) {
-    bebop_arena_block_t *current = bebop_atomic_load(&arena->current_block);
+    bebop_arena_block_t *current = bebop_atomic_load(&shard->current_block);
 
     if (!current ||
-        bebop_atomic_load(&current->used) + aligned_size > current->capacity) {
-      bebop_arena_block_t *new_block =
-          arena_allocate_block(arena, aligned_size);
-      if (!new_block) return NULL;
+        bebop_atomic_load(&current->used) + size > current->capacity) {
+      bebop_arena_block_t *new_block = arena_take_retained(shard, size);
+      if (new_block) {
+        // A retained block cannot go back on the retained list, so install it
+        // even if another thread replaced the current block meanwhile.
+        do {
+          new_block->next = current;
+        } while (!bebop_atomic_compare_exchange_weak(&shard->current_block,
+                                                     &current, new_block));
+        continue;
+      }
+
+      // Reuse the block a thread allocated but lost the race to install
+      new_block = bebop_atomic_load(&shard->spare_block);
+      if (new_block && !bebop_atomic_compare_exchange_weak(
+                           &shard->spare_block, &new_block, NULL)) {
+        new_block = NULL;
+      }
+      if (new_block && new_block->capacity < size) {
+        bebop_atomic_fetch_add(
+            &shard->total_allocated,
+            -(sizeof(bebop_arena_block_t) + new_block->capacity));
+        arena->free_func(new_block);
+        new_block = NULL;
+      }
+      if (!new_block) {
+        new_block = arena_allocate_block(arena, size);
+        if (!new_block) return NULL;
+        bebop_atomic_fetch_add(
+            &shard->total_allocated,
+            sizeof(bebop_arena_block_t) + new_block->capacity);
+      }
 
       new_block->next = current;
 
-      if (bebop_atomic_compare_exchange_weak(&arena->current_block, &current,
+      if (bebop_atomic_compare_exchange_weak(&shard->current_block, &current,
                                              new_block)) {
         current = new_block;
-        bebop_atomic_fetch_add(
-            &arena->total_allocated,
-            sizeof(bebop_arena_block_t) + new_block->capacity);
       } else {
-        arena->free_func(new_block);
+        // Another thread installed a block first. Keep ours for the next
+        // refill rather than handing it straight back to the allocator.
+        bebop_arena_block_t *empty = NULL;
+        new_block->next = NULL;
+        if (!bebop_atomic_compare_exchange_weak(&shard->spare_block, &empty,
+                                                new_block)) {
+          bebop_atomic_fetch_add(
+              &shard->total_allocated,
+              -(sizeof(bebop_arena_block_t) + new_block->capacity));
+          arena->free_func(new_block);
+        }
         continue;
       }
     }
 
     size_t old_used = bebop_atomic_load(&current->used);
-    if (old_used + aligned_size <= current->capacity) {
+    if (old_used + size <= current->capacity) {
       if (bebop_atomic_compare_exchange_weak(&current->used, &old_used,
-                                             old_used + aligned_size)) {
-        bebop_atomic_fetch_add(&arena->total_used, aligned_size);
+                                             old_used + size)) {
+        bebop_atomic_fetch_add(&shard->total_used, size);
         return (uint8_t *)(current + 1) + old_used;
       }
     } else {
@@ -121,6 +317,156 @@ void *bebop_arena_alloc(bebop_arena_t *arena, size_t size) {
   }
 }
 
+// Arena allocation functions
+void *bebop_arena_alloc(bebop_arena_t *arena, size_t size) {
+  if (!arena || size == 0) return NULL;
+
+  size_t aligned_size = align_size(size, BEBOP_ARENA_DEFAULT_ALIGNMENT);
+
+  switch (arena->options.mode) {
+    case BEBOP_ARENA_UNSYNCHRONIZED:
+      return arena_alloc_unsynchronized(arena, &arena->shards[0], aligned_size);
+    case BEBOP_ARENA_SHARDED:
+      return arena_alloc_lock_free(arena, arena_thread_shard(arena),
+                                   aligned_size);
+    default:
+      return arena_alloc_lock_free(arena, &arena->shards[0], aligned_size);
+  }
+}
+
+static bebop_arena_shard_t *arena_shard(bebop_arena_t *arena) {
+  return arena->options.mode == BEBOP_ARENA_SHARDED ? arena_thread_shard(arena)
+                                                    : &arena->shards[0];
+}
+
+// Grows `ptr` from `old_size` to `new_size` bytes if it is the most recent
+// allocation in the calling thread's current block and the block has room.
+static bool arena_try_extend(bebop_arena_t *arena, uint8_t *ptr,
+                             size_t old_size, size_t new_size) {
+  bebop_arena_shard_t *shard = arena_shard(arena);
+  bebop_arena_block_t *block = bebop_atomic_load(&shard->current_block);
+  if (!block) return false;
+
+  uintptr_t data = (uintptr_t)(block + 1);
+  if ((uintptr_t)ptr < data || (uintptr_t)ptr >= data + block->capacity)
+    return false;
+  size_t offset = (size_t)((uintptr_t)ptr - data);
+  size_t old_end = offset + align_size(old_size, BEBOP_ARENA_DEFAULT_ALIGNMENT);
+  size_t new_end = offset + align_size(new_size, BEBOP_ARENA_DEFAULT_ALIGNMENT);
+  if (new_end > block->capacity) return false;
+
+  if (arena->options.mode == BEBOP_ARENA_UNSYNCHRONIZED) {
+    if (bebop_atomic_load_relaxed(&block->used) != old_end) return false;
+    bebop_atomic_store_relaxed(&block->used, new_end);
+    bebop_atomic_store_relaxed(
+        &shard->total_used,
+        bebop_atomic_load_relaxed(&shard->total_used) + (new_end - old_end));
+    return true;
+  }
+
+  size_t expected = old_end;
+  if (!bebop_atomic_compare_exchange_weak(&block->used, &expected, new_end))
+    return false;
+  bebop_atomic_fetch_add(&shard->total_used, new_end - old_end);
+  return true;
+}
+
+// Parks a buffer whose first word holds its size, keeping the larger of it
+// and any buffer already parked. Buffers are claimed with a CAS before their
+// size is read, so a parked buffer is never touched by two threads.
+static void arena_park(bebop_arena_shard_t *shard, uint8_t *buffer) {
+  uint8_t *parked = bebop_atomic_load(&shard->released_buffer);
+  while (parked && !bebop_atomic_compare_exchange_weak(&shard->released_buffer,
+                                                       &parked, NULL)) {
+  }
+  if (parked) {
+    size_t size, parked_size;
+    memcpy(&size, buffer, sizeof(size_t));
+    memcpy(&parked_size, parked, sizeof(size_t));
+    if (parked_size > size) buffer = parked;
+  }
+
+  uint8_t *empty = NULL;
+  while (!bebop_atomic_compare_exchange_weak(&shard->released_buffer, &empty,
+                                             buffer) &&
+         !empty) {
+  }
+}
+
+// Hands back a buffer that is no longer needed. The most recent allocation
+// in the current block is rolled back; anything else is parked so the next
+// writer buffer it can hold reuses it. Parked buffers are dropped on reset.
+static void arena_release(bebop_arena_t *arena, uint8_t *ptr, size_t size) {
+  bebop_arena_shard_t *shard = arena_shard(arena);
+  size = align_size(size, BEBOP_ARENA_DEFAULT_ALIGNMENT);
+
+  bebop_arena_block_t *block = bebop_atomic_load(&shard->current_block);
+  uintptr_t data = block ? (uintptr_t)(block + 1) : 0;
+  if (block && (uintptr_t)ptr >= data &&
+      (uintptr_t)ptr < data + block->capacity) {
+    size_t offset = (size_t)((uintptr_t)ptr - data);
+    size_t expected = offset + size;
+    if (arena->options.mode == BEBOP_ARENA_UNSYNCHRONIZED) {
+      if (bebop_atomic_load_relaxed(&block->used) == expected) {
+        bebop_atomic_store_relaxed(&block->used, offset);
+        bebop_atomic_store_relaxed(
+            &shard->total_used,
+            bebop_atomic_load_relaxed(&shard->total_used) - size);
+        return;
+      }
+    } else if (bebop_atomic_compare_exchange_weak(&block->used, &expected,
+                                                  offset)) {
+      bebop_atomic_fetch_add(&shard->total_used, -size);
+      return;
+    }
+  }
+
+  // Without other threads a dedicated block can be unlinked and freed
+  if (arena->options.mode == BEBOP_ARENA_UNSYNCHRONIZED &&
+      size > arena->options.max_block_size) {
+    bebop_arena_block_t *prev = NULL;
+    for (block = bebop_atomic_load_relaxed(&shard->current_block); block;
+         prev = block, block = block->next) {
+      if ((uint8_t *)(block + 1) != ptr) continue;
+      if (bebop_atomic_load_relaxed(&block->used) != size) break;
+      if (prev) {
+        prev->next = block->next;
+      } else {
+        bebop_atomic_store_relaxed(&shard->current_block, block->next);
+      }
+      bebop_atomic_store_relaxed(
+          &shard->total_allocated,
+          bebop_atomic_load_relaxed(&shard->total_allocated) -
+              (sizeof(bebop_arena_block_t) + block->capacity));
+      bebop_atomic_store_relaxed(
+          &shard->total_used,
+          bebop_atomic_load_relaxed(&shard->total_used) - size);
+      arena->free_func(block);
+      return;
+    }
+  }
+
+  if (size < sizeof(size_t)) return;
+  memcpy(ptr, &size, sizeof(size_t));
+  arena_park(shard, ptr);
+}
+
+// Takes the parked buffer if it holds at least `min_size` bytes
+static uint8_t *arena_take_released(bebop_arena_t *arena, size_t min_size,
+                                    size_t *size) {
+  bebop_arena_shard_t *shard = arena_shard(arena);
+  uint8_t *parked = bebop_atomic_load(&shard->released_buffer);
+  while (parked && !bebop_atomic_compare_exchange_weak(&shard->released_buffer,
+                                                       &parked, NULL)) {
+  }
+  if (!parked) return NULL;
+
+  memcpy(size, parked, sizeof(size_t));
+  if (*size >= min_size) return parked;
+  arena_park(shard, parked);
+  return NULL;
+}
+
 char *bebop_arena_strdup(bebop_arena_t *arena, const char *str, size_t len) {
   if (!arena || !str) return NULL;
 
@@ -179,11 +525,21 @@ void bebop_context_reset(bebop_context_t *context) {
 }
 
 size_t bebop_context_space_allocated(const bebop_context_t *context) {
-  return context ? bebop_atomic_load(&context->arena->total_allocated) : 0;
+  if (!context) return 0;
+  size_t total = 0;
+  for (uint32_t i = 0; i < context->arena->shard_count; i++) {
+    total += bebop_atomic_load(&context->arena->shards[i].total_allocated);
+  }
+  return total;
 }
 
 size_t bebop_context_space_used(const bebop_context_t *context) {
-  return context ? bebop_atomic_load(&context->arena->total_used) : 0;
+  if (!context) return 0;
+  size_t total = 0;
+  for (uint32_t i = 0; i < context->arena->shard_count; i++) {
+    total += bebop_atomic_load(&context->arena->shards[i].total_used);
+  }
+  return total;
 }
 
 // Reader functions
@@ -415,16 +771,31 @@ bebop_result_t bebop_reader_read_string_copy(bebop_reader_t *reader,
 // Writer functions
 bebop_result_t bebop_context_get_writer(bebop_context_t *context,
                                         bebop_writer_t *writer) {
-  if (!context || !writer) return BEBOP_ERROR_NULL_POINTER;
-
-  uint8_t *buffer = (uint8_t *)bebop_arena_alloc(
-      context->arena, context->options.initial_writer_size);
-  if (!buffer) return BEBOP_ERROR_OUT_OF_MEMORY;
+  return bebop_context_get_writer_with_hint(context, 0, writer);
+}
+
+static bebop_result_t writer_init(bebop_context_t *context, size_t buffer_size,
+                                  bebop_writer_t *writer) {
+  size_t released_size;
+  uint8_t *buffer =
+      arena_take_released(context->arena, buffer_size, &released_size);
+  if (buffer) {
+    buffer_size = released_size;
+  } else {
+    buffer = (uint8_t *)bebop_arena_alloc(context->arena, buffer_size);
+    if (!buffer) return BEBOP_ERROR_OUT_OF_MEMORY;
+  }
 
   writer->buffer = buffer;
   writer->current = buffer;
-  writer->end = buffer + context->options.initial_writer_size;
+  writer->end = buffer + buffer_size;
   writer->context = context;
+  writer->segments = NULL;
+  writer->segment_count = 0;
+  writer->segment_capacity = 0;
+  writer->sealed_length = 0;
+  writer->chunk_size = 0;
+  writer->lent = false;
   return BEBOP_OK;
 }
 
@@ -436,14 +807,84 @@ bebop_result_t bebop_context_get_writer_with_hint(bebop_context_t *context,
   size_t buffer_size = size_hint > context->options.initial_writer_size
                            ? size_hint
                            : context->options.initial_writer_size;
+  return writer_init(context, buffer_size, writer);
+}
 
-  uint8_t *buffer = (uint8_t *)bebop_arena_alloc(context->arena, buffer_size);
-  if (!buffer) return BEBOP_ERROR_OUT_OF_MEMORY;
+bebop_result_t bebop_context_get_segmented_writer(bebop_context_t *context,
+                                                  size_t chunk_size,
+                                                  bebop_writer_t *writer) {
+  if (!context || !writer) return BEBOP_ERROR_NULL_POINTER;
 
-  writer->buffer = buffer;
-  writer->current = buffer;
-  writer->end = buffer + buffer_size;
-  writer->context = context;
+  if (chunk_size == 0) chunk_size = context->options.initial_writer_size;
+  bebop_result_t result = writer_init(context, chunk_size, writer);
+  if (result != BEBOP_OK) return result;
+
+  writer->chunk_size = chunk_size;
+  return BEBOP_OK;
+}
+
+// Makes room for at least `min_count` entries in the segment array
+static bebop_result_t writer_reserve_segments(bebop_writer_t *writer,
+                                              size_t min_count) {
+  if (BEBOP_LIKELY(min_count <= writer->segment_capacity)) return BEBOP_OK;
+
+  bebop_arena_t *arena = writer->context->arena;
+  size_t capacity = writer->segment_capacity ? writer->segment_capacity * 2 : 8;
+  while (capacity < min_count) capacity *= 2;
+
+  bebop_segment_t *segments = (bebop_segment_t *)bebop_arena_alloc(
+      arena, capacity * sizeof(bebop_segment_t));
+  if (!segments) return BEBOP_ERROR_OUT_OF_MEMORY;
+
+  if (writer->segments) {
+    memcpy(segments, writer->segments,
+           writer->segment_count * sizeof(bebop_segment_t));
+    arena_release(arena, (uint8_t *)writer->segments,
+                  writer->segment_capacity * sizeof(bebop_segment_t));
+  }
+  writer->segments = segments;
+  writer->segment_capacity = capacity;
+  return BEBOP_OK;
+}
+
+// Segmented growth: extend the chunk in place if possible, otherwise seal it
+// and continue in a new one. Written bytes never move.
+static bebop_result_t writer_next_chunk(bebop_writer_t *writer,
+                                        size_t additional_bytes) {
+  bebop_arena_t *arena = writer->context->arena;
+  size_t current_size = writer->end - writer->buffer;
+  size_t used_size = writer->current - writer->buffer;
+  size_t chunk_size = writer->chunk_size > additional_bytes
+                          ? writer->chunk_size
+                          : additional_bytes;
+
+  if (arena_try_extend(arena, writer->buffer, current_size,
+                       used_size + chunk_size)) {
+    writer->end = writer->buffer + used_size + chunk_size;
+    return BEBOP_OK;
+  }
+
+  if (used_size > 0) {
+    bebop_result_t result =
+        writer_reserve_segments(writer, writer->segment_count + 1);
+    if (result != BEBOP_OK) return result;
+  }
+
+  uint8_t *chunk = (uint8_t *)bebop_arena_alloc(arena, chunk_size);
+  if (!chunk) return BEBOP_ERROR_OUT_OF_MEMORY;
+
+  if (used_size > 0) {
+    writer->segments[writer->segment_count].data = writer->buffer;
+    writer->segments[writer->segment_count].length = used_size;
+    writer->segment_count++;
+    writer->sealed_length += used_size;
+  } else if (!writer->lent) {
+    arena_release(arena, writer->buffer, current_size);
+  }
+  writer->buffer = chunk;
+  writer->lent = false;
+  writer->current = chunk;
+  writer->end = chunk + chunk_size;
   return BEBOP_OK;
 }
 
@@ -455,6 +896,9 @@ bebop_result_t bebop_writer_ensure_capacity(bebop_writer_t *writer,
     return BEBOP_OK;
   }
 
+  if (writer->chunk_size) return writer_next_chunk(writer, additional_bytes);
+
+  bebop_arena_t *arena = writer->context->arena;
   size_t current_size = writer->end - writer->buffer;
   size_t used_size = writer->current - writer->buffer;
   size_t new_size = current_size * 2;
@@ -463,12 +907,25 @@ bebop_result_t bebop_writer_ensure_capacity(bebop_writer_t *writer,
     new_size *= 2;
   }
 
-  uint8_t *new_buffer =
-      (uint8_t *)bebop_arena_alloc(writer->context->arena, new_size);
-  if (!new_buffer) return BEBOP_ERROR_OUT_OF_MEMORY;
+  if (arena_try_extend(arena, writer->buffer, current_size, new_size)) {
+    writer->end = writer->buffer + new_size;
+    return BEBOP_OK;
+  }
+
+  size_t released_size;
+  uint8_t *new_buffer = arena_take_released(arena, new_size, &released_size);
+  if (new_buffer) {
+    new_size = released_size;
+  } else {
+    new_buffer = (uint8_t *)bebop_arena_alloc(arena, new_size);
+    if (!new_buffer) return BEBOP_ERROR_OUT_OF_MEMORY;
+  }
 
   memcpy(new_buffer, writer->buffer, used_size);
+  // A buffer the caller holds from bebop_writer_get_buffer stays theirs
+  if (!writer->lent) arena_release(arena, writer->buffer, current_size);
   writer->buffer = new_buffer;
+  writer->lent = false;
   writer->current = new_buffer + used_size;
   writer->end = new_buffer + new_size;
   return BEBOP_OK;
@@ -476,6 +933,7 @@ bebop_result_t bebop_writer_ensure_capacity(bebop_writer_t *writer,
 
 // Writer primitive functions
 bebop_result_t bebop_writer_write_byte(bebop_writer_t *writer, uint8_t value) {
+  if (BEBOP_UNLIKELY(!writer)) return BEBOP_ERROR_NULL_POINTER;
   if (BEBOP_UNLIKELY(writer->current + 1 > writer->end)) {
     bebop_result_t result = bebop_writer_ensure_capacity(writer, 1);
     if (BEBOP_UNLIKELY(result != BEBOP_OK)) return result;
@@ -487,6 +945,7 @@ bebop_result_t bebop_writer_write_byte(bebop_writer_t *writer, uint8_t value) {
 
 bebop_result_t bebop_writer_write_uint16(bebop_writer_t *writer,
                                          uint16_t value) {
+  if (BEBOP_UNLIKELY(!writer)) return BEBOP_ERROR_NULL_POINTER;
   if (BEBOP_UNLIKELY(writer->current + sizeof(uint16_t) > writer->end)) {
     bebop_result_t result =
         bebop_writer_ensure_capacity(writer, sizeof(uint16_t));
@@ -505,6 +964,7 @@ bebop_result_t bebop_writer_write_uint16(bebop_writer_t *writer,
 
 bebop_result_t bebop_writer_write_uint32(bebop_writer_t *writer,
                                          uint32_t value) {
+  if (BEBOP_UNLIKELY(!writer)) return BEBOP_ERROR_NULL_POINTER;
   if (BEBOP_UNLIKELY(writer->current + sizeof(uint32_t) > writer->end)) {
     bebop_result_t result =
         bebop_writer_ensure_capacity(writer, sizeof(uint32_t));
@@ -525,6 +985,7 @@ bebop_result_t bebop_writer_write_uint32(bebop_writer_t *writer,
 
 bebop_result_t bebop_writer_write_uint64(bebop_writer_t *writer,
                                          uint64_t value) {
+  if (BEBOP_UNLIKELY(!writer)) return BEBOP_ERROR_NULL_POINTER;
   if (BEBOP_UNLIKELY(writer->current + sizeof(uint64_t) > writer->end)) {
     bebop_result_t result =
         bebop_writer_ensure_capacity(writer, sizeof(uint64_t));
@@ -578,6 +1039,7 @@ bebop_result_t bebop_writer_write_float64(bebop_writer_t *writer,
 
 bebop_result_t bebop_writer_write_guid(bebop_writer_t *writer,
                                        bebop_guid_t value) {
+  if (BEBOP_UNLIKELY(!writer)) return BEBOP_ERROR_NULL_POINTER;
   if (BEBOP_UNLIKELY(writer->current + sizeof(bebop_guid_t) > writer->end)) {
     bebop_result_t result =
         bebop_writer_ensure_capacity(writer, sizeof(bebop_guid_t));
@@ -879,14 +1341,39 @@ bebop_result_t bebop_writer_fill_message_length(bebop_writer_t *writer,
     return BEBOP_ERROR_MALFORMED_PACKET;
   }
 
+  if (BEBOP_LIKELY(position >= writer->sealed_length)) {
+    position -= writer->sealed_length;
 #if BEBOP_ASSUME_LITTLE_ENDIAN
-  memcpy(writer->buffer + position, &length, sizeof(uint32_t));
+    memcpy(writer->buffer + position, &length, sizeof(uint32_t));
 #else
-  writer->buffer[position++] = length;
-  writer->buffer[position++] = length >> 8;
-  writer->buffer[position++] = length >> 16;
-  writer->buffer[position++] = length >> 24;
+    writer->buffer[position++] = length;
+    writer->buffer[position++] = length >> 8;
+    writer->buffer[position++] = length >> 16;
+    writer->buffer[position++] = length >> 24;
 #endif
+    return BEBOP_OK;
+  }
+
+  // The prefix sits in a sealed chunk and may run into the chunks after it
+  size_t index = writer->segment_count;
+  size_t segment_start = writer->sealed_length;
+  do {
+    index--;
+    segment_start -= writer->segments[index].length;
+  } while (position < segment_start);
+
+  size_t offset = position - segment_start;
+  for (size_t i = 0; i < sizeof(uint32_t); i++, offset++) {
+    while (index < writer->segment_count &&
+           offset >= writer->segments[index].length) {
+      offset -= writer->segments[index].length;
+      index++;
+    }
+    uint8_t *target = index < writer->segment_count
+                          ? (uint8_t *)writer->segments[index].data
+                          : writer->buffer;
+    target[offset] = (uint8_t)(length >> (8 * i));
+  }
   return BEBOP_OK;
 }
 
@@ -894,11 +1381,84 @@ bebop_result_t bebop_writer_get_buffer(bebop_writer_t *writer, uint8_t **buffer,
                                        size_t *length) {
   if (!writer || !buffer || !length) return BEBOP_ERROR_NULL_POINTER;
 
+  if (BEBOP_UNLIKELY(writer->segment_count > 0)) {
+    size_t total = bebop_writer_length(writer);
+    uint8_t *flat = (uint8_t *)bebop_arena_alloc(writer->context->arena,
+                                                 total ? total : 1);
+    if (!flat) return BEBOP_ERROR_OUT_OF_MEMORY;
+
+    uint8_t *out = flat;
+    for (size_t i = 0; i < writer->segment_count; i++) {
+      memcpy(out, writer->segments[i].data, writer->segments[i].length);
+      out += writer->segments[i].length;
+    }
+    memcpy(out, writer->buffer, (size_t)(writer->current - writer->buffer));
+
+    writer->buffer = flat;
+    writer->current = flat + total;
+    writer->end = flat + total;
+    writer->segment_count = 0;
+    writer->sealed_length = 0;
+  }
+
+  writer->lent = true;
   *buffer = writer->buffer;
   *length = bebop_writer_length(writer);
   return BEBOP_OK;
 }
 
+bebop_result_t bebop_writer_reset(bebop_writer_t *writer) {
+  if (!writer) return BEBOP_ERROR_NULL_POINTER;
+
+  writer->current = writer->buffer;
+  writer->segment_count = 0;
+  writer->sealed_length = 0;
+  return BEBOP_OK;
+}
+
+bebop_result_t bebop_writer_get_segments(bebop_writer_t *writer,
+                                         const bebop_segment_t **segments,
+                                         size_t *count) {
+  if (!writer || !segments || !count) return BEBOP_ERROR_NULL_POINTER;
+
+  bebop_result_t result =
+      writer_reserve_segments(writer, writer->segment_count + 1);
+  if (result != BEBOP_OK) return result;
+
+  // The chunk being written is listed without sealing it
+  size_t total = writer->segment_count;
+  if (writer->current > writer->buffer || total == 0) {
+    writer->segments[total].data = writer->buffer;
+    writer->segments[total].length =
+        (size_t)(writer->current - writer->buffer);
+    total++;
+  }
+
+  *segments = writer->segments;
+  *count = total;
+  return BEBOP_OK;
+}
+
+#if defined(__unix__) || defined(__APPLE__)
+bebop_result_t bebop_writer_get_iovec(bebop_writer_t *writer,
+                                      struct iovec *iov, size_t capacity,
+                                      size_t *count) {
+  if (!writer || !count || (!iov && capacity > 0))
+    return BEBOP_ERROR_NULL_POINTER;
+
+  const bebop_segment_t *segments;
+  bebop_result_t result = bebop_writer_get_segments(writer, &segments, count);
+  if (result != BEBOP_OK) return result;
+  if (*count > capacity) return BEBOP_ERROR_BUFFER_TOO_SMALL;
+
+  for (size_t i = 0; i < *count; i++) {
+    iov[i].iov_base = (void *)segments[i].data;
+    iov[i].iov_len = segments[i].length;
+  }
+  return BEBOP_OK;
+}
+#endif
+
 // GUID utility functions
 static const uint8_t ascii_to_hex[256] = {
     0, 0, 0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0, 0, 0, 0, 0,
@@ -1009,6 +1569,8 @@ bebop_context_options_t bebop_context_default_options(void) {
   bebop_context_options_t options = {
       .arena_options = {.initial_block_size = 4096,
                         .max_block_size = 1048576,
+                        .retain_max_bytes = SIZE_MAX,
+                        .retain_resets = 8,
                         .allocator = {.malloc_func = NULL, .free_func = NULL}},
       .initial_writer_size = 1024};
   return options;
@@ -1023,7 +1585,9 @@ const uint8_t *bebop_reader_position(const bebop_reader_t *reader) {
 }
 
 size_t bebop_writer_length(const bebop_writer_t *writer) {
-  return writer ? (size_t)(writer->current - writer->buffer) : 0;
+  return writer ? writer->sealed_length +
+                      (size_t)(writer->current - writer->buffer)
+                : 0;
 }
 
 size_t bebop_writer_remaining(const bebop_writer_t *writer) {
@@ -14,6 +14,10 @@
 #include <stdlib.h>
 #include <string.h>
 
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/uio.h>
+#endif
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -69,6 +73,8 @@ extern "C" {
   (*(ptr) == *(expected) ? (*(ptr) = (desired), true)              \
                          : (*(expected) = *(ptr), false))
 #define bebop_atomic_init(ptr, val) (*(ptr) = (val))
+#define bebop_atomic_load_relaxed(ptr) (*(ptr))
+#define bebop_atomic_store_relaxed(ptr, val) (*(ptr) = (val))
 #else
 #include <stdatomic.h>
 #define bebop_atomic_load(ptr) atomic_load(ptr)
@@ -77,6 +83,10 @@ extern "C" {
 #define bebop_atomic_compare_exchange_weak(ptr, expected, desired) \
   atomic_compare_exchange_weak(ptr, expected, desired)
 #define bebop_atomic_init(ptr, val) atomic_init(ptr, val)
+#define bebop_atomic_load_relaxed(ptr) \
+  atomic_load_explicit(ptr, memory_order_relaxed)
+#define bebop_atomic_store_relaxed(ptr, val) \
+  atomic_store_explicit(ptr, val, memory_order_relaxed)
 #endif
 
 /** @defgroup datetime Date and Time Constants
@@ -460,24 +470,89 @@ typedef struct bebop_arena_block {
   size_t capacity; /**< Total block capacity */
 } bebop_arena_block_t;
 
-/** Arena configuration options */
+/** Number of past resets the arena remembers for its trim policy */
+#ifndef BEBOP_ARENA_RETAIN_HISTORY
+#define BEBOP_ARENA_RETAIN_HISTORY 16
+#endif
+
+/** Number of shards used in sharded mode when `shard_count` is 0 */
+#ifndef BEBOP_ARENA_DEFAULT_SHARDS
+#define BEBOP_ARENA_DEFAULT_SHARDS 16
+#endif
+
+/** Cache line size used to keep arena shards apart */
+#ifndef BEBOP_CACHE_LINE_SIZE
+#define BEBOP_CACHE_LINE_SIZE 64
+#endif
+
+/** Arena synchronization strategy, chosen per context */
+typedef enum {
+  BEBOP_ARENA_LOCK_FREE = 0,      /**< One block chain shared through CAS */
+  BEBOP_ARENA_SHARDED = 1,        /**< Threads allocate from their own shard */
+  BEBOP_ARENA_UNSYNCHRONIZED = 2, /**< No atomic read-modify-writes; the
+                                       context must stay on one thread */
+} bebop_arena_mode_t;
+
+/**
+ * Arena configuration options
+ *
+ * On reset the arena keeps its blocks for reuse instead of returning them to
+ * the allocator. The retained bytes are bounded by `retain_max_bytes` and, when
+ * `retain_resets` is non-zero, by the largest amount of block memory used in
+ * any of the last `retain_resets` cycles, so a one-off spike is released once
+ * it falls out of that window.
+ */
 typedef struct {
-  size_t initial_block_size;   /**< Size of first allocated block */
-  size_t max_block_size;       /**< Maximum size for new blocks */
+  size_t initial_block_size; /**< Size of first allocated block */
+  size_t max_block_size;     /**< Maximum size for new blocks; larger
+                                  allocations get a dedicated block */
+  size_t retain_max_bytes;   /**< Block bytes kept across a reset (0 frees
+                                  every block, SIZE_MAX keeps all of them) */
+  uint32_t retain_resets;    /**< Trim to the high-water mark of the last N
+                                  resets (0 disables, at most
+                                  BEBOP_ARENA_RETAIN_HISTORY) */
+  bebop_arena_mode_t mode;   /**< Synchronization strategy */
+  uint32_t shard_count;      /**< Shards in sharded mode (0 uses
+                                  BEBOP_ARENA_DEFAULT_SHARDS) */
   bebop_allocator_t allocator; /**< Custom allocator functions */
 } bebop_arena_options_t;
 
-/** Thread-safe memory arena */
+/**
+ * Block chain owned by one arena shard (internal structure)
+ *
+ * Lock-free and unsynchronized arenas have a single shard. Sharded arenas
+ * give each thread a shard picked from a per-thread slot, so threads only
+ * contend when there are more of them than shards.
+ */
 typedef struct {
 #ifdef BEBOP_SINGLE_THREADED
-  bebop_arena_block_t *current_block; /**< Current allocation block */
-  size_t total_allocated;             /**< Total bytes allocated */
-  size_t total_used;                  /**< Total bytes in use */
+  bebop_arena_block_t *current_block;   /**< Current allocation block */
+  bebop_arena_block_t *retained_blocks; /**< Blocks kept by the last reset */
+  bebop_arena_block_t *spare_block;     /**< Block left over from a lost race */
+  uint8_t *released_buffer;             /**< Abandoned writer buffer */
+  size_t total_allocated;               /**< Bytes allocated by this shard */
+  size_t total_used;                    /**< Bytes in use in this shard */
 #else
-  _Atomic(bebop_arena_block_t *) current_block; /**< Current allocation block */
-  _Atomic size_t total_allocated;               /**< Total bytes allocated */
-  _Atomic size_t total_used;                    /**< Total bytes in use */
+  _Alignas(BEBOP_CACHE_LINE_SIZE) _Atomic(bebop_arena_block_t *)
+      current_block;                              /**< Current allocation block */
+  _Atomic(bebop_arena_block_t *) retained_blocks; /**< Blocks kept by the last
+                                                       reset */
+  _Atomic(bebop_arena_block_t *) spare_block; /**< Block left over from a lost
+                                                   race */
+  _Atomic(uint8_t *) released_buffer; /**< Abandoned writer buffer */
+  _Atomic size_t total_allocated; /**< Bytes allocated by this shard */
+  _Atomic size_t total_used;      /**< Bytes in use in this shard */
 #endif
+} bebop_arena_shard_t;
+
+/** Thread-safe memory arena */
+typedef struct {
+  bebop_arena_shard_t *shards; /**< Block chains, one unless sharded */
+  uint32_t shard_count;        /**< Number of shards */
+  void *shard_storage;         /**< Allocation backing `shards` */
+  size_t cycle_bytes[BEBOP_ARENA_RETAIN_HISTORY]; /**< Block bytes used in
+                                                       recent cycles */
+  uint32_t reset_count;            /**< Number of resets so far */
   bebop_arena_options_t options;   /**< Arena configuration */
   bebop_malloc_func_t malloc_func; /**< Cached malloc function */
   bebop_free_func_t free_func;     /**< Cached free function */
@@ -527,6 +602,12 @@ void bebop_context_destroy(bebop_context_t *context);
 
 /**
  * @brief Reset context, keeping allocated blocks for reuse
+ *
+ * Blocks are retained according to the arena's trim policy (see
+ * bebop_arena_options_t) and handed out again, in the order they were first
+ * needed, before any new block is requested from the allocator. Must not be
+ * called while other threads are allocating from the context.
+ *
  * @param context Context to reset
  */
 void bebop_context_reset(bebop_context_t *context);
@@ -534,7 +615,7 @@ void bebop_context_reset(bebop_context_t *context);
 /**
  * @brief Get total allocated memory
  * @param context Target context
- * @return Bytes allocated across all blocks
+ * @return Bytes allocated across all blocks, including retained ones
  */
 size_t bebop_context_space_allocated(const bebop_context_t *context);
 
@@ -657,12 +738,31 @@ bebop_result_t bebop_reader_read_string_copy(bebop_reader_t *reader,
  *  @{
  */
 
-/** Binary data writer state */
+/** Contiguous piece of a segmented writer's output */
+typedef struct {
+  const uint8_t *data; /**< Segment bytes */
+  size_t length;       /**< Segment length */
+} bebop_segment_t;
+
+/**
+ * Binary data writer state
+ *
+ * A segmented writer never moves data it has written: when its chunk is full
+ * the chunk is sealed and writing continues in a fresh one. `buffer` always
+ * points at the chunk being written.
+ */
 struct bebop_writer {
-  uint8_t *buffer;          /**< Output buffer */
-  uint8_t *current;         /**< Current write position */
-  uint8_t *end;             /**< Buffer end */
-  bebop_context_t *context; /**< Associated context for allocations */
+  uint8_t *buffer;            /**< Output buffer (current chunk) */
+  uint8_t *current;           /**< Current write position */
+  uint8_t *end;               /**< Buffer end */
+  bebop_context_t *context;   /**< Associated context for allocations */
+  bebop_segment_t *segments;  /**< Sealed chunks, oldest first */
+  size_t segment_count;       /**< Number of sealed chunks */
+  size_t segment_capacity;    /**< Capacity of `segments` */
+  size_t sealed_length;       /**< Bytes in sealed chunks */
+  size_t chunk_size;          /**< Chunk size, 0 for a contiguous writer */
+  bool lent;                  /**< `buffer` was returned by get_buffer, so it
+                                   is never handed back to the arena */
 };
 
 /**
@@ -685,8 +785,32 @@ bebop_result_t bebop_context_get_writer_with_hint(bebop_context_t *context,
                                                   size_t size_hint,
                                                   bebop_writer_t *writer);
 
+/**
+ * @brief Get a segmented writer from context
+ *
+ * Writes go into a chain of arena chunks of `chunk_size` bytes (values that
+ * do not fit start a new chunk), so growth never copies. Length prefixes are
+ * backpatched across chunk boundaries, and generated `*_encode` functions
+ * work on it unchanged. Export the result with bebop_writer_get_segments or
+ * bebop_writer_get_iovec.
+ *
+ * @param context Source context
+ * @param chunk_size Chunk size (0 uses the context's initial writer size)
+ * @param writer Output writer
+ * @return BEBOP_OK or error code
+ */
+bebop_result_t bebop_context_get_segmented_writer(bebop_context_t *context,
+                                                  size_t chunk_size,
+                                                  bebop_writer_t *writer);
+
 /**
  * @brief Ensure buffer has space for additional bytes
+ *
+ * When the buffer is the most recent allocation in its arena block and the
+ * block has room, it is extended in place. Otherwise the contents move to a
+ * larger buffer and the old one is handed back to the arena, which reuses it
+ * for the next writer buffer it fits.
+ *
  * @param writer Target writer
  * @param additional_bytes Required additional capacity
  * @return BEBOP_OK or error code
@@ -902,6 +1026,15 @@ bebop_result_t bebop_writer_fill_message_length(bebop_writer_t *writer,
 
 /**
  * @brief Get final buffer and length
+ *
+ * A segmented writer spanning several chunks is flattened into one arena
+ * buffer first; use bebop_writer_get_segments to avoid that copy.
+ *
+ * The buffer stays valid until the context is reset. Writing more may move
+ * the writer to a larger buffer, but the one returned here is never reused
+ * for other data; only bebop_writer_reset, which rewinds the writer onto it,
+ * overwrites it.
+ *
  * @param writer Source writer
  * @param buffer Output buffer pointer
  * @param length Output buffer length
@@ -910,6 +1043,47 @@ bebop_result_t bebop_writer_fill_message_length(bebop_writer_t *writer,
 bebop_result_t bebop_writer_get_buffer(bebop_writer_t *writer, uint8_t **buffer,
                                        size_t *length);
 
+/**
+ * @brief Discard written data, keeping the buffer for the next message
+ *
+ * The writer stays valid until its context is reset; after that it must be
+ * obtained again with bebop_context_get_writer.
+ *
+ * @param writer Target writer
+ * @return BEBOP_OK or error code
+ */
+bebop_result_t bebop_writer_reset(bebop_writer_t *writer);
+
+/**
+ * @brief Get the written data as a list of segments
+ *
+ * Contiguous writers produce a single segment. The array lives in the arena
+ * and is valid until the next write or context reset.
+ *
+ * @param writer Source writer
+ * @param segments Output segment array
+ * @param count Output number of segments
+ * @return BEBOP_OK or error code
+ */
+bebop_result_t bebop_writer_get_segments(bebop_writer_t *writer,
+                                         const bebop_segment_t **segments,
+                                         size_t *count);
+
+#if defined(__unix__) || defined(__APPLE__)
+/**
+ * @brief Export the written data as an iovec array for writev/sendmsg
+ * @param writer Source writer
+ * @param iov Destination array
+ * @param capacity Entries available in `iov`
+ * @param count Output number of entries filled
+ * @return BEBOP_OK, or BEBOP_ERROR_BUFFER_TOO_SMALL if `capacity` is short
+ *         (`count` then holds the number needed)
+ */
+bebop_result_t bebop_writer_get_iovec(bebop_writer_t *writer,
+                                      struct iovec *iov, size_t capacity,
+                                      size_t *count);
+#endif
+
 /** @} */
 
 /** @defgroup utilities Utility Functions
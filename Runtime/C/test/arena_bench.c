@@ -0,0 +1,94 @@
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "../src/bebop.h"
+
+// Measures a request loop that encodes a message and resets its context,
+// with and without arena block retention.
+
+#define WARMUP_REQUESTS 100
+#define REQUESTS 200000
+
+static size_t malloc_calls = 0;
+static size_t free_calls = 0;
+
+static void *counting_malloc(size_t size) {
+  malloc_calls++;
+  return malloc(size);
+}
+
+static void counting_free(void *ptr) {
+  free_calls++;
+  free(ptr);
+}
+
+static double get_time_ms(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+}
+
+// One request: scratch allocations plus an encoded reply that outgrows the
+// writer's initial buffer.
+static void handle_request(bebop_context_t *context, size_t request) {
+  static const char text[] = "The quick brown fox jumps over the lazy dog";
+
+  for (size_t i = 0; i < 16; i++) {
+    if (!bebop_context_strdup(context, text, sizeof(text) - 1)) abort();
+  }
+  uint32_t *scratch =
+      (uint32_t *)bebop_context_alloc(context, 3000 * sizeof(uint32_t));
+  if (!scratch) abort();
+
+  bebop_writer_t writer;
+  if (bebop_context_get_writer(context, &writer) != BEBOP_OK) abort();
+  for (uint32_t i = 0; i < 3000; i++) {
+    scratch[i] = (uint32_t)(request + i);
+    if (bebop_writer_write_uint32(&writer, scratch[i]) != BEBOP_OK ||
+        bebop_writer_write_string(&writer, text, 8) != BEBOP_OK)
+      abort();
+  }
+}
+
+static void run(const char *name, size_t retain_max_bytes) {
+  bebop_context_options_t options = bebop_context_default_options();
+  options.arena_options.retain_max_bytes = retain_max_bytes;
+  options.arena_options.allocator.malloc_func = counting_malloc;
+  options.arena_options.allocator.free_func = counting_free;
+  bebop_context_t *context = bebop_context_create_with_options(&options);
+  if (!context) abort();
+
+  for (size_t i = 0; i < WARMUP_REQUESTS; i++) {
+    handle_request(context, i);
+    bebop_context_reset(context);
+  }
+
+  size_t mallocs_before = malloc_calls;
+  size_t frees_before = free_calls;
+  double start = get_time_ms();
+  for (size_t i = 0; i < REQUESTS; i++) {
+    handle_request(context, i);
+    bebop_context_reset(context);
+  }
+  double elapsed = get_time_ms() - start;
+
+  printf("%-24s %9.1f ns/request  %8.3f mallocs/request  %8.3f "
+         "frees/request  %zu bytes retained\n",
+         name, elapsed * 1e6 / REQUESTS,
+         (double)(malloc_calls - mallocs_before) / REQUESTS,
+         (double)(free_calls - frees_before) / REQUESTS,
+         bebop_context_space_allocated(context));
+
+  bebop_context_destroy(context);
+}
+
+int main(void) {
+  printf("Arena reset benchmark (%d requests)\n", REQUESTS);
+  run("free blocks on reset", 0);
+  run("retain blocks on reset", SIZE_MAX);
+  return 0;
+}
@@ -0,0 +1,106 @@
+#define _POSIX_C_SOURCE 200112L
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "../src/bebop.h"
+
+// Measures allocation throughput when many threads share one context, for
+// each arena synchronization mode. Threads allocate in rounds and the context
+// is reset between rounds, like a server draining a batch of requests.
+
+#define ROUNDS 20
+#define ALLOCATIONS_PER_ROUND 50000
+#define ALLOCATIONS_PER_THREAD (ROUNDS * ALLOCATIONS_PER_ROUND)
+#define MAX_THREADS 32
+
+static _Atomic size_t malloc_calls = 0;
+
+static void *counting_malloc(size_t size) {
+  atomic_fetch_add(&malloc_calls, 1);
+  return malloc(size);
+}
+
+typedef struct {
+  bebop_context_t *context;
+  pthread_barrier_t *barrier;
+  unsigned seed;
+} worker_t;
+
+static double get_time_ms(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+}
+
+static void *worker(void *arg) {
+  worker_t *w = (worker_t *)arg;
+  unsigned x = w->seed;
+  for (int round = 0; round < ROUNDS; round++) {
+    pthread_barrier_wait(w->barrier);
+    for (int i = 0; i < ALLOCATIONS_PER_ROUND; i++) {
+      x = x * 1103515245u + 12345u;
+      size_t size = 16 + ((x >> 16) & 0x70);
+      uint8_t *ptr = (uint8_t *)bebop_context_alloc(w->context, size);
+      if (!ptr) abort();
+      ptr[0] = (uint8_t)i;
+    }
+    pthread_barrier_wait(w->barrier);
+  }
+  return NULL;
+}
+
+static void run(const char *name, bebop_arena_mode_t mode, int threads) {
+  bebop_context_options_t options = bebop_context_default_options();
+  options.arena_options.mode = mode;
+  options.arena_options.initial_block_size = 65536;
+  options.arena_options.allocator.malloc_func = counting_malloc;
+  bebop_context_t *context = bebop_context_create_with_options(&options);
+  if (!context) abort();
+
+  pthread_t handles[MAX_THREADS];
+  worker_t workers[MAX_THREADS];
+  pthread_barrier_t barrier;
+  pthread_barrier_init(&barrier, NULL, (unsigned)threads + 1);
+  for (int i = 0; i < threads; i++) {
+    workers[i] = (worker_t){context, &barrier, (unsigned)i * 7919u + 1u};
+    if (pthread_create(&handles[i], NULL, worker, &workers[i]) != 0) abort();
+  }
+
+  size_t mallocs_before = atomic_load(&malloc_calls);
+  double start = get_time_ms();
+  for (int round = 0; round < ROUNDS; round++) {
+    pthread_barrier_wait(&barrier);
+    pthread_barrier_wait(&barrier);
+    bebop_context_reset(context);
+  }
+  double elapsed = get_time_ms() - start;
+  size_t mallocs = atomic_load(&malloc_calls) - mallocs_before;
+  for (int i = 0; i < threads; i++) pthread_join(handles[i], NULL);
+
+  double total = (double)threads * ALLOCATIONS_PER_THREAD;
+  printf("%-16s %2d threads  %8.1f M allocs/s  %6zu block mallocs  %7zu KiB "
+         "retained\n",
+         name, threads, total / elapsed / 1000.0, mallocs,
+         bebop_context_space_allocated(context) / 1024);
+
+  pthread_barrier_destroy(&barrier);
+  bebop_context_destroy(context);
+}
+
+int main(int argc, char **argv) {
+  int max_threads = argc > 1 ? atoi(argv[1]) : MAX_THREADS;
+  if (max_threads < 1 || max_threads > MAX_THREADS) max_threads = MAX_THREADS;
+
+  printf("Arena thread-scaling benchmark (%d allocations per thread)\n",
+         ALLOCATIONS_PER_THREAD);
+  run("unsynchronized", BEBOP_ARENA_UNSYNCHRONIZED, 1);
+  for (int threads = 1; threads <= max_threads; threads *= 2) {
+    run("lock-free", BEBOP_ARENA_LOCK_FREE, threads);
+    run("sharded", BEBOP_ARENA_SHARDED, threads);
+  }
+  return 0;
+}
@@ -96,6 +96,117 @@ void test_context(void) {
   TEST_END("context management");
 }
 
+// Allocation counters for the arena reuse tests
+static size_t counted_mallocs = 0;
+static size_t counted_frees = 0;
+
+static void *counting_malloc(size_t size) {
+  counted_mallocs++;
+  return malloc(size);
+}
+
+static void counting_free(void *ptr) {
+  counted_frees++;
+  free(ptr);
+}
+
+// Arena block retention tests
+void test_arena_reuse(void) {
+  TEST_START("arena block reuse");
+
+  bebop_context_options_t options = bebop_context_default_options();
+  assert(options.arena_options.retain_max_bytes == SIZE_MAX);
+  assert(options.arena_options.retain_resets == 8);
+
+  options.arena_options.initial_block_size = 1024;
+  options.arena_options.max_block_size = 4096;
+  options.arena_options.allocator.malloc_func = counting_malloc;
+  options.arena_options.allocator.free_func = counting_free;
+  bebop_context_t *context = bebop_context_create_with_options(&options);
+  assert(context != NULL);
+
+  // One cycle: several regular blocks plus an oversized one
+  size_t sizes[] = {600, 600, 600, 10000, 100};
+  for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+    assert(bebop_context_alloc(context, sizes[i]) != NULL);
+  }
+  size_t allocated = bebop_context_space_allocated(context);
+  size_t mallocs = counted_mallocs;
+
+  // Repeating the cycle after a reset reuses every block
+  for (int cycle = 0; cycle < 100; cycle++) {
+    bebop_context_reset(context);
+    assert(bebop_context_space_used(context) == 0);
+    assert(bebop_context_space_allocated(context) == allocated);
+    for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+      uint8_t *ptr = (uint8_t *)bebop_context_alloc(context, sizes[i]);
+      assert(ptr != NULL);
+      memset(ptr, 0xAB, sizes[i]);
+    }
+  }
+  assert(counted_mallocs == mallocs);
+  assert(counted_frees == 0);
+
+  // A spike is released once it leaves the retain_resets window
+  assert(bebop_context_alloc(context, 50000) != NULL);
+  bebop_context_reset(context);
+  size_t spike = bebop_context_space_allocated(context);
+  assert(spike > allocated);
+  for (int cycle = 0; cycle < 8; cycle++) {
+    assert(bebop_context_alloc(context, 100) != NULL);
+    bebop_context_reset(context);
+  }
+  assert(bebop_context_space_allocated(context) < spike);
+  assert(counted_frees > 0);
+  bebop_context_destroy(context);
+
+  // A zero byte budget frees every block on reset
+  options.arena_options.retain_max_bytes = 0;
+  context = bebop_context_create_with_options(&options);
+  assert(context != NULL);
+  assert(bebop_context_alloc(context, 100) != NULL);
+  size_t frees = counted_frees;
+  bebop_context_reset(context);
+  assert(counted_frees == frees + 1);
+  assert(bebop_context_space_allocated(context) == 0);
+  bebop_context_destroy(context);
+
+  // A byte budget caps what survives the reset
+  options.arena_options.retain_max_bytes = 2048 + 2 * BEBOP_ARENA_BLOCK_OVERHEAD;
+  options.arena_options.retain_resets = 0;
+  context = bebop_context_create_with_options(&options);
+  assert(context != NULL);
+  for (int i = 0; i < 4; i++) {
+    assert(bebop_context_alloc(context, 1000) != NULL);
+  }
+  bebop_context_reset(context);
+  assert(bebop_context_space_allocated(context) ==
+         2 * (1024 + BEBOP_ARENA_BLOCK_OVERHEAD));
+  bebop_context_destroy(context);
+
+  // Every synchronization mode recycles blocks
+  bebop_arena_mode_t modes[] = {BEBOP_ARENA_LOCK_FREE, BEBOP_ARENA_SHARDED,
+                                BEBOP_ARENA_UNSYNCHRONIZED};
+  options.arena_options.retain_max_bytes = SIZE_MAX;
+  for (size_t m = 0; m < sizeof(modes) / sizeof(modes[0]); m++) {
+    options.arena_options.mode = modes[m];
+    context = bebop_context_create_with_options(&options);
+    assert(context != NULL);
+    for (int cycle = 0; cycle < 10; cycle++) {
+      if (cycle == 1) mallocs = counted_mallocs;
+      for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+        assert(bebop_context_alloc(context, sizes[i]) != NULL);
+      }
+      assert(bebop_context_space_used(context) >= 11900);
+      bebop_context_reset(context);
+    }
+    assert(counted_mallocs == mallocs);
+    bebop_context_destroy(context);
+  }
+
+  TEST_END("arena block reuse");
+}
+
 // Reader/Writer initialization tests
 void test_reader_writer_init(void) {
   TEST_START("reader/writer initialization");
@@ -629,11 +740,180 @@ void test_writer_buffer_management(void) {
   assert(bebop_writer_ensure_capacity(&writer, 1000) == BEBOP_OK);
   assert(bebop_writer_remaining(&writer) >= 1000);
 
+  // The most recent allocation grows in place
+  bebop_context_reset(small_context);
+  assert(bebop_context_get_writer(small_context, &writer) == BEBOP_OK);
+  uint8_t *first_buffer = writer.buffer;
+  for (uint32_t i = 0; i < 256; i++) {
+    assert(bebop_writer_write_uint32(&writer, i) == BEBOP_OK);
+  }
+  assert(writer.buffer == first_buffer);
+  assert(bebop_context_space_used(small_context) == 1024);
+  for (uint32_t i = 0; i < 256; i++) {
+    uint32_t value;
+    memcpy(&value, writer.buffer + i * 4, sizeof(value));
+    assert(value == i);
+  }
+
+  // A buffer that has to move is reused by the next writer
+  bebop_writer_t second;
+  assert(bebop_context_get_writer(small_context, &second) == BEBOP_OK);
+  assert(bebop_writer_write_uint32(&writer, 256) == BEBOP_OK);
+  assert(writer.buffer != first_buffer);
+  assert(bebop_writer_length(&writer) == 257 * 4);
+  bebop_writer_t third;
+  assert(bebop_context_get_writer_with_hint(small_context, 1024, &third) ==
+         BEBOP_OK);
+  assert(third.buffer == first_buffer);
+  assert(bebop_writer_remaining(&third) == 1024);
+
+  // Resetting a writer keeps its buffer
+  size_t used = bebop_context_space_used(small_context);
+  assert(bebop_writer_reset(&writer) == BEBOP_OK);
+  assert(bebop_writer_length(&writer) == 0);
+  assert(bebop_writer_remaining(&writer) == 2048);
+  assert(bebop_writer_write_uint32(&writer, 7) == BEBOP_OK);
+  assert(bebop_context_space_used(small_context) == used);
+  assert(bebop_writer_reset(NULL) == BEBOP_ERROR_NULL_POINTER);
+
+  // A buffer returned by get_buffer survives the writer outgrowing it
+  bebop_writer_t lender;
+  assert(bebop_context_get_writer(small_context, &lender) == BEBOP_OK);
+  assert(bebop_context_get_writer(small_context, &second) == BEBOP_OK);
+  assert(bebop_writer_write_uint32(&lender, 0xdeadbeef) == BEBOP_OK);
+  uint8_t *lent_buffer;
+  size_t lent_length;
+  assert(bebop_writer_get_buffer(&lender, &lent_buffer, &lent_length) ==
+         BEBOP_OK);
+  for (uint32_t i = 0; i < 1024; i++) {
+    assert(bebop_writer_write_uint32(&lender, i) == BEBOP_OK);
+  }
+  assert(lender.buffer != lent_buffer);
+  assert(bebop_context_get_writer_with_hint(small_context, 1024, &third) ==
+         BEBOP_OK);
+  assert(third.buffer != lent_buffer);
+  for (uint32_t i = 0; i < 256; i++) {
+    assert(bebop_writer_write_uint32(&third, 0) == BEBOP_OK);
+  }
+  uint32_t lent_value;
+  memcpy(&lent_value, lent_buffer, sizeof(lent_value));
+  assert(lent_length == 4 && lent_value == 0xdeadbeef);
+
+  // Single-threaded contexts free outgrown dedicated blocks
+  options.arena_options.max_block_size = 4096;
+  options.arena_options.mode = BEBOP_ARENA_UNSYNCHRONIZED;
+  bebop_context_t *unsync_context = bebop_context_create_with_options(&options);
+  assert(bebop_context_get_writer(unsync_context, &writer) == BEBOP_OK);
+  for (uint32_t i = 0; i < 65536; i++) {
+    assert(bebop_writer_write_uint32(&writer, i) == BEBOP_OK);
+  }
+  assert(bebop_context_space_used(unsync_context) < 2 * 65536 * 4);
+  for (uint32_t i = 0; i < 65536; i++) {
+    uint32_t value;
+    memcpy(&value, writer.buffer + i * 4, sizeof(value));
+    assert(value == i);
+  }
+  bebop_context_destroy(unsync_context);
+
   bebop_context_destroy(context);
   bebop_context_destroy(small_context);
   TEST_END("writer buffer management");
 }
 
+// Segmented writer tests
+void test_segmented_writer(void) {
+  TEST_START("segmented writer");
+
+  bebop_context_t *context = bebop_context_create();
+  bebop_writer_t writer;
+  assert(bebop_context_get_segmented_writer(NULL, 16, &writer) ==
+         BEBOP_ERROR_NULL_POINTER);
+  assert(bebop_context_get_segmented_writer(context, 16, &writer) ==
+         BEBOP_OK);
+
+  // Interleaved allocations keep chunks from growing in place
+  size_t outer;
+  assert(bebop_writer_reserve_message_length(&writer, &outer) == BEBOP_OK);
+  for (uint32_t i = 0; i < 100; i++) {
+    assert(bebop_writer_write_uint32(&writer, i) == BEBOP_OK);
+    assert(bebop_context_alloc(context, 8) != NULL);
+  }
+  assert(bebop_writer_write_string(&writer, "segmented", 9) == BEBOP_OK);
+  assert(bebop_writer_fill_message_length(
+             &writer, outer, (uint32_t)(bebop_writer_length(&writer) - 4)) ==
+         BEBOP_OK);
+  assert(bebop_writer_length(&writer) == 4 + 400 + 4 + 9);
+
+  const bebop_segment_t *segments;
+  size_t count;
+  assert(bebop_writer_get_segments(&writer, &segments, &count) == BEBOP_OK);
+  assert(count > 10);
+  uint8_t flat[4 + 400 + 4 + 9];
+  size_t offset = 0;
+  for (size_t i = 0; i < count; i++) {
+    assert(segments[i].length <= 16);
+    memcpy(flat + offset, segments[i].data, segments[i].length);
+    offset += segments[i].length;
+  }
+  assert(offset == sizeof(flat));
+
+  bebop_reader_t reader;
+  assert(bebop_context_get_reader(context, flat, sizeof(flat), &reader) ==
+         BEBOP_OK);
+  uint32_t value;
+  assert(bebop_reader_read_uint32(&reader, &value) == BEBOP_OK);
+  assert(value == sizeof(flat) - 4);
+  for (uint32_t i = 0; i < 100; i++) {
+    assert(bebop_reader_read_uint32(&reader, &value) == BEBOP_OK);
+    assert(value == i);
+  }
+
+#if defined(__unix__) || defined(__APPLE__)
+  struct iovec iov[64];
+  size_t iov_count;
+  assert(bebop_writer_get_iovec(&writer, iov, 1, &iov_count) ==
+         BEBOP_ERROR_BUFFER_TOO_SMALL);
+  assert(iov_count == count);
+  assert(bebop_writer_get_iovec(&writer, iov, 64, &iov_count) == BEBOP_OK);
+  assert(iov_count == count);
+  assert(iov[0].iov_base == segments[0].data);
+#endif
+
+  // Flattening yields the same bytes
+  uint8_t *buffer;
+  size_t length;
+  assert(bebop_writer_get_buffer(&writer, &buffer, &length) == BEBOP_OK);
+  assert(length == sizeof(flat));
+  assert(memcmp(buffer, flat, length) == 0);
+
+  // A length prefix split across two chunks is backpatched byte by byte
+  bebop_context_reset(context);
+  assert(bebop_context_get_segmented_writer(context, 6, &writer) == BEBOP_OK);
+  for (int i = 0; i < 4; i++) {
+    assert(bebop_writer_write_byte(&writer, 0xEE) == BEBOP_OK);
+  }
+  assert(bebop_context_alloc(context, 8) != NULL);
+  assert(bebop_writer_write_uint32(&writer, 0) == BEBOP_OK);
+  assert(bebop_writer_get_segments(&writer, &segments, &count) == BEBOP_OK);
+  assert(count == 2);
+  assert(bebop_writer_fill_message_length(&writer, 2, 0x04030201) ==
+         BEBOP_OK);
+  assert(bebop_writer_get_buffer(&writer, &buffer, &length) == BEBOP_OK);
+  uint8_t expected[] = {0xEE, 0xEE, 0x01, 0x02, 0x03, 0x04, 0, 0};
+  assert(length == sizeof(expected));
+  assert(memcmp(buffer, expected, length) == 0);
+
+  // Contiguous writers export a single segment
+  assert(bebop_context_get_writer(context, &writer) == BEBOP_OK);
+  assert(bebop_writer_write_uint32(&writer, 1) == BEBOP_OK);
+  assert(bebop_writer_get_segments(&writer, &segments, &count) == BEBOP_OK);
+  assert(count == 1 && segments[0].data == writer.buffer &&
+         segments[0].length == 4);
+
+  bebop_context_destroy(context);
+  TEST_END("segmented writer");
+}
+
 // Message length reservation tests
 void test_message_length(void) {
   TEST_START("message length reservation");
@@ -967,36 +1247,51 @@ void test_thread_safety(void) {
   const int num_threads = 4;
   const int iterations = 1000;
 
-  bebop_context_t *context = bebop_context_create();
-  pthread_t threads[num_threads];
-  thread_test_data_t thread_data[num_threads];
-
-  // Start threads
-  for (int i = 0; i < num_threads; i++) {
-    thread_data[i].context = context;
-    thread_data[i].thread_id = i;
-    thread_data[i].iterations = iterations;
-    thread_data[i].bytes_allocated = 0;
-
-    int result =
-        pthread_create(&threads[i], NULL, context_thread_test, &thread_data[i]);
-    assert(result == 0);
-  }
+  // Shared lock-free chain and per-thread shards
+  bebop_arena_mode_t modes[] = {BEBOP_ARENA_LOCK_FREE, BEBOP_ARENA_SHARDED};
+  for (size_t m = 0; m < sizeof(modes) / sizeof(modes[0]); m++) {
+    bebop_context_options_t options = bebop_context_default_options();
+    options.arena_options.mode = modes[m];
+    bebop_context_t *context = bebop_context_create_with_options(&options);
+    assert(context != NULL);
+    pthread_t threads[num_threads];
+    thread_test_data_t thread_data[num_threads];
+
+    // Start threads
+    for (int i = 0; i < num_threads; i++) {
+      thread_data[i].context = context;
+      thread_data[i].thread_id = i;
+      thread_data[i].iterations = iterations;
+      thread_data[i].bytes_allocated = 0;
+
+      int result = pthread_create(&threads[i], NULL, context_thread_test,
+                                  &thread_data[i]);
+      assert(result == 0);
+    }
 
-  // Wait for threads to complete
-  for (int i = 0; i < num_threads; i++) {
-    int result = pthread_join(threads[i], NULL);
-    assert(result == 0);
-    printf("  Thread %d allocated %zu bytes\n", i,
-           thread_data[i].bytes_allocated);
-  }
+    // Wait for threads to complete
+    size_t total_allocated = 0;
+    for (int i = 0; i < num_threads; i++) {
+      int result = pthread_join(threads[i], NULL);
+      assert(result == 0);
+      printf("  Thread %d allocated %zu bytes\n", i,
+             thread_data[i].bytes_allocated);
+      total_allocated += thread_data[i].bytes_allocated;
+    }
 
-  printf("  Total context space used: %zu bytes\n",
-         bebop_context_space_used(context));
-  printf("  Total context space allocated: %zu bytes\n",
-         bebop_context_space_allocated(context));
+    assert(bebop_context_space_used(context) >= total_allocated);
+    assert(bebop_context_space_allocated(context) >=
+           bebop_context_space_used(context));
+    printf("  Total context space used: %zu bytes\n",
+           bebop_context_space_used(context));
+    printf("  Total context space allocated: %zu bytes\n",
+           bebop_context_space_allocated(context));
+
+    bebop_context_reset(context);
+    assert(bebop_context_space_used(context) == 0);
+    bebop_context_destroy(context);
+  }
 
-  bebop_context_destroy(context);
   TEST_END("thread safety");
 }
 
@@ -1485,6 +1780,7 @@ int main(void) {
 
   test_version_and_constants();
   test_context();
+  test_arena_reuse();
   test_reader_writer_init();
   test_basic_types();
   test_strings_and_arrays();
@@ -1492,6 +1788,7 @@ int main(void) {
   test_date();
   test_reader_positioning();
   test_writer_buffer_management();
+  test_segmented_writer();
   test_message_length();
   test_length_prefix();
   test_utility_functions();